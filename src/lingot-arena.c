@@ -0,0 +1,75 @@
+/*
+ * lingot, a musical instrument tuner.
+ *
+ * Copyright (C) 2004-2019  Iban Cereijo.
+ * Copyright (C) 2004-2008  Jairo Chapela.
+
+ *
+ * This file is part of lingot.
+ *
+ * lingot is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * lingot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with lingot; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "lingot-arena.h"
+
+size_t lingot_arena_block_size(size_t size) {
+    return (size + LINGOT_CACHE_LINE_SIZE - 1)
+            & ~((size_t) LINGOT_CACHE_LINE_SIZE - 1);
+}
+
+int lingot_arena_new(LingotArena* arena, size_t size) {
+
+    void* memory = NULL;
+
+    arena->used = 0;
+    arena->size = lingot_arena_block_size(size);
+    if (posix_memalign(&memory, LINGOT_CACHE_LINE_SIZE,
+                       arena->size ? arena->size : LINGOT_CACHE_LINE_SIZE)) {
+        memory = NULL;
+        arena->size = 0;
+    }
+    arena->memory = memory;
+
+    return arena->memory != NULL;
+}
+
+void lingot_arena_destroy(LingotArena* arena) {
+    free(arena->memory);
+    arena->memory = NULL;
+    arena->size = 0;
+    arena->used = 0;
+}
+
+void* lingot_arena_alloc(LingotArena* arena, size_t size) {
+
+    const size_t block_size = lingot_arena_block_size(size);
+    void* result;
+
+    // the arena is sized up front, running out of it is a bug.
+    assert(arena->used + block_size <= arena->size);
+    if (arena->used + block_size > arena->size) {
+        return NULL;
+    }
+
+    result = arena->memory + arena->used;
+    arena->used += block_size;
+    memset(result, 0, size);
+
+    return result;
+}
@@ -0,0 +1,58 @@
+/*
+ * lingot, a musical instrument tuner.
+ *
+ * Copyright (C) 2004-2019  Iban Cereijo.
+ * Copyright (C) 2004-2008  Jairo Chapela.
+
+ *
+ * This file is part of lingot.
+ *
+ * lingot is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * lingot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with lingot; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LINGOT_ARENA_H
+#define LINGOT_ARENA_H
+
+/*
+ Memory arena.
+
+ A single cache line aligned block, sized up front, from which the buffers of
+ an analysis configuration are taken in order and released all at once.
+ Every buffer starts on its own cache line, so the buffers written by
+ different threads never share one.
+ */
+
+#include <stddef.h>
+
+#include "lingot-defs.h"
+
+typedef struct {
+    unsigned char* memory;
+    size_t size;
+    size_t used;
+} LingotArena;
+
+// space taken in an arena by a buffer of the given size.
+size_t lingot_arena_block_size(size_t size);
+
+// allocates an arena of the given size, which should be the sum of the block
+// sizes of the buffers to take from it. It returns 0 if there is no memory.
+int lingot_arena_new(LingotArena*, size_t size);
+void lingot_arena_destroy(LingotArena*);
+
+// takes a zeroed, aligned buffer from the arena.
+void* lingot_arena_alloc(LingotArena*, size_t size);
+
+#endif
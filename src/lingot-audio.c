@@ -113,6 +113,7 @@ void lingot_audio_new(LingotAudioHandler* result,
                       void *process_callback_arg) {
 
     result->audio_system = audio_system_index;
+    lingot_thread_settings_default(&result->thread_input_read_settings);
     LingotAudioSystemConnector* system = lingot_audio_system_get(audio_system_index);
     if (system && system->func_new) {
         system->func_new(result, device, sample_rate);
@@ -251,6 +252,11 @@ int lingot_audio_start(LingotAudioHandler* audio) {
     if (system) {
         if (system->func_start) {
             result = system->func_start(audio);
+            if ((result == 0)
+                    && lingot_thread_settings_requested(&audio->thread_input_read_settings)) {
+                lingot_msg_add_warning(
+                            _("The audio server runs its own capture thread, the capture thread settings are ignored"));
+            }
         } else {
             pthread_attr_init(&audio->thread_input_read_attr);
 
@@ -262,6 +268,9 @@ int lingot_audio_start(LingotAudioHandler* audio) {
             pthread_create(&audio->thread_input_read,
                            &audio->thread_input_read_attr,
                            lingot_audio_run_reading_thread, audio);
+            lingot_thread_apply(audio->thread_input_read,
+                                &audio->thread_input_read_settings,
+                                _("capture"));
             result = 0;
         }
     }
@@ -59,6 +59,9 @@ typedef struct {
     pthread_cond_t thread_input_read_cond;
     pthread_mutex_t thread_input_read_mutex;
 
+    // scheduling of the reading thread, not used by the self-driven systems.
+    LingotThreadSettings thread_input_read_settings;
+
     // indicates whether the audio thread is running
     int running;
 
@@ -0,0 +1,307 @@
+/*
+ * lingot, a musical instrument tuner.
+ *
+ * Copyright (C) 2004-2019  Iban Cereijo.
+ * Copyright (C) 2004-2008  Jairo Chapela.
+
+ *
+ * This file is part of lingot.
+ *
+ * lingot is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * lingot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with lingot; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "lingot-calibration.h"
+#include "lingot-core.h"
+#include "lingot-i18n.h"
+#include "lingot-msg.h"
+
+// candidate parameter sets. The FFT sizes start at the smallest one that
+// resolves the minimum frequency.
+static const unsigned int lingot_calibration_min_fft_size = 512;
+static const unsigned int lingot_calibration_fft_sizes = 4;
+static const FLT lingot_calibration_temporal_windows[] = { 0.3, 0.6, 1.0 };
+// divisors of the oversampling factor derived from the maximum frequency.
+static const unsigned int lingot_calibration_oversampling_divisors[] = { 1, 2,
+                                                                         4 };
+
+// number of test tones, spread over the configured frequency range.
+#define N_TONES 3
+
+// analysis passes measured for each tone, once the temporal buffer is full.
+static const unsigned int lingot_calibration_passes = 8;
+
+// errors closer than this are considered equivalent.
+static const FLT lingot_calibration_error_tolerance = 0.01; // cents
+
+// error assigned to the passes without estimation.
+static const FLT lingot_calibration_miss_error = 100.0; // cents
+
+static double lingot_calibration_cpu_time(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+    return t.tv_sec + 1e-9 * t.tv_nsec;
+}
+
+static void lingot_calibration_get_id(const LingotConfig* conf, char* id,
+                                      size_t size) {
+    char host[64];
+
+    if (gethostname(host, sizeof(host)) != 0) {
+        sprintf(host, "%s", "unknown");
+    }
+    host[sizeof(host) - 1] = '\0';
+
+    snprintf(id, size, "%s:%0.3f:%0.3f:%0.3f:%d", host,
+             conf->calibration_budget, conf->min_frequency,
+             conf->max_frequency, conf->sample_rate);
+}
+
+// runs the analysis on synthetic tones, giving the mean absolute error in
+// cents and the mean CPU time per pass in ms. Returns 0 if the analysis could
+// not be run.
+static int lingot_calibration_measure(const LingotConfig* conf, FLT* error,
+                                      FLT* cpu_time) {
+
+    LingotCore core;
+    unsigned int i, j, k;
+    unsigned int passes = 0;
+    FLT phase;
+    FLT noise_state = 1.0;
+    double t0;
+
+    // one block per analysis pass, as in the real pipeline.
+    const unsigned int block_size = (unsigned int) ceil(
+                conf->sample_rate / conf->calculation_rate);
+    const unsigned int fill_passes = (unsigned int) ceil(
+                conf->temporal_window * conf->calculation_rate);
+    FLT* block = malloc(block_size * sizeof(FLT));
+
+    *error = 0.0;
+    *cpu_time = 0.0;
+
+    for (k = 0; k < N_TONES; k++) {
+
+        // geometrically spread between the minimum and maximum frequencies.
+        const FLT f = conf->min_frequency
+                * pow(conf->max_frequency / conf->min_frequency,
+                      (k + 0.5) / N_TONES);
+        const FLT w = 2.0 * M_PI * f / conf->sample_rate;
+
+        if (!lingot_core_offline_new(&core, (LingotConfig*) conf, block_size)) {
+            free(block);
+            return 0;
+        }
+        phase = 0.0;
+
+        for (j = 0; j < fill_passes + lingot_calibration_passes; j++) {
+
+            // a few harmonics and some noise.
+            for (i = 0; i < block_size; i++) {
+                noise_state = fmod(noise_state * 16807.0, 2147483647.0);
+                block[i] = FLT_SAMPLE_SCALE
+                        * (0.5 * cos(phase) + 0.25 * cos(2.0 * phase)
+                           + 0.12 * cos(3.0 * phase)
+                           + 0.01 * (noise_state / 2147483647.0 - 0.5));
+                phase += w;
+            }
+            phase = fmod(phase, 2.0 * M_PI);
+
+            lingot_core_offline_feed(&core, block, block_size);
+
+            t0 = lingot_calibration_cpu_time();
+            lingot_core_offline_compute(&core);
+
+            if (j >= fill_passes) {
+                *cpu_time += lingot_calibration_cpu_time() - t0;
+                *error += (core.freq > 0.0) ?
+                            fabs(1200.0 * log2(core.freq / f)) :
+                            lingot_calibration_miss_error;
+                passes++;
+            }
+        }
+
+        lingot_core_offline_destroy(&core);
+    }
+
+    *error /= passes;
+    *cpu_time *= 1e3 / passes;
+
+    free(block);
+    return 1;
+}
+
+int lingot_calibration_is_due(const LingotConfig* conf) {
+
+    char id[sizeof(conf->calibration_id)];
+
+    if (conf->calibration_budget <= 0.0) {
+        return 0;
+    }
+
+    lingot_calibration_get_id(conf, id, sizeof(id));
+    return strcmp(id, conf->calibration_id) != 0;
+}
+
+int lingot_calibration_apply(LingotConfig* conf,
+                             const LingotConfig* calibrated) {
+
+    char id[sizeof(conf->calibration_id)];
+
+    if (conf->calibration_budget <= 0.0) {
+        return 0;
+    }
+
+    // the settings may have changed while calibrating.
+    lingot_calibration_get_id(conf, id, sizeof(id));
+    if (strcmp(id, calibrated->calibration_id)
+            || !strcmp(id, conf->calibration_id)) {
+        return 0;
+    }
+
+    conf->fft_size = calibrated->fft_size;
+    conf->temporal_window = calibrated->temporal_window;
+    conf->oversampling_limit = calibrated->oversampling_limit;
+    lingot_config_update_internal_params(conf);
+    snprintf(conf->calibration_id, sizeof(conf->calibration_id), "%s", id);
+
+    return 1;
+}
+
+int lingot_calibration_run(LingotConfig* conf) {
+
+    char id[sizeof(conf->calibration_id)];
+    char buff[1000];
+    unsigned int i, j, k;
+    unsigned int fft_size;
+    unsigned int oversampling_limit;
+    unsigned int previous_oversampling_limit;
+    LingotConfig candidate;
+    FLT error, cpu_time;
+    int found = 0;
+    int best_fits = 0;
+    FLT best_error = 0.0;
+    FLT best_cpu_time = 0.0;
+    unsigned int best_fft_size = conf->fft_size;
+    FLT best_temporal_window = conf->temporal_window;
+    unsigned int best_oversampling_limit = conf->oversampling_limit;
+
+    if (!lingot_calibration_is_due(conf)) {
+        return 0;
+    }
+
+    lingot_calibration_get_id(conf, id, sizeof(id));
+
+    // oversampling factor derived from the maximum frequency.
+    lingot_config_copy(&candidate, conf);
+    candidate.oversampling_limit = 0;
+    lingot_config_update_internal_params(&candidate);
+    const unsigned int max_oversampling = candidate.oversampling;
+    lingot_config_destroy(&candidate);
+
+    previous_oversampling_limit = 0;
+    for (k = 0;
+         k < sizeof(lingot_calibration_oversampling_divisors)
+         / sizeof(lingot_calibration_oversampling_divisors[0]); k++) {
+
+        // no limit for the derived factor itself.
+        oversampling_limit = (k == 0) ? 0 :
+                max_oversampling / lingot_calibration_oversampling_divisors[k];
+        if ((k > 0) && ((oversampling_limit == 0)
+                        || (oversampling_limit == previous_oversampling_limit)
+                        || (oversampling_limit == max_oversampling))) {
+            continue;
+        }
+        previous_oversampling_limit = oversampling_limit;
+
+        lingot_config_copy(&candidate, conf);
+        candidate.oversampling_limit = oversampling_limit;
+        lingot_config_update_internal_params(&candidate);
+        fft_size = lingot_config_get_min_fft_size(&candidate);
+        if (fft_size < lingot_calibration_min_fft_size) {
+            fft_size = lingot_calibration_min_fft_size;
+        }
+        lingot_config_destroy(&candidate);
+
+        for (i = 0; (i < lingot_calibration_fft_sizes)
+             && (fft_size <= LINGOT_CONFIG_MAX_FFT_SIZE); i++, fft_size <<= 1) {
+            for (j = 0;
+                 j < sizeof(lingot_calibration_temporal_windows)
+                 / sizeof(lingot_calibration_temporal_windows[0]); j++) {
+
+                lingot_config_copy(&candidate, conf);
+                candidate.fft_size = fft_size;
+                candidate.temporal_window = lingot_calibration_temporal_windows[j];
+                candidate.oversampling_limit = oversampling_limit;
+                lingot_config_update_internal_params(&candidate);
+
+                // the temporal buffer must hold an FFT frame.
+                if ((candidate.temporal_buffer_size >= candidate.fft_size)
+                        && lingot_calibration_measure(&candidate, &error, &cpu_time)) {
+
+                    int fits = (cpu_time <= conf->calibration_budget);
+
+                    // the most accurate set within the budget, or the cheapest
+                    // one if none fits.
+                    int better = !found || (fits && !best_fits);
+                    if (found && fits && best_fits) {
+                        better = (error < best_error - lingot_calibration_error_tolerance)
+                                || ((error < best_error + lingot_calibration_error_tolerance)
+                                    && (cpu_time < best_cpu_time));
+                    } else if (found && !fits && !best_fits) {
+                        better = (cpu_time < best_cpu_time);
+                    }
+
+                    if (better) {
+                        found = 1;
+                        best_fits = fits;
+                        best_error = error;
+                        best_cpu_time = cpu_time;
+                        best_fft_size = candidate.fft_size;
+                        best_temporal_window = candidate.temporal_window;
+                        best_oversampling_limit = oversampling_limit;
+                    }
+                }
+
+                lingot_config_destroy(&candidate);
+            }
+        }
+    }
+
+    // no candidate could be measured.
+    if (!found) {
+        return 0;
+    }
+
+    snprintf(buff, sizeof(buff),
+             _("Calibrated analysis parameters: FFT size %u, temporal window %0.3f s, oversampling limit %u (%0.3f cents, %0.3f ms per pass)"),
+             best_fft_size, best_temporal_window, best_oversampling_limit,
+             best_error, best_cpu_time);
+    lingot_msg_add_info(buff);
+
+    conf->fft_size = best_fft_size;
+    conf->temporal_window = best_temporal_window;
+    conf->oversampling_limit = best_oversampling_limit;
+    lingot_config_update_internal_params(conf);
+    snprintf(conf->calibration_id, sizeof(conf->calibration_id), "%s", id);
+
+    return 1;
+}
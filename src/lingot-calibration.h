@@ -0,0 +1,52 @@
+/*
+ * lingot, a musical instrument tuner.
+ *
+ * Copyright (C) 2004-2019  Iban Cereijo.
+ * Copyright (C) 2004-2008  Jairo Chapela.
+
+ *
+ * This file is part of lingot.
+ *
+ * lingot is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * lingot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with lingot; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LINGOT_CALIBRATION_H
+#define LINGOT_CALIBRATION_H
+
+/*
+ Calibration of the internal analysis parameters against a CPU budget.
+ */
+
+#include "lingot-config.h"
+
+// returns 1 if the calibration is enabled and the configuration has not been
+// calibrated yet for this host and settings.
+int lingot_calibration_is_due(const LingotConfig* conf);
+
+// chooses the FFT size, temporal window and oversampling limit that give the
+// most accurate estimations within the CPU budget per analysis pass, by
+// running the analysis pipeline on synthetic tones. It takes a while, so it is
+// meant to be run on a copy of the configuration outside the GUI thread.
+// Nothing is done if the calibration is not due. Returns 1 if the
+// configuration has been changed.
+int lingot_calibration_run(LingotConfig* conf);
+
+// copies the parameters chosen by a calibration run into conf, if it still
+// has the settings they were calibrated for. Returns 1 if conf has been
+// changed.
+int lingot_calibration_apply(LingotConfig* conf,
+                             const LingotConfig* calibrated);
+
+#endif
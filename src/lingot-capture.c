@@ -0,0 +1,346 @@
+/*
+ * lingot, a musical instrument tuner.
+ *
+ * Copyright (C) 2004-2019  Iban Cereijo.
+ * Copyright (C) 2004-2008  Jairo Chapela.
+
+ *
+ * This file is part of lingot.
+ *
+ * lingot is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * lingot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with lingot; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "lingot-capture.h"
+#include "lingot-i18n.h"
+#include "lingot-msg.h"
+
+enum {
+    CAPTURE_RECORD_RAW = 0,
+    CAPTURE_RECORD_DECIMATED = 1,
+    CAPTURE_RECORD_FRAME = 2,
+};
+
+// a few seconds of raw input, so that the writer can be delayed by the disk.
+static const unsigned int capture_audio_ring_size = 1 << 21; // bytes
+static const unsigned int capture_frame_ring_size = 1 << 16; // bytes
+
+// the writer sleeps this time when there is nothing to write, and it updates
+// the WAV headers once per this number of wake ups, so that the files are
+// readable even if lingot does not exit cleanly.
+static const long capture_writer_period = 20000000; // ns
+static const unsigned int capture_header_update_period = 50;
+
+static void lingot_capture_put_u16(unsigned char* p, unsigned int value) {
+    p[0] = (unsigned char) (value & 0xff);
+    p[1] = (unsigned char) ((value >> 8) & 0xff);
+}
+
+static void lingot_capture_put_u32(unsigned char* p, unsigned long value) {
+    lingot_capture_put_u16(p, value & 0xffff);
+    lingot_capture_put_u16(p + 2, (value >> 16) & 0xffff);
+}
+
+// writes the header of a mono, 32 bit float WAV file with the given number
+// of samples, at the beginning of the file.
+static void lingot_capture_write_wav_header(FILE* fp, unsigned int sample_rate,
+                                            unsigned long samples) {
+    unsigned char header[44];
+    const unsigned long data_size = 4 * samples;
+
+    memcpy(header, "RIFF", 4);
+    lingot_capture_put_u32(header + 4, 36 + data_size);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    lingot_capture_put_u32(header + 16, 16);
+    lingot_capture_put_u16(header + 20, 3); // IEEE float
+    lingot_capture_put_u16(header + 22, 1); // channels
+    lingot_capture_put_u32(header + 24, sample_rate);
+    lingot_capture_put_u32(header + 28, 4 * sample_rate); // bytes per second
+    lingot_capture_put_u16(header + 32, 4); // block align
+    lingot_capture_put_u16(header + 34, 32); // bits per sample
+    memcpy(header + 36, "data", 4);
+    lingot_capture_put_u32(header + 40, data_size);
+
+    long position = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    fwrite(header, sizeof(header), 1, fp);
+    if (position > (long) sizeof(header)) {
+        fseek(fp, position, SEEK_SET);
+    }
+}
+
+static void lingot_capture_update_wav_headers(LingotCapture* capture) {
+    lingot_capture_write_wav_header(capture->raw_file, capture->raw_sample_rate,
+                                    capture->raw_samples);
+    lingot_capture_write_wav_header(capture->decimated_file,
+                                    capture->decimated_sample_rate,
+                                    capture->decimated_samples);
+    fflush(capture->raw_file);
+    fflush(capture->decimated_file);
+    fflush(capture->frame_file);
+}
+
+// writes the pending records, returns the number of records written.
+static unsigned int lingot_capture_drain(LingotCapture* capture, float* buffer,
+                                         unsigned int buffer_size) {
+    unsigned int records = 0;
+    unsigned int type;
+    int length;
+
+    while ((length = lingot_ring_read(&capture->audio_ring, &type, buffer,
+                                      buffer_size)) >= 0) {
+        const unsigned int n = (unsigned int) length / sizeof(float);
+        if (type == CAPTURE_RECORD_RAW) {
+            capture->raw_samples += fwrite(buffer, sizeof(float), n, capture->raw_file);
+        } else {
+            capture->decimated_samples += fwrite(buffer, sizeof(float), n,
+                                                 capture->decimated_file);
+        }
+        records++;
+    }
+
+    while ((length = lingot_ring_read(&capture->frame_ring, &type, buffer,
+                                      buffer_size)) >= 0) {
+        fwrite(buffer, sizeof(LingotCaptureFrame), 1, capture->frame_file);
+        records++;
+    }
+
+    return records;
+}
+
+static void* lingot_capture_run_writer_thread(void* arg) {
+    LingotCapture* capture = arg;
+    const unsigned int buffer_size = capture->audio_scratch_size * sizeof(float);
+    float* buffer = malloc(buffer_size);
+    const struct timespec period = { 0, capture_writer_period };
+    unsigned int wake_ups = 0;
+
+    for (;;) {
+        const int running = __atomic_load_n(&capture->running, __ATOMIC_ACQUIRE);
+
+        if (!lingot_capture_drain(capture, buffer, buffer_size)) {
+            if (!running) {
+                break;
+            }
+            nanosleep(&period, NULL);
+        }
+
+        if (++wake_ups >= capture_header_update_period) {
+            wake_ups = 0;
+            lingot_capture_update_wav_headers(capture);
+        }
+    }
+
+    free(buffer);
+    return NULL;
+}
+
+// maximum number of names tried when the files of another capture started
+// within the same second already exist.
+static const unsigned int capture_max_names = 100;
+
+static void lingot_capture_file_name(char* filename, size_t size, const char* prefix,
+                                     const char* stamp, unsigned int attempt,
+                                     const char* suffix) {
+    if (attempt) {
+        snprintf(filename, size, "%s-%s-%u-%s", prefix, stamp, attempt, suffix);
+    } else {
+        snprintf(filename, size, "%s-%s-%s", prefix, stamp, suffix);
+    }
+}
+
+// creates the given file, failing with EEXIST if it is already there, so
+// that the files of another capture are never truncated.
+static FILE* lingot_capture_create(const char* filename) {
+    const int fd = open(filename, O_RDWR | O_CREAT | O_EXCL, 0644);
+    FILE* fp;
+
+    if (fd < 0) {
+        return NULL;
+    }
+
+    fp = fdopen(fd, "w+b");
+    if (!fp) {
+        close(fd);
+        remove(filename);
+    }
+    return fp;
+}
+
+// creates the three capture files under the first name not in use, returns
+// 0 on failure.
+static int lingot_capture_open(LingotCapture* capture, const char* prefix,
+                               const char* stamp) {
+    static const char* const suffixes[] = { "raw.wav", "decimated.wav", "frames.bin" };
+    FILE** const files[] = { &capture->raw_file, &capture->decimated_file,
+                             &capture->frame_file };
+    char filename[1000];
+    unsigned int attempt, i;
+
+    for (attempt = 0; attempt < capture_max_names; attempt++) {
+        for (i = 0; i < 3; i++) {
+            lingot_capture_file_name(filename, sizeof(filename), prefix, stamp,
+                                     attempt, suffixes[i]);
+            *files[i] = lingot_capture_create(filename);
+            if (!*files[i]) {
+                break;
+            }
+        }
+
+        if (i == 3) {
+            return 1;
+        }
+
+        const int error = errno;
+        while (i-- > 0) {
+            fclose(*files[i]);
+            *files[i] = NULL;
+            lingot_capture_file_name(filename, sizeof(filename), prefix, stamp,
+                                     attempt, suffixes[i]);
+            remove(filename);
+        }
+
+        if (error != EEXIST) {
+            break;
+        }
+    }
+
+    return 0;
+}
+
+LingotCapture* lingot_capture_new(const char* prefix, unsigned int sample_rate,
+                                  unsigned int oversampling, unsigned int block_size) {
+    LingotCapture* capture = malloc(sizeof(LingotCapture));
+    LingotCaptureFrameLogHeader frame_header;
+    char stamp[100];
+    time_t now = time(NULL);
+    struct tm tm_now;
+
+    memset(capture, 0, sizeof(*capture));
+
+    localtime_r(&now, &tm_now);
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &tm_now);
+
+    capture->audio_scratch_size = block_size;
+    capture->audio_scratch = malloc(block_size * sizeof(float));
+
+    if (!capture->audio_scratch || !lingot_capture_open(capture, prefix, stamp)
+            || !lingot_ring_new(&capture->audio_ring, capture_audio_ring_size)
+            || !lingot_ring_new(&capture->frame_ring, capture_frame_ring_size)) {
+        if (capture->raw_file) {
+            fclose(capture->raw_file);
+        }
+        if (capture->decimated_file) {
+            fclose(capture->decimated_file);
+        }
+        if (capture->frame_file) {
+            fclose(capture->frame_file);
+        }
+        lingot_ring_destroy(&capture->audio_ring);
+        lingot_ring_destroy(&capture->frame_ring);
+        free(capture->audio_scratch);
+        free(capture);
+        return NULL;
+    }
+
+    capture->raw_sample_rate = sample_rate;
+    capture->decimated_sample_rate = (unsigned int) lround(1.0 * sample_rate / oversampling);
+    lingot_capture_write_wav_header(capture->raw_file, capture->raw_sample_rate, 0);
+    lingot_capture_write_wav_header(capture->decimated_file,
+                                    capture->decimated_sample_rate, 0);
+
+    memset(&frame_header, 0, sizeof(frame_header));
+    memcpy(frame_header.magic, "LNGTFRM1", sizeof(frame_header.magic));
+    frame_header.sample_rate = 1.0 * sample_rate / oversampling;
+    frame_header.frame_size = sizeof(LingotCaptureFrame);
+    fwrite(&frame_header, sizeof(frame_header), 1, capture->frame_file);
+
+    capture->running = 1;
+    if (pthread_create(&capture->writer_thread, NULL,
+                       lingot_capture_run_writer_thread, capture)) {
+        capture->running = 0;
+        lingot_capture_destroy(capture);
+        return NULL;
+    }
+
+    return capture;
+}
+
+void lingot_capture_destroy(LingotCapture* capture) {
+    unsigned long dropped;
+    char buff[100];
+
+    if (__atomic_exchange_n(&capture->running, 0, __ATOMIC_ACQ_REL)) {
+        pthread_join(capture->writer_thread, NULL);
+    }
+
+    dropped = lingot_ring_get_dropped(&capture->audio_ring)
+            + lingot_ring_get_dropped(&capture->frame_ring);
+    if (dropped) {
+        snprintf(buff, sizeof(buff), _("%lu capture blocks have been dropped"), dropped);
+        lingot_msg_add_warning(buff);
+    }
+
+    lingot_capture_update_wav_headers(capture);
+    fclose(capture->raw_file);
+    fclose(capture->decimated_file);
+    fclose(capture->frame_file);
+
+    lingot_ring_destroy(&capture->audio_ring);
+    lingot_ring_destroy(&capture->frame_ring);
+    free(capture->audio_scratch);
+    free(capture);
+}
+
+static void lingot_capture_push_samples(LingotCapture* capture, unsigned int type,
+                                        const FLT* samples, unsigned int n) {
+    // normalized to the full scale of the 16 bit input
+    static const float scale = 1.0f / 32768.0f;
+    unsigned int i;
+
+    if (n > capture->audio_scratch_size) {
+        n = capture->audio_scratch_size;
+    }
+
+    for (i = 0; i < n; i++) {
+        capture->audio_scratch[i] = (float) samples[i] * scale;
+    }
+
+    lingot_ring_write(&capture->audio_ring, type, capture->audio_scratch,
+                      n * sizeof(float));
+}
+
+void lingot_capture_push_raw(LingotCapture* capture, const FLT* samples,
+                             unsigned int n) {
+    lingot_capture_push_samples(capture, CAPTURE_RECORD_RAW, samples, n);
+}
+
+void lingot_capture_push_decimated(LingotCapture* capture, const FLT* samples,
+                                   unsigned int n) {
+    lingot_capture_push_samples(capture, CAPTURE_RECORD_DECIMATED, samples, n);
+}
+
+void lingot_capture_push_frame(LingotCapture* capture,
+                               const LingotCaptureFrame* frame) {
+    lingot_ring_write(&capture->frame_ring, CAPTURE_RECORD_FRAME, frame,
+                      sizeof(*frame));
+}
@@ -0,0 +1,102 @@
+/*
+ * lingot, a musical instrument tuner.
+ *
+ * Copyright (C) 2004-2019  Iban Cereijo.
+ * Copyright (C) 2004-2008  Jairo Chapela.
+
+ *
+ * This file is part of lingot.
+ *
+ * lingot is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * lingot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with lingot; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LINGOT_CAPTURE_H
+#define LINGOT_CAPTURE_H
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "lingot-defs.h"
+#include "lingot-ring.h"
+
+/*
+ * Capture of the tuner input and results for offline inspection. The audio
+ * and analysis threads push the raw input, the decimated signal and the
+ * estimation of each analysis pass into lock-free rings, and a background
+ * thread writes them to disk:
+ *
+ *   <prefix>-raw.wav        raw input, 32 bit float, at the sample rate.
+ *   <prefix>-decimated.wav  decimated signal, 32 bit float.
+ *   <prefix>-frames.bin     a LingotCaptureFrameLogHeader followed by one
+ *                           LingotCaptureFrame per analysis pass, in the
+ *                           host byte order.
+ *
+ * The WAV files are normalized to the full scale. When the disk cannot keep
+ * up, whole blocks are dropped; the positions in the frame log allow to
+ * detect them.
+ */
+
+typedef struct {
+    char magic[8]; // "LNGTFRM1"
+    double sample_rate; // rate of the decimated signal
+    uint32_t frame_size; // size of each frame record
+    uint32_t reserved;
+} LingotCaptureFrameLogHeader;
+
+typedef struct {
+    uint64_t sample_position; // decimated samples received before the pass
+    double frequency; // estimated frequency, 0 if none
+    uint32_t sequence; // analysis pass number
+    uint32_t signal_present; // 0 while the silence gate is closed
+} LingotCaptureFrame;
+
+typedef struct {
+    LingotRing audio_ring; // written by the audio thread
+    LingotRing frame_ring; // written by the analysis thread
+
+    float* audio_scratch; // conversion buffer of the audio thread
+    unsigned int audio_scratch_size;
+
+    FILE* raw_file;
+    FILE* decimated_file;
+    FILE* frame_file;
+    unsigned int raw_sample_rate;
+    unsigned int decimated_sample_rate;
+    unsigned long raw_samples; // samples written to each WAV file
+    unsigned long decimated_samples;
+
+    pthread_t writer_thread;
+    int running;
+} LingotCapture;
+
+// creates the capture files, named after the given prefix and the current
+// time, followed by a counter if files with those names already exist, and
+// starts the writer. The block size is the maximum number of
+// samples pushed at once. Returns NULL on failure.
+LingotCapture* lingot_capture_new(const char* prefix, unsigned int sample_rate,
+                                  unsigned int oversampling, unsigned int block_size);
+
+// stops the writer after flushing the pending data and closes the files.
+void lingot_capture_destroy(LingotCapture*);
+
+// pushes samples, only from the audio thread.
+void lingot_capture_push_raw(LingotCapture*, const FLT* samples, unsigned int n);
+void lingot_capture_push_decimated(LingotCapture*, const FLT* samples, unsigned int n);
+
+// pushes the results of an analysis pass, only from the analysis thread.
+void lingot_capture_push_frame(LingotCapture*, const LingotCaptureFrame* frame);
+
+#endif // LINGOT_CAPTURE_H
@@ -40,6 +40,8 @@ void lingot_config_scale_new(LingotScale* scale) {
     scale->offset_ratios[0] = NULL;
     scale->offset_ratios[1] = NULL;
     scale->base_frequency = 0.0;
+    scale->note_boundary = NULL;
+    scale->note_frequency = NULL;
 }
 
 void lingot_config_scale_allocate(LingotScale* scale, unsigned short int notes) {
@@ -52,6 +54,8 @@ void lingot_config_scale_allocate(LingotScale* scale, unsigned short int notes)
     scale->offset_cents = malloc(notes * sizeof(FLT));
     scale->offset_ratios[0] = malloc(notes * sizeof(short int));
     scale->offset_ratios[1] = malloc(notes * sizeof(short int));
+    scale->note_boundary = malloc(notes * sizeof(FLT));
+    scale->note_frequency = malloc(notes * sizeof(FLT));
 }
 
 void lingot_config_scale_destroy(LingotScale* scale) {
@@ -66,6 +70,8 @@ void lingot_config_scale_destroy(LingotScale* scale) {
     free(scale->offset_ratios[1]);
     free(scale->note_name);
     free(scale->name);
+    free(scale->note_boundary);
+    free(scale->note_frequency);
 
     scale->name = NULL;
     scale->notes = 0;
@@ -74,6 +80,8 @@ void lingot_config_scale_destroy(LingotScale* scale) {
     scale->offset_ratios[0] = NULL;
     scale->offset_ratios[1] = NULL;
     scale->base_frequency = 0.0;
+    scale->note_boundary = NULL;
+    scale->note_frequency = NULL;
 }
 
 void lingot_config_scale_restore_default_values(LingotScale* scale) {
@@ -103,6 +111,8 @@ void lingot_config_scale_restore_default_values(LingotScale* scale) {
         scale->offset_ratios[0][i] = -1; // not used
         scale->offset_ratios[1][i] = -1; // not used
     }
+
+    lingot_config_scale_update_index(scale);
 }
 
 void lingot_config_scale_copy(LingotScale* dst, const LingotScale* src) {
@@ -121,6 +131,24 @@ void lingot_config_scale_copy(LingotScale* dst, const LingotScale* src) {
         dst->offset_ratios[0][i] = src->offset_ratios[0][i];
         dst->offset_ratios[1][i] = src->offset_ratios[1][i];
     }
+
+    lingot_config_scale_update_index(dst);
+}
+
+void lingot_config_scale_update_index(LingotScale* scale) {
+    unsigned short int i;
+
+    // the notes are well ordered, so each note captures the frequencies up to
+    // the middle point with the next one, which is the first note of the next
+    // octave for the last note.
+    for (i = 0; i < scale->notes; i++) {
+        FLT next = ((i + 1) < scale->notes) ?
+                    scale->offset_cents[i + 1] :
+                    scale->offset_cents[0] + 1200.0;
+        scale->note_boundary[i] = 0.5 * (scale->offset_cents[i] + next);
+        scale->note_frequency[i] = scale->base_frequency
+                * pow(2.0, scale->offset_cents[i] / 1200.0);
+    }
 }
 
 int lingot_config_scale_get_octave(const LingotScale* scale, int index) {
@@ -140,66 +168,46 @@ FLT lingot_config_scale_get_absolute_offset(const LingotScale* scale, int index)
 }
 
 FLT lingot_config_scale_get_frequency(const LingotScale* scale, int index) {
-    return scale->base_frequency
-            * pow(2.0,
-                  lingot_config_scale_get_absolute_offset(scale, index)
-                  / 1200.0);
+    return ldexp(scale->note_frequency[lingot_config_scale_get_note_index(scale, index)],
+                 lingot_config_scale_get_octave(scale, index));
 }
 
 int lingot_config_scale_get_closest_note_index(const LingotScale* scale,
                                                FLT freq, FLT deviation, FLT* error_cents) {
 
-    short note_index = 0;
-    short int index;
-
     FLT offset = 1200.0 * log2(freq / scale->base_frequency) - deviation;
-    int octave = 0;
-    octave = floor(offset / 1200);
-    offset = fmod(offset, 1200.0);
-    if (offset < 0.0) {
-        offset += 1200.0;
-    }
-
-    index = floor(scale->notes * offset / 1200.0);
-
-    // TODO: bisection?, avoid loop?
-    FLT pitch_inf;
-    FLT pitch_sup;
-    int n = 0;
-    for (;;) {
-        n++;
-        pitch_inf = scale->offset_cents[index];
-        pitch_sup =
-                ((index + 1) < scale->notes) ?
-                    scale->offset_cents[index + 1] : 1200.0;
-
-        if (offset > pitch_sup) {
-            index++;
-            continue;
+    int octave = floor(offset / 1200.0);
+    offset -= 1200.0 * octave;
+
+    // first note whose upper boundary is above the offset
+    int low = 0;
+    int high = scale->notes;
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (scale->note_boundary[middle] <= offset) {
+            low = middle + 1;
+        } else {
+            high = middle;
         }
-
-        if (offset < pitch_inf) {
-            index--;
-            continue;
-        }
-
-        break;
-    };
-
-    if (fabs(offset - pitch_inf) < fabs(offset - pitch_sup)) {
-        note_index = index;
-        *error_cents = offset - pitch_inf;
-    } else {
-        note_index = index + 1;
-        *error_cents = offset - pitch_sup;
     }
 
+    int note_index = low;
+    FLT pitch;
     if (note_index == scale->notes) {
         note_index = 0;
         octave++;
+        pitch = scale->offset_cents[0] + 1200.0;
+    } else if ((note_index == 0)
+               && (offset < scale->note_boundary[scale->notes - 1] - 1200.0)) {
+        // only possible when the first note is not at 0 cents
+        note_index = scale->notes - 1;
+        octave--;
+        pitch = scale->offset_cents[note_index] - 1200.0;
+    } else {
+        pitch = scale->offset_cents[note_index];
     }
 
-    note_index += octave * scale->notes;
+    *error_cents = offset - pitch;
 
-    return note_index;
+    return note_index + octave * scale->notes;
 }
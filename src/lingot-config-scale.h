@@ -38,6 +38,8 @@ typedef struct {
     // -- internal parameters --
 
     FLT max_offset_rounded; 		// round version of maximum offset in cents
+    FLT* note_boundary;				// upper limit in cents of the range of each note
+    FLT* note_frequency;			// frequency of each note in the base octave
 } LingotScale;
 
 void lingot_config_scale_new(LingotScale*);
@@ -49,6 +51,10 @@ void lingot_config_scale_copy(LingotScale* dst, const LingotScale* src);
 
 void lingot_config_scale_restore_default_values(LingotScale* scale);
 
+// Rebuilds the lookup index of the scale. It must be called whenever the
+// offsets or the base frequency of the scale are modified.
+void lingot_config_scale_update_index(LingotScale* scale);
+
 // Gets the note index within the range [0, num notes)
 int lingot_config_scale_get_note_index(const LingotScale* scale, int index);
 
@@ -63,7 +69,8 @@ int lingot_config_scale_get_octave(const LingotScale* scale, int index);
 // we need to pass -36 here as note index
 FLT lingot_config_scale_get_frequency(const LingotScale* scale, int index);
 
-
+// Gets the index of the note closest to the given frequency, with a binary
+// search over the note boundaries.
 int lingot_config_scale_get_closest_note_index(const LingotScale* scale,
                                                FLT freq, FLT deviation, FLT* error_cents);
 
@@ -86,6 +86,19 @@ void lingot_config_restore_default_values(LingotConfig* config) {
     config->min_frequency = 82.407; // Hz (E2)
     config->max_frequency = 329.6276; // Hz (E4)
     config->optimize_internal_parameters = 0;
+    config->narrowband_tracking = 0;
+    config->incremental_spectrum = 0;
+    config->frequency_refinement = NEWTON_RAPHSON;
+    config->silence_threshold = -90.0; // dBFS
+    config->oversampling_limit = 0;
+    config->calibration_budget = 0.0; // ms
+    sprintf(config->calibration_id, "%s", "none");
+    sprintf(config->capture_prefix, "%s", "none");
+    sprintf(config->telemetry_socket, "%s", "none");
+    config->polyphony = 1;
+    config->strobe_harmonics = 4;
+    lingot_thread_settings_default(&config->capture_thread);
+    lingot_thread_settings_default(&config->analysis_thread);
 
     config->fft_size = 512; // samples
     config->temporal_window = 0.3; // seconds
@@ -104,6 +117,23 @@ void lingot_config_restore_default_values(LingotConfig* config) {
 
 //----------------------------------------------------------------------------
 
+unsigned int lingot_config_get_min_fft_size(const LingotConfig* config) {
+
+    // the lowest frequency must lie a few bins above DC, which takes large
+    // transforms for low notes, or for wide bands that are barely decimated.
+    static const FLT min_frequency_bins = 12.0;
+    const FLT decimated_rate = 1.0 * config->sample_rate / config->oversampling;
+    unsigned int fft_size = LINGOT_CONFIG_MIN_FFT_SIZE;
+    while ((fft_size < LINGOT_CONFIG_MAX_FFT_SIZE)
+           && (config->internal_min_frequency > 0.0)
+           && (fft_size * config->internal_min_frequency
+               < min_frequency_bins * decimated_rate)) {
+        fft_size <<= 1;
+    }
+
+    return fft_size;
+}
+
 void lingot_config_update_internal_params(LingotConfig* config) {
 
     // derived parameters.
@@ -122,6 +152,10 @@ void lingot_config_update_internal_params(LingotConfig* config) {
     }
 
     config->oversampling = floor(0.5 * config->sample_rate / config->internal_max_frequency);
+    if ((config->oversampling_limit > 0)
+            && (config->oversampling > config->oversampling_limit)) {
+        config->oversampling = config->oversampling_limit;
+    }
     if (config->oversampling < 1) {
         config->oversampling = 1;
     }
@@ -131,12 +165,21 @@ void lingot_config_update_internal_params(LingotConfig* config) {
     if (config->internal_max_frequency > 5000) {
         fft_size = 1024;
     }
-    FLT temporal_window = 1.0 * config->fft_size * config->oversampling
+
+    const unsigned int min_fft_size = lingot_config_get_min_fft_size(config);
+    if (fft_size < min_fft_size) {
+        fft_size = min_fft_size;
+    }
+
+    FLT temporal_window = 1.0 * fft_size * config->oversampling
             / config->sample_rate;
     if (temporal_window < 0.3) {
         temporal_window = 0.3;
     }
-    if (config->optimize_internal_parameters) {
+    if (config->calibration_budget > 0.0) {
+        // the governed parameters are chosen by the calibration, the flag is
+        // kept for when it gets disabled.
+    } else if (config->optimize_internal_parameters) {
         config->fft_size = fft_size;
         config->temporal_window = temporal_window;
     } else {
@@ -152,6 +195,8 @@ void lingot_config_update_internal_params(LingotConfig* config) {
     config->min_SNR = 0.5 * config->min_overall_SNR;
     config->peak_half_width = (config->fft_size > 256) ? 2 : 1;
 
+    lingot_config_scale_update_index(&config->scale);
+
     if (config->scale.notes == 1) {
         config->scale.max_offset_rounded = 1200.0;
     } else {
@@ -27,6 +27,7 @@
 
 #include "lingot-defs.h"
 #include "lingot-config-scale.h"
+#include "lingot-thread.h"
 
 typedef enum window_type_t {
     NONE = 0, //
@@ -34,8 +35,17 @@ typedef enum window_type_t {
     HAMMING = 2
 } window_type_t;
 
+typedef enum frequency_refinement_t {
+    NEWTON_RAPHSON = 0, //
+    PHASE_VOCODER = 1
+} frequency_refinement_t;
+
 #define N_MAX_AUDIO_DEV 10
 
+// range of the FFT size, which must be a power of two.
+#define LINGOT_CONFIG_MIN_FFT_SIZE 256
+#define LINGOT_CONFIG_MAX_FFT_SIZE 65536
+
 // Configuration struct. Determines the behaviour of the tuner.
 // Some parameters are internal only.
 typedef struct {
@@ -46,6 +56,10 @@ typedef struct {
     int sample_rate; // hardware sample rate.
     unsigned int oversampling; // oversampling factor.
 
+    // upper limit of the oversampling factor derived from the maximum
+    // frequency, 0 for no limit.
+    unsigned int oversampling_limit;
+
     FLT root_frequency_error; // deviation of the above root frequency.
 
     FLT min_frequency; // minimum frequency of the instrument.
@@ -53,6 +67,47 @@ typedef struct {
 
     int optimize_internal_parameters;
 
+    // follow the locked frequency with a cheap narrowband estimator instead of
+    // performing the full search in every pass.
+    int narrowband_tracking;
+
+    // update the spectrum with a sliding DFT instead of a fresh FFT when only
+    // a few samples have arrived since the previous pass.
+    int incremental_spectrum;
+
+    // frequency refinement method (frequency_refinement_t).
+    int frequency_refinement;
+
+    // input level below which the analysis slows down, -200 disables it.
+    FLT silence_threshold; // dBFS
+
+    // CPU time budget per analysis pass for the startup calibration of the
+    // FFT size and temporal window, 0 disables the calibration.
+    FLT calibration_budget; // ms
+
+    // host and settings the current parameters were calibrated for.
+    char calibration_id[256];
+
+    // prefix of the capture files of the input and the results, "none"
+    // disables the capture.
+    char capture_prefix[256];
+
+    // path of the UNIX domain socket where the results are streamed, "none"
+    // disables the stream.
+    char telemetry_socket[256];
+
+    // maximum number of simultaneous notes searched in the spectrum, 1 for
+    // the usual monophonic tuning.
+    unsigned int polyphony;
+
+    // harmonics followed by the strobe stage, 0 disables it.
+    unsigned int strobe_harmonics;
+
+    // scheduling policy, priority and CPU affinity of the audio capture
+    // thread and of the analysis thread.
+    LingotThreadSettings capture_thread;
+    LingotThreadSettings analysis_thread;
+
     FLT internal_min_frequency; // minimum valid frequency.
     FLT internal_max_frequency; // maximum frequency we want to tune.
 
@@ -105,4 +160,8 @@ void lingot_config_restore_default_values(LingotConfig*);
 // derivate internal parameters from external ones.
 void lingot_config_update_internal_params(LingotConfig*);
 
+// smallest FFT size that resolves the internal minimum frequency with the
+// current oversampling.
+unsigned int lingot_config_get_min_fft_size(const LingotConfig*);
+
 #endif // LINGOT_CONFIG_H
@@ -27,6 +27,7 @@
 #include <string.h>
 #include <errno.h>
 #include <sys/time.h>
+#include <time.h>
 #include <stdlib.h>
 #include "lingot-fft.h"
 #include "lingot-signal.h"
@@ -34,17 +35,422 @@
 #include "lingot-config.h"
 #include "lingot-i18n.h"
 #include "lingot-msg.h"
+#include "lingot-tracker.h"
 
 void lingot_core_read_callback(FLT* read_buffer, unsigned int samples_read, void *arg);
 
 void* lingot_core_run_computation_thread(void* core);
 
-static unsigned int decimation_input_index = 0;
+void lingot_core_compute_fundamental_fequency(LingotCore* core);
 
-void lingot_core_new(LingotCore* core, LingotConfig* conf) {
+static void lingot_core_frequency_locker_reset(LingotCoreFrequencyLocker* locker);
+
+// the sliding DFT is resynchronized with a fresh FFT after sliding over this
+// number of windows, in order to bound the accumulated rounding error.
+static const unsigned int sliding_dft_resync_windows = 8;
+
+// analysis rate while the input is silent.
+static const FLT idle_calculation_rate = 1.0; // Hz
+
+// the silence gate closes once the level has been below the threshold minus
+// this hysteresis for the hangover time.
+static const FLT silence_gate_hysteresis = 3.0; // dB
+static const FLT silence_gate_hangover = 0.5; // seconds
+static const FLT silence_gate_period = 0.01; // seconds between evaluations
+
+// while tracking, a full search is still done every this number of passes, in
+// order to refresh the spectrum and validate the lock.
+static const unsigned int tracker_full_search_period = 4;
+
+// maximum relative deviation of a note from the one found in the previous
+// pass to consider that it is the same voice.
+static const FLT voice_match_tolerance = 0.03;
+
+// passes kept for the reader in the spectrum ring.
+static const unsigned int spectrum_ring_passes = 16;
+
+// ensures that the temporal buffer can hold an FFT frame. Returns whether
+// the configuration has been changed.
+static int lingot_core_check_temporal_buffer(LingotConfig* conf) {
 
     char buff[1000];
 
+    if (conf->temporal_buffer_size < conf->fft_size) {
+        conf->temporal_window = ((double) conf->fft_size
+                                 * conf->oversampling) / conf->sample_rate;
+        conf->temporal_buffer_size = conf->fft_size;
+        snprintf(buff, sizeof(buff),
+                 _("The temporal buffer is smaller than FFT size. It has been increased to %0.3f seconds"),
+                 conf->temporal_window);
+        lingot_msg_add_warning(buff);
+        return 1;
+    }
+
+    return 0;
+}
+
+// order of the antialiasing filter.
+static const unsigned int antialiasing_filter_order = 8;
+
+// arena space taken by the analysis buffers of the given configuration.
+static size_t lingot_core_dsp_arena_size(const LingotConfig* conf) {
+
+    const size_t spd_block = lingot_arena_block_size((conf->fft_size / 2) * sizeof(FLT));
+    const size_t temporal_block = lingot_arena_block_size(
+                conf->temporal_buffer_size * sizeof(FLT));
+    const size_t fft_block = lingot_arena_block_size(conf->fft_size * sizeof(FLT));
+
+    size_t result = 2 * temporal_block + fft_block
+            + 3 * spd_block // spd_fft, noise_level and SPL
+            + 3 * spd_block // snapshots
+            + lingot_fft_plan_arena_size(conf->fft_size)
+            + lingot_fft_sliding_arena_size(conf->fft_size)
+            + lingot_tracker_arena_size(conf->temporal_buffer_size)
+            + lingot_filter_sos_arena_size((antialiasing_filter_order + 1) / 2);
+
+    if (conf->window_type != NONE) {
+        result += fft_block;
+    }
+
+    return result;
+}
+
+// bins searched for peaks, and bins where the spectrum is evaluated, which
+// include the peak neighbourhoods at the edges.
+static void lingot_core_get_spectrum_range(const LingotConfig* conf,
+                                           unsigned int* lowest_index,
+                                           unsigned int* highest_index,
+                                           unsigned int* first_bin,
+                                           unsigned int* last_bin) {
+
+    const unsigned int spd_size = (conf->fft_size / 2);
+
+    *lowest_index = (unsigned int) ceil(
+                conf->internal_min_frequency
+                * (1.0 * conf->oversampling / conf->sample_rate)
+                * conf->fft_size);
+    *highest_index = (unsigned int) ceil(0.95 * spd_size);
+
+    *first_bin = (*lowest_index > conf->peak_half_width) ?
+                *lowest_index - conf->peak_half_width : 0;
+    *last_bin = (*highest_index + conf->peak_half_width < spd_size) ?
+                *highest_index + conf->peak_half_width : spd_size;
+}
+
+// allocates and initializes the analysis buffers and state, according to the
+// core configuration. Returns 0 if there is no memory for the buffers, and
+// then there is nothing to release.
+static int lingot_core_dsp_new(LingotCore* core) {
+
+    // Since the SPD is symmetrical, we only store the 1st half.
+    const unsigned int spd_size = (core->conf.fft_size / 2);
+
+    // all the buffers are taken from a single arena. The ones written by the
+    // audio callback come first, then the read-only windows, the working
+    // buffers of the computation thread and, at the end, the snapshots shared
+    // with the reader.
+    if (!lingot_arena_new(&core->arena, lingot_core_dsp_arena_size(&core->conf))) {
+        lingot_msg_add_error(_("There is not enough memory for the analysis buffers"));
+        return 0;
+    }
+
+    // stored samples.
+    core->temporal_buffer = lingot_arena_alloc(&core->arena,
+                                               core->conf.temporal_buffer_size * sizeof(FLT));
+
+    /*
+     * 8 order Chebyshev filters, with wc=0.9/i (normalised respect to
+     * Pi). We take 0.9 instead of 1 to leave a 10% of safety margin,
+     * in order to avoid aliased frequencies near to w=Pi, due to non
+     * ideality of the filter.
+     *
+     * The cut frequencies wc=Pi/i, with i=1..20, correspond with the
+     * oversampling factor, avoiding aliasing at decimation.
+     *
+     * Why Chebyshev filters?, for a given order, those filters yield
+     * abrupt falls than other ones as Butterworth, making the most of
+     * the order. Although Chebyshev filters affect more to the phase,
+     * it doesn't matter due to the analysis is made on the signal
+     * power distribution (only magnitude).
+     *
+     * The filter is implemented as a cascade of second order sections,
+     * since the direct form is numerically fragile with such low cutoff
+     * frequencies.
+     */
+    lingot_filter_cheby_design_sos(&core->antialiasing_filter,
+                                   antialiasing_filter_order, 0.5,
+                                   0.9 / core->conf.oversampling, &core->arena);
+
+    // the long window is applied on the fly by the refinement.
+    core->hamming_window_fft = NULL;
+
+    if (core->conf.window_type != NONE) {
+        core->hamming_window_fft = lingot_arena_alloc(&core->arena,
+                                                      core->conf.fft_size * sizeof(FLT));
+
+        lingot_signal_window(core->conf.fft_size, core->hamming_window_fft,
+                             core->conf.window_type);
+    }
+
+    core->windowed_fft_buffer = lingot_arena_alloc(&core->arena,
+                                                   core->conf.fft_size * sizeof(FLT));
+    lingot_fft_plan_create(&core->fftplan, core->windowed_fft_buffer,
+                           core->conf.fft_size, &core->arena);
+    core->spd_fft = lingot_arena_alloc(&core->arena, spd_size * sizeof(FLT));
+    core->noise_level = lingot_arena_alloc(&core->arena, spd_size * sizeof(FLT));
+    core->SPL = lingot_arena_alloc(&core->arena, spd_size * sizeof(FLT));
+    core->temporal_buffer_copy = lingot_arena_alloc(&core->arena,
+                                                    core->conf.temporal_buffer_size * sizeof(FLT));
+
+    lingot_fft_sliding_create(&core->sliding_dft, core->conf.fft_size,
+                              &core->arena);
+    core->decimated_samples_count = 0;
+    core->sliding_dft_samples_count = 0;
+
+    lingot_core_frequency_locker_reset(&core->frequency_locker);
+    lingot_tracker_new(&core->tracker, core->conf.temporal_buffer_size, &core->arena);
+    core->tracker_samples_count = 0;
+
+    unsigned int k;
+    for (k = 0; k < LINGOT_CORE_MAX_VOICES - 1; k++) {
+        core->extra_voice_freq[k] = 0.0;
+        lingot_core_frequency_locker_reset(&core->extra_voice_locker[k]);
+    }
+    core->tracker_divisor = 1;
+    core->tracker_passes = 0;
+
+    unsigned int lowest_index, highest_index, first_bin, last_bin;
+    lingot_core_get_spectrum_range(&core->conf, &lowest_index, &highest_index,
+                                   &first_bin, &last_bin);
+
+    lingot_ring_new(&core->spectrum_ring, spectrum_ring_passes
+                    * (spd_size * sizeof(FLT) + 2 * sizeof(unsigned int)));
+
+    for (k = 0; k < 3; k++) {
+        core->snapshot[k].sequence = 0;
+        core->snapshot[k].freq = 0.0;
+        core->snapshot[k].n_voices = 0;
+        core->snapshot[k].spd_size = spd_size;
+        core->snapshot[k].first_bin = first_bin;
+        core->snapshot[k].last_bin = last_bin;
+        core->snapshot[k].SPL = lingot_arena_alloc(&core->arena,
+                                                   spd_size * sizeof(FLT));
+#ifdef DRAW_MARKERS
+        core->snapshot[k].markers_size = 0;
+        core->snapshot[k].markers_size2 = 0;
+#endif
+    }
+    core->snapshot_back = 0;
+    core->snapshot_middle = 1;
+    core->snapshot_front = 2;
+
+    return 1;
+}
+
+// releases the analysis buffers and state.
+static void lingot_core_dsp_destroy(LingotCore* core) {
+
+    lingot_fft_plan_destroy(&core->fftplan);
+    lingot_fft_sliding_destroy(&core->sliding_dft);
+    lingot_tracker_destroy(&core->tracker);
+    lingot_ring_destroy(&core->spectrum_ring);
+    lingot_filter_sos_destroy(&core->antialiasing_filter);
+
+    // the buffers, including the snapshots, are released at once.
+    lingot_arena_destroy(&core->arena);
+}
+
+#define LINGOT_CORE_SWAP(type, a, b) { type tmp = (a); (a) = (b); (b) = tmp; }
+
+// exchanges the analysis buffers, state and configuration between cores.
+static void lingot_core_dsp_swap(LingotCore* core1, LingotCore* core2) {
+    unsigned int k;
+    LINGOT_CORE_SWAP(LingotArena, core1->arena, core2->arena);
+    LINGOT_CORE_SWAP(FLT*, core1->SPL, core2->SPL);
+    LINGOT_CORE_SWAP(FLT*, core1->temporal_buffer, core2->temporal_buffer);
+    LINGOT_CORE_SWAP(FLT*, core1->hamming_window_fft, core2->hamming_window_fft);
+    LINGOT_CORE_SWAP(FLT*, core1->temporal_buffer_copy, core2->temporal_buffer_copy);
+    LINGOT_CORE_SWAP(FLT*, core1->windowed_fft_buffer, core2->windowed_fft_buffer);
+    LINGOT_CORE_SWAP(FLT*, core1->spd_fft, core2->spd_fft);
+    LINGOT_CORE_SWAP(FLT*, core1->noise_level, core2->noise_level);
+    LINGOT_CORE_SWAP(LingotFFTPlan, core1->fftplan, core2->fftplan);
+    LINGOT_CORE_SWAP(LingotSlidingDFT, core1->sliding_dft, core2->sliding_dft);
+    LINGOT_CORE_SWAP(unsigned long, core1->decimated_samples_count, core2->decimated_samples_count);
+    LINGOT_CORE_SWAP(unsigned long, core1->sliding_dft_samples_count, core2->sliding_dft_samples_count);
+    LINGOT_CORE_SWAP(LingotFilterSOS, core1->antialiasing_filter, core2->antialiasing_filter);
+    LINGOT_CORE_SWAP(LingotCoreFrequencyLocker, core1->frequency_locker, core2->frequency_locker);
+    for (k = 0; k < LINGOT_CORE_MAX_VOICES - 1; k++) {
+        LINGOT_CORE_SWAP(FLT, core1->extra_voice_freq[k], core2->extra_voice_freq[k]);
+        LINGOT_CORE_SWAP(LingotCoreFrequencyLocker, core1->extra_voice_locker[k],
+                         core2->extra_voice_locker[k]);
+    }
+    LINGOT_CORE_SWAP(LingotTracker, core1->tracker, core2->tracker);
+    LINGOT_CORE_SWAP(short, core1->tracker_divisor, core2->tracker_divisor);
+    LINGOT_CORE_SWAP(unsigned int, core1->tracker_passes, core2->tracker_passes);
+    LINGOT_CORE_SWAP(unsigned long, core1->tracker_samples_count, core2->tracker_samples_count);
+    LINGOT_CORE_SWAP(LingotRing, core1->spectrum_ring, core2->spectrum_ring);
+    LINGOT_CORE_SWAP(LingotCoreSnapshot, core1->snapshot[0], core2->snapshot[0]);
+    LINGOT_CORE_SWAP(LingotCoreSnapshot, core1->snapshot[1], core2->snapshot[1]);
+    LINGOT_CORE_SWAP(LingotCoreSnapshot, core1->snapshot[2], core2->snapshot[2]);
+    LINGOT_CORE_SWAP(int, core1->snapshot_back, core2->snapshot_back);
+    LINGOT_CORE_SWAP(int, core1->snapshot_middle, core2->snapshot_middle);
+    LINGOT_CORE_SWAP(int, core1->snapshot_front, core2->snapshot_front);
+    LINGOT_CORE_SWAP(LingotConfig, core1->conf, core2->conf);
+}
+
+// sends the current results to the telemetry clients.
+static void lingot_core_push_telemetry(LingotCore* core, unsigned long sequence) {
+    const LingotConfig* const conf = &core->conf;
+    LingotTelemetryRecord record;
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    memset(&record, 0, sizeof(record));
+    record.timestamp = (uint64_t) now.tv_sec * 1000000000u + now.tv_nsec;
+    record.frequency = core->freq;
+    record.sequence = (uint32_t) sequence;
+
+    if (core->freq > 0.0) {
+        FLT error_cents;
+        const int note_index = lingot_config_scale_get_closest_note_index(
+                    &conf->scale, core->freq, conf->root_frequency_error,
+                    &error_cents);
+        if (!isnan(error_cents)) {
+            record.note_index = note_index;
+            record.cents = (float) error_cents;
+            record.flags |= LINGOT_TELEMETRY_FLAG_PITCH;
+        }
+
+        // the spectrum is already relative to the noise level.
+        const unsigned int bin = (unsigned int) floor(0.5 + core->freq
+                                                      * conf->fft_size * conf->oversampling / conf->sample_rate);
+        if (bin < conf->fft_size / 2) {
+            record.snr = (float) core->SPL[bin];
+        }
+    }
+
+    if (core->frequency_locker.locked) {
+        record.flags |= LINGOT_TELEMETRY_FLAG_LOCKED;
+    }
+    if (core->signal_present) {
+        record.flags |= LINGOT_TELEMETRY_FLAG_SIGNAL;
+    }
+
+    lingot_telemetry_push(core->telemetry, &record);
+}
+
+// publishes the current analysis results for the reader.
+static void lingot_core_publish(LingotCore* core) {
+
+    LingotCoreSnapshot* const snapshot = &core->snapshot[core->snapshot_back];
+
+    snapshot->sequence = ++core->snapshot_sequence;
+    snapshot->freq = core->freq;
+
+    unsigned int k;
+    snapshot->n_voices = 0;
+    if (core->freq > 0.0) {
+        snapshot->voice_freq[snapshot->n_voices++] = core->freq;
+    }
+    for (k = 0; k < LINGOT_CORE_MAX_VOICES - 1; k++) {
+        if (core->extra_voice_freq[k] > 0.0) {
+            snapshot->voice_freq[snapshot->n_voices++] = core->extra_voice_freq[k];
+        }
+    }
+
+    memcpy(snapshot->SPL, core->SPL, snapshot->spd_size * sizeof(FLT));
+    lingot_ring_write(&core->spectrum_ring, 0, core->SPL, snapshot->spd_size * sizeof(FLT));
+
+    if (core->capture) {
+        LingotCaptureFrame frame;
+        frame.sample_position = __atomic_load_n(&core->decimated_samples_count,
+                                                __ATOMIC_RELAXED);
+        frame.frequency = core->freq;
+        frame.sequence = (uint32_t) snapshot->sequence;
+        frame.signal_present = (uint32_t) core->signal_present;
+        lingot_capture_push_frame(core->capture, &frame);
+    }
+
+    if (core->telemetry) {
+        lingot_core_push_telemetry(core, snapshot->sequence);
+    }
+
+#ifdef DRAW_MARKERS
+    memcpy(snapshot->markers, core->markers, sizeof(core->markers));
+    memcpy(snapshot->markers2, core->markers2, sizeof(core->markers2));
+    snapshot->markers_size = core->markers_size;
+    snapshot->markers_size2 = core->markers_size2;
+#endif
+
+    core->snapshot_back = __atomic_exchange_n(&core->snapshot_middle,
+                                              core->snapshot_back | LINGOT_CORE_SNAPSHOT_FRESH,
+                                              __ATOMIC_ACQ_REL) & ~LINGOT_CORE_SNAPSHOT_FRESH;
+}
+
+// starts the capture configured, if any.
+static LingotCapture* lingot_core_capture_new(const LingotConfig* conf,
+                                              unsigned int block_size) {
+    LingotCapture* capture = NULL;
+
+    if (strcmp(conf->capture_prefix, "none")) {
+        capture = lingot_capture_new(conf->capture_prefix, conf->sample_rate,
+                                     conf->oversampling, block_size);
+        if (!capture) {
+            lingot_msg_add_warning(_("The capture files could not be created"));
+        }
+    }
+
+    return capture;
+}
+
+// starts the telemetry server configured, if any.
+static LingotTelemetry* lingot_core_telemetry_new(const LingotConfig* conf) {
+    LingotTelemetry* telemetry = NULL;
+
+    if (strcmp(conf->telemetry_socket, "none")) {
+        telemetry = lingot_telemetry_new(conf->telemetry_socket);
+        if (!telemetry) {
+            lingot_msg_add_warning(_("The telemetry socket could not be created"));
+        }
+    }
+
+    return telemetry;
+}
+
+int lingot_core_get_pass_spectrum(LingotCore* core, FLT* SPL, unsigned int spd_size) {
+    unsigned int type;
+    int length;
+
+    // the passes of a different configuration are skipped.
+    while ((length = lingot_ring_read(&core->spectrum_ring, &type, SPL,
+                                      spd_size * sizeof(FLT))) >= 0) {
+        if ((unsigned int) length == spd_size * sizeof(FLT)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+void lingot_core_get_strobe(const LingotCore* core, LingotStrobeReadout* readout) {
+    lingot_strobe_read(&core->strobe, readout);
+}
+
+const LingotCoreSnapshot* lingot_core_get_snapshot(LingotCore* core) {
+
+    if (__atomic_load_n(&core->snapshot_middle, __ATOMIC_RELAXED)
+            & LINGOT_CORE_SNAPSHOT_FRESH) {
+        core->snapshot_front = __atomic_exchange_n(&core->snapshot_middle,
+                                                   core->snapshot_front,
+                                                   __ATOMIC_ACQ_REL) & ~LINGOT_CORE_SNAPSHOT_FRESH;
+    }
+
+    return &core->snapshot[core->snapshot_front];
+}
+
+void lingot_core_new(LingotCore* core, LingotConfig* conf) {
+
     lingot_config_copy(&core->conf, conf);
     core->running = 0;
     core->spd_fft = NULL;
@@ -52,17 +458,38 @@ void lingot_core_new(LingotCore* core, LingotConfig* conf) {
     core->SPL = NULL;
     core->flt_read_buffer = NULL;
     core->temporal_buffer = NULL;
-    core->windowed_temporal_buffer = NULL;
+    core->temporal_buffer_copy = NULL;
     core->windowed_fft_buffer = NULL;
-    core->hamming_window_temporal = NULL;
     core->hamming_window_fft = NULL;
 
+    // empty results, in case the audio source cannot be opened.
+    unsigned int k;
+    memset(&core->spectrum_ring, 0, sizeof(core->spectrum_ring));
+    for (k = 0; k < 3; k++) {
+        core->snapshot[k].sequence = 0;
+        core->snapshot[k].freq = 0.0;
+        core->snapshot[k].n_voices = 0;
+        core->snapshot[k].spd_size = 0;
+        core->snapshot[k].first_bin = 0;
+        core->snapshot[k].last_bin = 0;
+        core->snapshot[k].SPL = NULL;
+    }
+    core->snapshot_back = 0;
+    core->snapshot_middle = 1;
+    core->snapshot_front = 2;
+    core->snapshot_sequence = 0;
+    core->capture = NULL;
+    core->telemetry = NULL;
+    core->decimation_input_index = 0;
+    lingot_strobe_new(&core->strobe, 0, 1.0);
+
 #ifdef DRAW_MARKERS
     core->markers_size = 0;
     core->markers_size2 = 0;
 #endif
 
     unsigned int requested_sample_rate = core->conf.sample_rate;
+    core->requested_sample_rate = requested_sample_rate;
 
     if (core->conf.sample_rate <= 0) {
         core->conf.sample_rate = 0;
@@ -84,86 +511,34 @@ void lingot_core_new(LingotCore* core, LingotConfig* conf) {
             //			lingot_msg_add_warning(buff);
         }
 
-        if (core->conf.temporal_buffer_size < core->conf.fft_size) {
-            core->conf.temporal_window = ((double) core->conf.fft_size
-                                          * core->conf.oversampling) / core->conf.sample_rate;
-            core->conf.temporal_buffer_size = core->conf.fft_size;
+        if (lingot_core_check_temporal_buffer(&core->conf)) {
             lingot_config_update_internal_params(conf);
-            snprintf(buff, sizeof(buff),
-                     _("The temporal buffer is smaller than FFT size. It has been increased to %0.3f seconds"),
-                     core->conf.temporal_window);
-            lingot_msg_add_warning(buff);
         }
 
-        // Since the SPD is symmetrical, we only store the 1st half.
-        const unsigned int spd_size = (core->conf.fft_size / 2);
-
-        core->spd_fft = malloc(spd_size * sizeof(FLT));
-        core->noise_level = malloc(spd_size * sizeof(FLT));
-        core->SPL = malloc(spd_size * sizeof(FLT));
-
-        memset(core->spd_fft, 0, spd_size * sizeof(FLT));
-        memset(core->noise_level, 0, spd_size * sizeof(FLT));
-        memset(core->SPL, 0, spd_size * sizeof(FLT));
-
         // audio source read in floating point format.
         core->flt_read_buffer = malloc(
                     core->audio.read_buffer_size_samples * sizeof(FLT));
         memset(core->flt_read_buffer, 0,
                core->audio.read_buffer_size_samples * sizeof(FLT));
 
-        // stored samples.
-        core->temporal_buffer = malloc(
-                    (core->conf.temporal_buffer_size) * sizeof(FLT));
-        memset(core->temporal_buffer, 0,
-               core->conf.temporal_buffer_size * sizeof(FLT));
-
-        core->hamming_window_temporal = NULL;
-        core->hamming_window_fft = NULL;
-
-        if (core->conf.window_type != NONE) {
-            core->hamming_window_temporal = malloc(
-                        (core->conf.temporal_buffer_size) * sizeof(FLT));
-            core->hamming_window_fft = malloc(
-                        (core->conf.fft_size) * sizeof(FLT));
-
-            lingot_signal_window(core->conf.temporal_buffer_size,
-                                 core->hamming_window_temporal, core->conf.window_type);
-            lingot_signal_window(core->conf.fft_size, core->hamming_window_fft,
-                                 core->conf.window_type);
-        }
-
-        core->windowed_temporal_buffer = malloc(
-                    (core->conf.temporal_buffer_size) * sizeof(FLT));
-        memset(core->windowed_temporal_buffer, 0,
-               core->conf.temporal_buffer_size * sizeof(FLT));
-        core->windowed_fft_buffer = malloc(
-                    (core->conf.fft_size) * sizeof(FLT));
-        memset(core->windowed_fft_buffer, 0,
-               core->conf.fft_size * sizeof(FLT));
-
-        lingot_fft_plan_create(&core->fftplan, core->windowed_fft_buffer,
-                               core->conf.fft_size);
-
-        /*
-         * 8 order Chebyshev filters, with wc=0.9/i (normalised respect to
-         * Pi). We take 0.9 instead of 1 to leave a 10% of safety margin,
-         * in order to avoid aliased frequencies near to w=Pi, due to non
-         * ideality of the filter.
-         *
-         * The cut frequencies wc=Pi/i, with i=1..20, correspond with the
-         * oversampling factor, avoiding aliasing at decimation.
-         *
-         * Why Chebyshev filters?, for a given order, those filters yield
-         * abrupt falls than other ones as Butterworth, making the most of
-         * the order. Although Chebyshev filters affect more to the phase,
-         * it doesn't matter due to the analysis is made on the signal
-         * power distribution (only magnitude).
-         */
-        lingot_filter_cheby_design(&core->antialiasing_filter, 8, 0.5,
-                                   0.9 / core->conf.oversampling);
+        if (!lingot_core_dsp_new(core)) {
+            // the core stays without audio source, as if it could not be opened.
+            lingot_audio_destroy(&core->audio);
+            free(core->flt_read_buffer);
+            core->flt_read_buffer = NULL;
+            core->freq = 0.0;
+            return;
+        }
+        lingot_strobe_configure(&core->strobe, core->conf.strobe_harmonics,
+                                ((FLT) core->conf.sample_rate) / core->conf.oversampling);
 
         pthread_mutex_init(&core->temporal_buffer_mutex, NULL);
+        pthread_mutex_init(&core->computation_mutex, NULL);
+
+        core->signal_present = 1;
+        core->silence_samples = 0;
+        core->silence_power = 0.0;
+        core->silence_period_samples = 0;
 
         // ------------------------------------------------------------
 
@@ -179,28 +554,292 @@ void lingot_core_new(LingotCore* core, LingotConfig* conf) {
 void lingot_core_destroy(LingotCore* core) {
 
     if (core->audio.audio_system != -1) {
-        lingot_fft_plan_destroy(&core->fftplan);
+        lingot_core_dsp_destroy(core);
         lingot_audio_destroy(&core->audio);
 
-        free(core->spd_fft);
-        free(core->noise_level);
-        free(core->SPL);
         free(core->flt_read_buffer);
-        free(core->temporal_buffer);
 
-        free(core->hamming_window_temporal);
-        free(core->windowed_temporal_buffer);
-        free(core->hamming_window_fft);
-        free(core->windowed_fft_buffer);
+        pthread_mutex_destroy(&core->temporal_buffer_mutex);
+        pthread_mutex_destroy(&core->computation_mutex);
+    }
+}
 
-        lingot_filter_destroy(&core->antialiasing_filter);
+// -----------------------------------------------------------------------
 
-        pthread_mutex_destroy(&core->temporal_buffer_mutex);
+int lingot_core_reconfigure(LingotCore* core, LingotConfig* conf) {
+
+    LingotCore dsp; // only the analysis members are used.
+    unsigned int n;
+
+    // the audio stream must stay the same, and so must the scheduling of the
+    // threads, which cannot be reverted on the running ones.
+    if (!core->running || (core->audio.audio_system == -1)
+            || (conf->audio_system_index != core->conf.audio_system_index)
+            || strcmp(conf->audio_dev[conf->audio_system_index],
+                      core->conf.audio_dev[core->conf.audio_system_index])
+            || ((unsigned int) conf->sample_rate != core->requested_sample_rate)
+            || !lingot_thread_settings_equal(&conf->capture_thread,
+                                             &core->conf.capture_thread)
+            || !lingot_thread_settings_equal(&conf->analysis_thread,
+                                             &core->conf.analysis_thread)) {
+        return 0;
+    }
+
+    // the new buffers are prepared without interfering with the analysis.
+    lingot_config_copy(&dsp.conf, conf);
+    if ((unsigned int) dsp.conf.sample_rate != core->audio.real_sample_rate) {
+        dsp.conf.sample_rate = core->audio.real_sample_rate;
+        lingot_config_update_internal_params(&dsp.conf);
+    }
+    lingot_core_check_temporal_buffer(&dsp.conf);
+    if (!lingot_core_dsp_new(&dsp)) {
+        // the restart will report the failure again if memory is still short.
+        lingot_config_destroy(&dsp.conf);
+        return 0;
+    }
+
+    // the capture is restarted when its files or the decimated rate change.
+    LingotCapture* capture = core->capture;
+    const int restart_capture = strcmp(dsp.conf.capture_prefix,
+                                       core->conf.capture_prefix)
+            || (dsp.conf.oversampling != core->conf.oversampling);
+    if (restart_capture) {
+        capture = lingot_core_capture_new(&dsp.conf,
+                                          core->audio.read_buffer_size_samples);
+    }
+
+    LingotTelemetry* telemetry = core->telemetry;
+    const int restart_telemetry = strcmp(dsp.conf.telemetry_socket,
+                                         core->conf.telemetry_socket);
+    if (restart_telemetry) {
+        // the old server must release the socket path first.
+        if (telemetry) {
+            pthread_mutex_lock(&core->computation_mutex);
+            core->telemetry = NULL;
+            pthread_mutex_unlock(&core->computation_mutex);
+            lingot_telemetry_destroy(telemetry);
+        }
+        telemetry = lingot_core_telemetry_new(&dsp.conf);
+    }
+
+    // no analysis pass nor audio block are in progress while swapping.
+    pthread_mutex_lock(&core->computation_mutex);
+    pthread_mutex_lock(&core->temporal_buffer_mutex);
+
+    if (dsp.conf.oversampling == core->conf.oversampling) {
+        // the recent samples are still valid, as well as the filter status.
+        n = (dsp.conf.temporal_buffer_size < core->conf.temporal_buffer_size) ?
+                    dsp.conf.temporal_buffer_size : core->conf.temporal_buffer_size;
+        memcpy(&dsp.temporal_buffer[dsp.conf.temporal_buffer_size - n],
+               &core->temporal_buffer[core->conf.temporal_buffer_size - n],
+               n * sizeof(FLT));
+        LINGOT_CORE_SWAP(LingotFilterSOS, dsp.antialiasing_filter,
+                         core->antialiasing_filter);
+    } else {
+        core->decimation_input_index = 0;
+    }
+
+    lingot_core_dsp_swap(core, &dsp);
+    LINGOT_CORE_SWAP(LingotCapture*, core->capture, capture);
+
+    // the strobe stage is read without locking, so it is kept in place.
+    lingot_strobe_configure(&core->strobe, core->conf.strobe_harmonics,
+                            ((FLT) core->conf.sample_rate) / core->conf.oversampling);
+    core->telemetry = telemetry;
+
+    pthread_mutex_unlock(&core->temporal_buffer_mutex);
+    pthread_mutex_unlock(&core->computation_mutex);
+
+    if (restart_capture && capture) {
+        lingot_capture_destroy(capture);
+    }
+
+    // dsp holds now the old buffers.
+    lingot_core_dsp_destroy(&dsp);
+    lingot_config_destroy(&dsp.conf);
+
+    return 1;
+}
+
+// -----------------------------------------------------------------------
+
+int lingot_core_offline_new(LingotCore* core, LingotConfig* conf,
+                            unsigned int block_size) {
+
+    lingot_config_copy(&core->conf, conf);
+    core->running = 0;
+    core->audio.audio_system = -1;
+    core->audio.read_buffer_size_samples = block_size;
+    core->requested_sample_rate = conf->sample_rate;
+    core->snapshot_sequence = 0;
+    core->capture = NULL;
+    core->telemetry = NULL;
+
+#ifdef DRAW_MARKERS
+    core->markers_size = 0;
+    core->markers_size2 = 0;
+#endif
+
+    lingot_core_check_temporal_buffer(&core->conf);
+
+    core->flt_read_buffer = malloc(block_size * sizeof(FLT));
+    memset(core->flt_read_buffer, 0, block_size * sizeof(FLT));
+
+    if (!lingot_core_dsp_new(core)) {
+        free(core->flt_read_buffer);
+        lingot_config_destroy(&core->conf);
+        return 0;
+    }
+    // the results only depend on the input.
+    core->sliding_dft.measure_costs = 0;
+    lingot_strobe_new(&core->strobe, core->conf.strobe_harmonics,
+                      ((FLT) core->conf.sample_rate) / core->conf.oversampling);
+
+    pthread_mutex_init(&core->temporal_buffer_mutex, NULL);
+    pthread_mutex_init(&core->computation_mutex, NULL);
+
+    core->signal_present = 1;
+    core->silence_samples = 0;
+    core->silence_power = 0.0;
+    core->silence_period_samples = 0;
+
+    core->decimation_input_index = 0;
+    core->freq = 0.0;
+
+    lingot_core_offline_set_analysis_period(core, (unsigned int) floor(0.5
+                                            + core->conf.sample_rate
+                                            / (core->conf.oversampling * core->conf.calculation_rate)));
+
+    return 1;
+}
+
+void lingot_core_offline_destroy(LingotCore* core) {
+    lingot_core_dsp_destroy(core);
+    free(core->flt_read_buffer);
+    pthread_mutex_destroy(&core->temporal_buffer_mutex);
+    pthread_mutex_destroy(&core->computation_mutex);
+    lingot_config_destroy(&core->conf);
+}
+
+void lingot_core_offline_feed(LingotCore* core, const FLT* samples,
+                              unsigned int n) {
+    lingot_core_read_callback((FLT*) samples, n, core);
+}
+
+void lingot_core_offline_compute(LingotCore* core) {
+    lingot_core_compute_fundamental_fequency(core);
+    lingot_core_publish(core);
+}
+
+void lingot_core_offline_set_analysis_period(LingotCore* core, unsigned int period) {
+    core->analysis_period = (period > 0) ? period : 1;
+    core->samples_to_analysis = core->analysis_period;
+}
+
+unsigned int lingot_core_offline_process(LingotCore* core, const FLT* samples,
+                                         unsigned int n, LingotCoreFrameCallback callback, void* arg) {
+
+    const unsigned int block_size = core->audio.read_buffer_size_samples;
+    unsigned int passes = 0;
+
+    while (n > 0) {
+        // input samples up to the decimated sample that completes the period.
+        const unsigned int until_analysis = core->decimation_input_index
+                + (core->samples_to_analysis - 1) * core->conf.oversampling + 1;
+        unsigned int m = (n < block_size) ? n : block_size;
+        if (m > until_analysis) {
+            m = until_analysis;
+        }
+
+        const unsigned long decimated_samples_count = core->decimated_samples_count;
+        lingot_core_read_callback((FLT*) samples, m, core);
+        core->samples_to_analysis -= core->decimated_samples_count
+                - decimated_samples_count;
+
+        if (core->samples_to_analysis == 0) {
+            lingot_core_offline_compute(core);
+            core->samples_to_analysis = core->analysis_period;
+            passes++;
+            if (callback) {
+                callback(lingot_core_get_snapshot(core), arg);
+            }
+        }
+
+        samples += m;
+        n -= m;
     }
+
+    return passes;
 }
 
 // -----------------------------------------------------------------------
 
+// evaluates the silence gate on the level of a sub-block of n samples.
+// Returns 1 if a note has just started.
+static int lingot_core_evaluate_silence_gate(LingotCore* core, FLT power,
+                                             unsigned int n) {
+
+    const LingotConfig* const conf = &core->conf;
+
+    // dBFS
+    const FLT level = 10.0 * log10(power / (n * FLT_SAMPLE_SCALE * FLT_SAMPLE_SCALE)
+                                   + 1e-20);
+
+    if (level > conf->silence_threshold) {
+        core->silence_samples = 0;
+        if (!core->signal_present) {
+            core->signal_present = 1;
+            return 1;
+        }
+    } else if (core->signal_present
+               && (level < conf->silence_threshold - silence_gate_hysteresis)) {
+        core->silence_samples += n;
+        if (core->silence_samples
+                >= silence_gate_hangover * conf->sample_rate) {
+            core->signal_present = 0;
+        }
+    }
+
+    return 0;
+}
+
+// updates the silence gate with a new block of samples. The gate is
+// evaluated over sub-blocks of a fixed number of samples, aligned with the
+// start of the input, so that it does not depend on how the input is split
+// in blocks. It must be called with the temporal buffer mutex held, as it
+// reads the configuration. Returns 1 if a note has started.
+static int lingot_core_update_silence_gate(LingotCore* core, const FLT* samples,
+                                           unsigned int n) {
+
+    const LingotConfig* const conf = &core->conf;
+    unsigned int period = (unsigned int) (silence_gate_period * conf->sample_rate);
+    unsigned int i;
+    int onset = 0;
+
+    if (conf->silence_threshold <= -200.0) {
+        core->signal_present = 1;
+        core->silence_power = 0.0;
+        core->silence_period_samples = 0;
+        return 0;
+    }
+
+    if (period == 0) {
+        period = 1;
+    }
+
+    for (i = 0; i < n; i++) {
+        core->silence_power += samples[i] * samples[i];
+        if (++core->silence_period_samples >= period) {
+            onset |= lingot_core_evaluate_silence_gate(core, core->silence_power,
+                                                       core->silence_period_samples);
+            core->silence_power = 0.0;
+            core->silence_period_samples = 0;
+        }
+    }
+
+    return onset;
+}
+
 // reads a new piece of signal from audio source, applies filtering and
 // decimation and appends it to the buffer
 void lingot_core_read_callback(FLT* read_buffer, unsigned int samples_read, void *arg) {
@@ -211,8 +850,10 @@ void lingot_core_read_callback(FLT* read_buffer, unsigned int samples_read, void
     FLT* decimation_out;
     LingotCore* core = (LingotCore*) arg;
     const LingotConfig* const conf = &core->conf;
+    int onset;
 
     memcpy(core->flt_read_buffer, read_buffer, samples_read * sizeof(FLT));
+
     //	double omega = 2.0 * M_PI * 100.0;
     //	double T = 1.0 / conf->sample_rate;
     //	static double t = 0.0;
@@ -237,24 +878,20 @@ void lingot_core_read_callback(FLT* read_buffer, unsigned int samples_read, void
     // <----------------------------> samples_read
     //
 
-    decimation_output_len = 1
-            + (samples_read - (decimation_input_index + 1))
-            / conf->oversampling;
+    pthread_mutex_lock(&core->temporal_buffer_mutex);
 
-    //#define DUMP
+    // the configuration can only be replaced while this mutex is held.
+    onset = lingot_core_update_silence_gate(core, core->flt_read_buffer, samples_read);
 
-#ifdef DUMP
-    static FILE* fid0 = 0x0;
-    if (fid0 == 0x0) {
-        fid0 = fopen("/tmp/dump_pre_filter.txt", "w");
+    // the capture can only be replaced while this mutex is held.
+    if (core->capture) {
+        lingot_capture_push_raw(core->capture, core->flt_read_buffer, samples_read);
     }
 
-    for (i = 0; i < samples_read; i++) {
-        fprintf(fid0, "%f ", core->flt_read_buffer[i]);
-    }
-#endif
-
-    pthread_mutex_lock(&core->temporal_buffer_mutex);
+    // the configuration can change between blocks.
+    decimation_output_len = (samples_read > core->decimation_input_index) ?
+                1 + (samples_read - (core->decimation_input_index + 1))
+                / conf->oversampling : 0;
 
     /* we shift the temporal window to leave a hollow where place the new piece
      of data read. The buffer is actually a queue. */
@@ -292,17 +929,18 @@ void lingot_core_read_callback(FLT* read_buffer, unsigned int samples_read, void
                 - decimation_output_len];
 
         // low pass filter to avoid aliasing.
-        lingot_filter_filter(&core->antialiasing_filter, samples_read,
-                             decimation_in, decimation_in);
+        lingot_filter_sos_filter(&core->antialiasing_filter, samples_read,
+                                 decimation_in, decimation_in);
 
         // downsampling.
-        for (decimation_output_index = 0; decimation_input_index < samples_read;
-             decimation_output_index++, decimation_input_index +=
-             conf->oversampling) {
+        for (decimation_output_index = 0;
+             core->decimation_input_index < samples_read;
+             decimation_output_index++,
+             core->decimation_input_index += conf->oversampling) {
             decimation_out[decimation_output_index] =
-                    decimation_in[decimation_input_index];
+                    decimation_in[core->decimation_input_index];
         }
-        decimation_input_index -= samples_read;
+        core->decimation_input_index -= samples_read;
     } else {
         memcpy(
                     &core->temporal_buffer[conf->temporal_buffer_size
@@ -315,26 +953,27 @@ void lingot_core_read_callback(FLT* read_buffer, unsigned int samples_read, void
     //  ------------------------------------------
     //
 
-    pthread_mutex_unlock(&core->temporal_buffer_mutex);
-
-#ifdef DUMP
-    static FILE* fid1 = 0x0;
-    static FILE* fid2 = 0x0;
+    core->decimated_samples_count += decimation_output_len;
 
-    if (fid1 == 0x0) {
-        fid1 = fopen("/tmp/dump_post_filter.txt", "w");
-        fid2 = fopen("/tmp/dump_post.txt", "w");
+    if (core->capture) {
+        lingot_capture_push_decimated(core->capture,
+                                      &core->temporal_buffer[conf->temporal_buffer_size
+                - decimation_output_len], decimation_output_len);
     }
 
-    for (i = 0; i < samples_read; i++) {
-        fprintf(fid1, "%f ", core->flt_read_buffer[i]);
-    }
-    decimation_out = &core->temporal_buffer[conf->temporal_buffer_size
-            - decimation_output_len];
-    for (i = 0; i < decimation_output_len; i++) {
-        fprintf(fid2, "%f ", decimation_out[i]);
+    // it does nothing until the strobe stage has a reference note.
+    lingot_strobe_process(&core->strobe,
+                          &core->temporal_buffer[conf->temporal_buffer_size
+            - decimation_output_len], decimation_output_len);
+
+    pthread_mutex_unlock(&core->temporal_buffer_mutex);
+
+    // the computation thread is woken up as soon as a note starts.
+    if (onset && (core->audio.audio_system != -1)) {
+        pthread_mutex_lock(&core->thread_computation_mutex);
+        pthread_cond_broadcast(&core->thread_computation_wakeup_cond);
+        pthread_mutex_unlock(&core->thread_computation_mutex);
     }
-#endif
 }
 
 int lingot_core_frequencies_related(FLT freq1, FLT freq2, FLT minFrequency,
@@ -386,21 +1025,25 @@ int lingot_core_frequencies_related(FLT freq1, FLT freq2, FLT minFrequency,
     return result;
 }
 
-static FLT lingot_core_frequency_locker(FLT freq, FLT minFrequency) {
+static void lingot_core_frequency_locker_reset(LingotCoreFrequencyLocker* locker) {
+    locker->locked = 0;
+    locker->current_frequency = -1.0;
+    locker->hits_counter = 0;
+    locker->rehits_counter = 0;
+    locker->rehits_up_counter = 0;
+    locker->old_multiplier = 0.0;
+    locker->old_multiplier2 = 0.0;
+}
+
+static FLT lingot_core_frequency_locker(LingotCoreFrequencyLocker* locker,
+                                        FLT freq, FLT minFrequency) {
 
-    static int locked = 0;
-    static FLT current_frequency = -1.0;
-    static int hits_counter = 0;
-    static int rehits_counter = 0;
-    static int rehits_up_counter = 0;
     static const int nhits_to_lock = 4;
     static const int nhits_to_unlock = 5;
     static const int nhits_to_relock = 6;
     static const int nhits_to_relock_up = 8;
     FLT multiplier = 0.0;
     FLT multiplier2 = 0.0;
-    static FLT old_multiplier = 0.0;
-    static FLT old_multiplier2 = 0.0;
     int fail = 0;
     FLT result = 0.0;
 
@@ -409,11 +1052,11 @@ static FLT lingot_core_frequency_locker(FLT freq, FLT minFrequency) {
 #endif
     int consistent_with_current_frequency = 0;
     consistent_with_current_frequency = lingot_core_frequencies_related(freq,
-                                                                        current_frequency, minFrequency, &multiplier, &multiplier2);
+                                                                        locker->current_frequency, minFrequency, &multiplier, &multiplier2);
 
-    if (!locked) {
+    if (!locker->locked) {
 
-        if ((freq > 0.0) && (current_frequency == 0.0)) {
+        if ((freq > 0.0) && (locker->current_frequency == 0.0)) {
             consistent_with_current_frequency = 1;
             multiplier = 1.0;
             multiplier2 = 1.0;
@@ -423,18 +1066,18 @@ static FLT lingot_core_frequency_locker(FLT freq, FLT minFrequency) {
 
         if (consistent_with_current_frequency && (multiplier == 1.0)
                 && (multiplier2 == 1.0)) {
-            current_frequency = freq * multiplier;
+            locker->current_frequency = freq * multiplier;
 
-            if (++hits_counter >= nhits_to_lock) {
-                locked = 1;
+            if (++locker->hits_counter >= nhits_to_lock) {
+                locker->locked = 1;
 #ifdef DRAW_MARKERS
-                printf("locked to frequency %f\n", current_frequency);
+                printf("locked to frequency %f\n", locker->current_frequency);
 #endif
-                hits_counter = 0;
+                locker->hits_counter = 0;
             }
         } else {
-            hits_counter = 0;
-            current_frequency = 0.0;
+            locker->hits_counter = 0;
+            locker->current_frequency = 0.0;
         }
 
         //		result = freq;
@@ -446,36 +1089,36 @@ static FLT lingot_core_frequency_locker(FLT freq, FLT minFrequency) {
         if (consistent_with_current_frequency) {
             if (fabs(multiplier2 - 1.0) < 1e-5) {
                 result = freq * multiplier;
-                current_frequency = result;
-                rehits_counter = 0;
+                locker->current_frequency = result;
+                locker->rehits_counter = 0;
 
                 if (fabs(multiplier - 1.0) > 1e-5) {
-                    if (fabs(multiplier - old_multiplier) < 1e-5) {
+                    if (fabs(multiplier - locker->old_multiplier) < 1e-5) {
 #ifdef DRAW_MARKERS
                         printf("SEIN!!!! %f!\n", multiplier);
 #endif
-                        if (++rehits_up_counter >= nhits_to_relock_up) {
+                        if (++locker->rehits_up_counter >= nhits_to_relock_up) {
                             result = freq;
-                            current_frequency = result;
+                            locker->current_frequency = result;
 #ifdef DRAW_MARKERS
                             printf("relock UP!! to %f\n\n\n", freq);
 #endif
-                            rehits_up_counter = 0;
+                            locker->rehits_up_counter = 0;
                             fail = 0;
                         }
                     } else {
-                        rehits_up_counter = 0;
+                        locker->rehits_up_counter = 0;
                     }
                 } else {
-                    rehits_up_counter = 0;
+                    locker->rehits_up_counter = 0;
                 }
             } else {
-                rehits_up_counter = 0;
+                locker->rehits_up_counter = 0;
 #ifdef DRAW_MARKERS
                 printf("%f!\n", multiplier2);
 #endif
                 if (fabs(multiplier2 - 0.5) < 1e-5) {
-                    hits_counter--;
+                    locker->hits_counter--;
                 }
                 fail = 1;
                 if (freq * multiplier < minFrequency) {
@@ -489,20 +1132,20 @@ static FLT lingot_core_frequency_locker(FLT freq, FLT minFrequency) {
                     //					current_frequency = result;
 
 #ifdef DRAW_MARKERS
-                    printf("(%f == %f)?\n", multiplier2, old_multiplier2);
+                    printf("(%f == %f)?\n", multiplier2, locker->old_multiplier2);
 #endif
-                    if (fabs(multiplier2 - old_multiplier2) < 1e-5) {
+                    if (fabs(multiplier2 - locker->old_multiplier2) < 1e-5) {
 #ifdef DRAW_MARKERS
                         printf("match for relock, %f == %f\n", multiplier2,
-                               old_multiplier2);
+                               locker->old_multiplier2);
 #endif
-                        if (++rehits_counter >= nhits_to_relock) {
+                        if (++locker->rehits_counter >= nhits_to_relock) {
                             result = freq * multiplier;
-                            current_frequency = result;
+                            locker->current_frequency = result;
 #ifdef DRAW_MARKERS
                             printf("relock!! to %f\n", freq);
 #endif
-                            rehits_counter = 0;
+                            locker->rehits_counter = 0;
                             fail = 0;
                         }
                     }
@@ -514,34 +1157,309 @@ static FLT lingot_core_frequency_locker(FLT freq, FLT minFrequency) {
         }
 
         if (fail) {
-            result = current_frequency;
-            hits_counter++;
-            if (hits_counter >= nhits_to_unlock) {
-                current_frequency = 0.0;
-                locked = 0;
-                hits_counter = 0;
+            result = locker->current_frequency;
+            locker->hits_counter++;
+            if (locker->hits_counter >= nhits_to_unlock) {
+                locker->current_frequency = 0.0;
+                locker->locked = 0;
+                locker->hits_counter = 0;
 #ifdef DRAW_MARKERS
                 printf("unlocked\n");
 #endif
                 result = 0.0;
             }
         } else {
-            hits_counter = 0;
+            locker->hits_counter = 0;
         }
     }
 
-    old_multiplier = multiplier;
-    old_multiplier2 = multiplier2;
+    locker->old_multiplier = multiplier;
+    locker->old_multiplier2 = multiplier2;
 
     //	if (result != 0.0)
     //		printf("result = %f\n", result);
     return result;
 }
 
+// sets the closest note to the current frequency as the reference of the
+// strobe stage. The last note is kept while there is no frequency.
+static void lingot_core_update_strobe_reference(LingotCore* core) {
+
+    const LingotConfig* const conf = &core->conf;
+    FLT error_cents;
+
+    if ((conf->strobe_harmonics == 0) || (core->freq <= 0.0)) {
+        return;
+    }
+
+    lingot_config_scale_get_closest_note_index(&conf->scale, core->freq,
+                                               conf->root_frequency_error, &error_cents);
+    if (isnan(error_cents)) {
+        return;
+    }
+
+    // the oscillators are only restarted when the note changes.
+    const FLT reference = core->freq * pow(2.0, -error_cents / 1200.0);
+    if ((core->strobe.frequency > 0.0)
+            && (fabs(reference / core->strobe.frequency - 1.0) < 1e-4)) {
+        return;
+    }
+
+    pthread_mutex_lock(&core->temporal_buffer_mutex);
+    lingot_strobe_set_frequency(&core->strobe, reference);
+    pthread_mutex_unlock(&core->temporal_buffer_mutex);
+}
+
+// follows the locked frequency with the narrowband tracker, returning 0 if
+// the lock has been lost and a full search is needed.
+static int lingot_core_track_fundamental_frequency(LingotCore* core) {
+
+    const LingotConfig* const conf = &core->conf;
+    int tracking = 0;
+
+    // only the samples received since the previous pass are processed.
+    pthread_mutex_lock(&core->temporal_buffer_mutex);
+    const unsigned long new_samples = core->decimated_samples_count
+            - core->tracker_samples_count;
+    core->tracker_samples_count = core->decimated_samples_count;
+    if (new_samples <= conf->temporal_buffer_size) {
+        tracking = lingot_tracker_track(&core->tracker,
+                                        &core->temporal_buffer[conf->temporal_buffer_size
+                - new_samples], new_samples);
+    }
+    pthread_mutex_unlock(&core->temporal_buffer_mutex);
+
+    if (!tracking) {
+        return 0;
+    }
+
+    FLT freq = core->tracker.w * conf->sample_rate
+            / (core->tracker_divisor * 2.0 * M_PI * conf->oversampling);
+    core->freq = lingot_core_frequency_locker(&core->frequency_locker, freq,
+                                              conf->internal_min_frequency);
+
+    if (!core->frequency_locker.locked) {
+        lingot_tracker_reset(&core->tracker);
+    }
+
+    return 1;
+}
+
+// updates the spectrum of the latest fft_size samples in fft_out by sliding
+// the DFT over the samples received since the last pass, or with a fresh FFT
+// when sliding is not possible or not worth it. The temporal buffer mutex must
+// be held.
+static void lingot_core_update_spectrum_incrementally(LingotCore* core) {
+
+    const LingotConfig* const conf = &core->conf;
+    LingotSlidingDFT* const sdft = &core->sliding_dft;
+    const unsigned long new_samples = core->decimated_samples_count
+            - core->sliding_dft_samples_count;
+
+    core->sliding_dft_samples_count = core->decimated_samples_count;
+
+    // the samples leaving the window must still be in the temporal buffer.
+    if (!sdft->synced
+            || (new_samples > conf->temporal_buffer_size - conf->fft_size)
+            || !lingot_fft_sliding_is_worth(sdft, new_samples,
+                                            sliding_dft_resync_windows * conf->fft_size)
+            || (sdft->samples_since_resync
+                >= sliding_dft_resync_windows * conf->fft_size)) {
+        memcpy(core->windowed_fft_buffer,
+               &core->temporal_buffer[conf->temporal_buffer_size
+               - conf->fft_size], conf->fft_size * sizeof(FLT));
+        lingot_fft_sliding_resync_dft(sdft, &core->fftplan);
+    } else if (new_samples > 0) {
+        lingot_fft_sliding_update(sdft,
+                                  &core->temporal_buffer[conf->temporal_buffer_size
+                - new_samples], new_samples);
+    }
+
+    lingot_fft_sliding_window(sdft, conf->window_type, core->fftplan.fft_out);
+}
+
+// refines the given frequency, in rads, by maximizing the spectral power of
+// the windowed buffers with Newton-Raphson iterations.
+static FLT lingot_core_refine_frequency(LingotCore* core, FLT w) {
+
+    register unsigned int k;
+    const LingotConfig* const conf = &core->conf;
+
+    //  Maximum finding by Newton-Raphson
+    // -----------------------------------
+
+    FLT wk = -1.0e5;
+    FLT wkm1 = w;
+    // first iterator set to the current approximation.
+    FLT d0_SPD = 0.0;
+    FLT d1_SPD = 0.0;
+    FLT d2_SPD = 0.0;
+    FLT d0_SPD_old = 0.0;
+
+    //		printf("NR iter: %f ", w * w2f);
+
+    for (k = 0; (k < conf->max_nr_iter) && (fabs(wk - wkm1) > 1.0e-4);
+         k++) {
+        wk = wkm1;
+
+        d0_SPD_old = d0_SPD;
+        lingot_fft_spd_diffs_eval(core->windowed_fft_buffer, // TODO: iterate over this buffer?
+                                  conf->fft_size, wk, &d0_SPD, &d1_SPD, &d2_SPD);
+
+        wkm1 = wk - d1_SPD / d2_SPD;
+        //			printf(" -> (%f,%g,%g,%g)", wkm1 * w2f, d0_SPD, d1_SPD, d2_SPD);
+
+        if (d0_SPD < d0_SPD_old) {
+            //				printf("!!!", d0_SPD, d0_SPD_old);
+            wkm1 = 0.0;
+            break;
+        }
+
+    }
+    //		printf("\n");
+
+    if (wkm1 > 0.0) {
+        w = wkm1; // frequency in rads.
+        wk = -1.0e5;
+        d0_SPD = 0.0;
+        //			printf("NR2 iter: %f ", w * w2f);
+
+        for (k = 0;
+             (k <= 1)
+             || ((k < conf->max_nr_iter)
+                 && (fabs(wk - wkm1) > 1.0e-4)); k++) {
+            wk = wkm1;
+
+            // ! we use the WHOLE temporal window for bigger precision.
+            d0_SPD_old = d0_SPD;
+            lingot_fft_spd_diffs_eval_windowed(core->temporal_buffer_copy,
+                                               conf->window_type,
+                                               conf->temporal_buffer_size, wk,
+                                               &d0_SPD, &d1_SPD, &d2_SPD);
+
+            wkm1 = wk - d1_SPD / d2_SPD;
+            //				printf(" -> (%f,%g,%g,%g)", wkm1 * w2f, d0_SPD, d1_SPD, d2_SPD);
+
+            if (d0_SPD < d0_SPD_old) {
+                //					printf("!!!");
+                wkm1 = 0.0;
+                break;
+            }
+
+        }
+        //			printf("\n");
+
+        if (wkm1 > 0.0) {
+            w = wkm1; // frequency in rads.
+        }
+    }
+
+    return w;
+}
+
+// copies the temporal buffer for the Newton-Raphson refinement. The temporal
+// buffer mutex must be held.
+static void lingot_core_copy_temporal_buffer(LingotCore* core) {
+
+    register unsigned int i;
+    const LingotConfig* const conf = &core->conf;
+
+    // the refinement windows the copy on the fly.
+    memcpy(core->temporal_buffer_copy, core->temporal_buffer,
+           conf->temporal_buffer_size * sizeof(FLT));
+
+    // the incremental spectrum doesn't leave the windowed FFT buffer
+    // ready for the first refinement stage.
+    if (conf->incremental_spectrum) {
+        if (conf->window_type != NONE) {
+            for (i = 0; i < conf->fft_size; i++) {
+                core->windowed_fft_buffer[i] =
+                        core->temporal_buffer[conf->temporal_buffer_size
+                        - conf->fft_size + i] * core->hamming_window_fft[i];
+            }
+        } else {
+            memmove(core->windowed_fft_buffer,
+                    &core->temporal_buffer[conf->temporal_buffer_size
+                    - conf->fft_size], conf->fft_size * sizeof(FLT));
+        }
+    }
+}
+
+// refines the notes found besides the main one, and assigns each of them to
+// the voice that was closest in the previous pass, or to a free voice.
+static void lingot_core_update_extra_voices(LingotCore* core, const FLT* tones,
+                                            const short* divisors, unsigned int n_tones) {
+
+    unsigned int i, v;
+    const LingotConfig* const conf = &core->conf;
+    const unsigned int n_voices = conf->polyphony - 1;
+    FLT voice_input[LINGOT_CORE_MAX_VOICES - 1];
+    FLT freq[LINGOT_CORE_MAX_VOICES - 1];
+    int assigned[LINGOT_CORE_MAX_VOICES - 1];
+
+    for (i = 0; i < n_tones; i++) {
+        const FLT w = lingot_core_refine_frequency(core,
+                                                   2 * M_PI * tones[i] * conf->oversampling / conf->sample_rate);
+        freq[i] = w * conf->sample_rate
+                / (divisors[i] * 2.0 * M_PI * conf->oversampling);
+        assigned[i] = 0;
+    }
+
+    for (v = 0; v < LINGOT_CORE_MAX_VOICES - 1; v++) {
+        voice_input[v] = 0.0;
+    }
+
+    // first the notes that continue a voice.
+    for (i = 0; i < n_tones; i++) {
+        int best_voice = -1;
+        FLT best_deviation = voice_match_tolerance;
+        for (v = 0; v < n_voices; v++) {
+            const FLT reference = core->extra_voice_locker[v].current_frequency;
+            if ((reference > 0.0) && (voice_input[v] == 0.0)
+                    && (fabs(freq[i] / reference - 1.0) < best_deviation)) {
+                best_deviation = fabs(freq[i] / reference - 1.0);
+                best_voice = v;
+            }
+        }
+        if (best_voice >= 0) {
+            voice_input[best_voice] = freq[i];
+            assigned[i] = 1;
+        }
+    }
+
+    // then the new ones, in the voices not following any note.
+    for (i = 0; i < n_tones; i++) {
+        for (v = 0; !assigned[i] && (v < n_voices); v++) {
+            if ((voice_input[v] == 0.0)
+                    && (core->extra_voice_locker[v].current_frequency <= 0.0)) {
+                voice_input[v] = freq[i];
+                assigned[i] = 1;
+            }
+        }
+    }
+
+    for (v = 0; v < LINGOT_CORE_MAX_VOICES - 1; v++) {
+        core->extra_voice_freq[v] = (v < n_voices) ?
+                    lingot_core_frequency_locker(&core->extra_voice_locker[v],
+                                                 voice_input[v], conf->internal_min_frequency) :
+                    0.0;
+    }
+}
+
 void lingot_core_compute_fundamental_fequency(LingotCore* core) {
 
     register unsigned int i, k; // loop variables.
     const LingotConfig* const conf = &core->conf;
+
+    // the tracker follows a single note.
+    if (conf->narrowband_tracking && (conf->polyphony <= 1) && core->tracker.active
+            && core->frequency_locker.locked
+            && (++core->tracker_passes % tracker_full_search_period)) {
+        if (lingot_core_track_fundamental_frequency(core)) {
+            lingot_core_update_strobe_reference(core);
+            return;
+        }
+    }
     const FLT index2f = ((FLT) conf->sample_rate)
             / (conf->oversampling * conf->fft_size); // FFT resolution in Hz.
     //	const FLT index2w = 2.0 * M_PI / conf->fft_size; // FFT resolution in rads.
@@ -552,51 +1470,117 @@ void lingot_core_compute_fundamental_fequency(LingotCore* core) {
 
     pthread_mutex_lock(&core->temporal_buffer_mutex);
 
-    // windowing
-    if (conf->window_type != NONE) {
-        for (i = 0; i < conf->fft_size; i++) {
-            core->windowed_fft_buffer[i] =
-                    core->temporal_buffer[conf->temporal_buffer_size
-                    - conf->fft_size + i] * core->hamming_window_fft[i];
-        }
+    const unsigned int spd_size = (conf->fft_size / 2);
+
+    if (conf->incremental_spectrum) {
+        lingot_core_update_spectrum_incrementally(core);
     } else {
-        memmove(core->windowed_fft_buffer,
-                &core->temporal_buffer[conf->temporal_buffer_size
-                - conf->fft_size], conf->fft_size * sizeof(FLT));
+        // windowing
+        if (conf->window_type != NONE) {
+            for (i = 0; i < conf->fft_size; i++) {
+                core->windowed_fft_buffer[i] =
+                        core->temporal_buffer[conf->temporal_buffer_size
+                        - conf->fft_size + i] * core->hamming_window_fft[i];
+            }
+        } else {
+            memmove(core->windowed_fft_buffer,
+                    &core->temporal_buffer[conf->temporal_buffer_size
+                    - conf->fft_size], conf->fft_size * sizeof(FLT));
+        }
+
+        // FFT
+        lingot_fft_compute_dft(&core->fftplan);
     }
 
-    const unsigned int spd_size = (conf->fft_size / 2);
+    unsigned int lowest_index, highest_index, first_bin, last_bin;
+    lingot_core_get_spectrum_range(conf, &lowest_index, &highest_index,
+                                   &first_bin, &last_bin);
 
-    // FFT
-    lingot_fft_compute_dft_and_spd(&core->fftplan, core->spd_fft, spd_size);
+    lingot_fft_compute_spd_range(&core->fftplan, core->spd_fft, first_bin,
+                                 last_bin);
 
     static const FLT minSPL = -200;
-    for (i = 0; i < spd_size; i++) {
+    for (i = first_bin; i < last_bin; i++) {
         core->SPL[i] = 10.0 * log10(core->spd_fft[i]);
         if (core->SPL[i] < minSPL) {
             core->SPL[i] = minSPL;
         }
     }
 
-    FLT noise_filter_width = 150.0; // hz
-    unsigned int noise_filter_width_samples = ceil(
-                noise_filter_width * conf->fft_size * conf->oversampling
-                / conf->sample_rate);
-
-    lingot_signal_compute_noise_level(core->SPL, spd_size,
-                                      noise_filter_width_samples, core->noise_level);
-    for (i = 0; i < spd_size; i++) {
+    // the noise level is a smoothed spectrum, whose smoothing and warm up
+    // spans are fixed in Hz, so that they don't depend on the FFT size.
+    static const FLT noise_filter_width = 150.0; // hz
+    static const FLT noise_smoothing_width = 20.0; // hz
+    const unsigned int noise_filter_width_samples = ceil(
+                noise_filter_width / index2f);
+    const FLT noise_smoothing_bins = fmax(10.0,
+                                          round(noise_smoothing_width / index2f));
+
+    lingot_signal_compute_noise_level(&core->SPL[first_bin], last_bin - first_bin,
+                                      noise_filter_width_samples,
+                                      noise_smoothing_bins,
+                                      &core->noise_level[first_bin]);
+    for (i = first_bin; i < last_bin; i++) {
         core->SPL[i] -= core->noise_level[i];
     }
 
-    unsigned int lowest_index = (unsigned int) ceil(
-                conf->internal_min_frequency
-                * (1.0 * conf->oversampling / conf->sample_rate)
-                * conf->fft_size);
-    unsigned int highest_index = (unsigned int) ceil(0.95 * spd_size);
-
     short divisor = 1;
-    FLT f0 = lingot_signal_estimate_fundamental_frequency(core->SPL,
+    FLT f0 = 0.0;
+    FLT tones[LINGOT_CORE_MAX_VOICES];
+    short divisors[LINGOT_CORE_MAX_VOICES];
+    unsigned int n_tones = 0;
+
+    if (conf->polyphony > 1) {
+        // the harmonics of all the voices of the previous pass are favoured.
+        FLT previous[LINGOT_CORE_MAX_VOICES];
+        unsigned int n_previous = 0;
+        if (core->freq > 0.0) {
+            previous[n_previous++] = 0.5 * core->freq;
+        }
+        for (k = 0; k < conf->polyphony - 1; k++) {
+            if (core->extra_voice_freq[k] > 0.0) {
+                previous[n_previous++] = 0.5 * core->extra_voice_freq[k];
+            }
+        }
+
+        n_tones = lingot_signal_estimate_fundamental_frequencies(core->SPL,
+                                                                 previous,
+                                                                 n_previous,
+                                                                 (const LingotComplex*) core->fftplan.fft_out,
+                                                                 spd_size,
+                                                                 conf->peak_number * conf->polyphony,
+                                                                 lowest_index,
+                                                                 highest_index,
+                                                                 (unsigned short) conf->peak_half_width,
+                                                                 index2f,
+                                                                 conf->min_SNR,
+                                                                 conf->min_overall_SNR,
+                                                                 conf->internal_min_frequency,
+                                                                 core,
+                                                                 conf->polyphony,
+                                                                 tones,
+                                                                 divisors);
+
+        // the main voice keeps following the same note while it sounds.
+        const FLT current = core->frequency_locker.current_frequency;
+        unsigned int main_tone = 0;
+        FLT best_deviation = voice_match_tolerance;
+        for (k = 0; (current > 0.0) && (k < n_tones); k++) {
+            const FLT deviation = fabs(tones[k] / (divisors[k] * current) - 1.0);
+            if (deviation < best_deviation) {
+                best_deviation = deviation;
+                main_tone = k;
+            }
+        }
+
+        if (n_tones > 0) {
+            f0 = tones[main_tone];
+            divisor = divisors[main_tone];
+            tones[main_tone] = tones[0];
+            divisors[main_tone] = divisors[0];
+        }
+    } else {
+        f0 = lingot_signal_estimate_fundamental_frequency(core->SPL,
                                                           0.5 * core->freq,
                                                           (const LingotComplex*) core->fftplan.fft_out,
                                                           spd_size,
@@ -610,6 +1594,7 @@ void lingot_core_compute_fundamental_fequency(LingotCore* core) {
                                                           conf->internal_min_frequency,
                                                           core,
                                                           &divisor);
+    }
 
     FLT w;
     FLT w0 =
@@ -619,90 +1604,63 @@ void lingot_core_compute_fundamental_fequency(LingotCore* core) {
     w = w0;
     //	int Mi = floor(w / index2w);
 
-    if (w != 0.0) {
-        // windowing
-        if (conf->window_type != NONE) {
-            for (i = 0; i < conf->temporal_buffer_size; i++) {
-                core->windowed_temporal_buffer[i] = core->temporal_buffer[i]
-                        * core->hamming_window_temporal[i];
-            }
+    // the earlier frame for the phase vocoder is at most one FFT size away, so
+    // that the initial estimation error is within the unambiguous range.
+    const unsigned int pv_hop =
+            (conf->temporal_buffer_size - conf->fft_size < conf->fft_size) ?
+                conf->temporal_buffer_size - conf->fft_size : conf->fft_size;
+    const unsigned int pv_bin = (unsigned int) floor(
+                0.5 + w * conf->fft_size / (2.0 * M_PI));
+    const int phase_vocoder = (conf->frequency_refinement == PHASE_VOCODER)
+            && (pv_hop > 0) && (pv_bin > 0) && (pv_bin < spd_size);
+    LingotComplex pv_X0;
+    LingotComplex pv_X1;
+
+    if ((w != 0.0) && phase_vocoder) {
+        const FLT* frame = &core->temporal_buffer[conf->temporal_buffer_size
+                - conf->fft_size];
+
+        lingot_fft_dft_bin(frame - pv_hop, core->hamming_window_fft,
+                           conf->fft_size, pv_bin, pv_X0);
+
+        // the incremental spectrum is windowed differently, so the latest
+        // frame is also transformed here.
+        if (conf->incremental_spectrum) {
+            lingot_fft_dft_bin(frame, core->hamming_window_fft,
+                               conf->fft_size, pv_bin, pv_X1);
         } else {
-            memmove(core->windowed_temporal_buffer, core->temporal_buffer,
-                    conf->temporal_buffer_size * sizeof(FLT));
+            pv_X1[0] = core->fftplan.fft_out[pv_bin][0];
+            pv_X1[1] = core->fftplan.fft_out[pv_bin][1];
         }
     }
 
-    pthread_mutex_unlock(&core->temporal_buffer_mutex); // we don't need the read buffer anymore
-
-    if (w != 0.0) {
-
-        //  Maximum finding by Newton-Raphson
-        // -----------------------------------
+    // the other notes are always refined by Newton-Raphson.
+    if (((w != 0.0) && !phase_vocoder) || (n_tones > 1)) {
+        lingot_core_copy_temporal_buffer(core);
+    }
 
-        FLT wk = -1.0e5;
-        FLT wkm1 = w;
-        // first iterator set to the current approximation.
-        FLT d0_SPD = 0.0;
-        FLT d1_SPD = 0.0;
-        FLT d2_SPD = 0.0;
-        FLT d0_SPD_old = 0.0;
+    pthread_mutex_unlock(&core->temporal_buffer_mutex); // we don't need the read buffer anymore
 
-        //		printf("NR iter: %f ", w * w2f);
+    if ((w != 0.0) && phase_vocoder) {
 
-        for (k = 0; (k < conf->max_nr_iter) && (fabs(wk - wkm1) > 1.0e-4);
-             k++) {
-            wk = wkm1;
+        //  Phase vocoder refinement
+        // --------------------------
 
-            d0_SPD_old = d0_SPD;
-            lingot_fft_spd_diffs_eval(core->windowed_fft_buffer, // TODO: iterate over this buffer?
-                                      conf->fft_size, wk, &d0_SPD, &d1_SPD, &d2_SPD);
-
-            wkm1 = wk - d1_SPD / d2_SPD;
-            //			printf(" -> (%f,%g,%g,%g)", wkm1 * w2f, d0_SPD, d1_SPD, d2_SPD);
-
-            if (d0_SPD < d0_SPD_old) {
-                //				printf("!!!", d0_SPD, d0_SPD_old);
-                wkm1 = 0.0;
-                break;
-            }
+        FLT w_pv = lingot_signal_phase_vocoder_frequency(pv_X0, pv_X1, w,
+                                                         pv_hop);
 
+        // the refined frequency must stay within the peak bin.
+        if (fabs(w_pv - w) < 2.0 * M_PI / conf->fft_size) {
+            w = w_pv;
         }
-        //		printf("\n");
 
-        if (wkm1 > 0.0) {
-            w = wkm1; // frequency in rads.
-            wk = -1.0e5;
-            d0_SPD = 0.0;
-            //			printf("NR2 iter: %f ", w * w2f);
-
-            for (k = 0;
-                 (k <= 1)
-                 || ((k < conf->max_nr_iter)
-                     && (fabs(wk - wkm1) > 1.0e-4)); k++) {
-                wk = wkm1;
-
-                // ! we use the WHOLE temporal window for bigger precision.
-                d0_SPD_old = d0_SPD;
-                lingot_fft_spd_diffs_eval(core->windowed_temporal_buffer,
-                                          conf->temporal_buffer_size, wk, &d0_SPD, &d1_SPD,
-                                          &d2_SPD);
-
-                wkm1 = wk - d1_SPD / d2_SPD;
-                //				printf(" -> (%f,%g,%g,%g)", wkm1 * w2f, d0_SPD, d1_SPD, d2_SPD);
-
-                if (d0_SPD < d0_SPD_old) {
-                    //					printf("!!!");
-                    wkm1 = 0.0;
-                    break;
-                }
-
-            }
-            //			printf("\n");
+    } else if (w != 0.0) {
+        w = lingot_core_refine_frequency(core, w);
+    }
 
-            if (wkm1 > 0.0) {
-                w = wkm1; // frequency in rads.
-            }
-        }
+    if (conf->polyphony > 1) {
+        lingot_core_update_extra_voices(core, &tones[1], &divisors[1],
+                                        (n_tones > 1) ? n_tones - 1 : 0);
     }
 
     FLT freq =
@@ -711,33 +1669,73 @@ void lingot_core_compute_fundamental_fequency(LingotCore* core) {
                 w * conf->sample_rate
                 / (divisor * 2.0 * M_PI * conf->oversampling); // analog frequency in Hz.
     //	core->freq = freq;
-    core->freq = lingot_core_frequency_locker(freq,
+    core->freq = lingot_core_frequency_locker(&core->frequency_locker, freq,
                                               core->conf.internal_min_frequency);
+
+    if (conf->narrowband_tracking && (conf->polyphony <= 1)) {
+        if (core->frequency_locker.locked && (w != 0.0)) {
+            pthread_mutex_lock(&core->temporal_buffer_mutex);
+            const unsigned long new_samples = core->decimated_samples_count
+                    - core->tracker_samples_count;
+            lingot_tracker_engage(&core->tracker, w, core->temporal_buffer,
+                                  (new_samples <= conf->temporal_buffer_size) ?
+                                      new_samples : conf->temporal_buffer_size + 1);
+            core->tracker_samples_count = core->decimated_samples_count;
+            pthread_mutex_unlock(&core->temporal_buffer_mutex);
+            core->tracker_divisor = divisor;
+            core->tracker_passes = 0;
+        } else {
+            lingot_tracker_reset(&core->tracker);
+        }
+    }
     //	printf("-> %f\n", core->freq);
+
+    lingot_core_update_strobe_reference(core);
 }
 
 /* start running the core in another thread */
 void lingot_core_start(LingotCore* core) {
 
     int audio_status = 0;
-    decimation_input_index = 0;
+    core->decimation_input_index = 0;
 
     if (core->audio.audio_system != -1) {
+        // the audio callback can wake up the computation thread.
+        pthread_mutex_init(&core->thread_computation_mutex, NULL);
+        pthread_cond_init(&core->thread_computation_cond, NULL);
+        pthread_cond_init(&core->thread_computation_wakeup_cond, NULL);
+        core->thread_computation_finished = 0;
+
+        core->capture = lingot_core_capture_new(&core->conf,
+                                                core->audio.read_buffer_size_samples);
+        core->telemetry = lingot_core_telemetry_new(&core->conf);
+
+        core->audio.thread_input_read_settings = core->conf.capture_thread;
         audio_status = lingot_audio_start(&core->audio);
 
         if (audio_status == 0) {
-            pthread_mutex_init(&core->thread_computation_mutex, NULL);
-            pthread_cond_init(&core->thread_computation_cond, NULL);
-
             pthread_attr_init(&core->thread_computation_attr);
             pthread_create(&core->thread_computation,
                            &core->thread_computation_attr,
                            lingot_core_run_computation_thread,
                            core);
+            lingot_thread_apply(core->thread_computation,
+                                &core->conf.analysis_thread, _("analysis"));
             core->running = 1;
         } else {
             core->running = 0;
             lingot_audio_destroy(&core->audio);
+            if (core->capture) {
+                lingot_capture_destroy(core->capture);
+                core->capture = NULL;
+            }
+            if (core->telemetry) {
+                lingot_telemetry_destroy(core->telemetry);
+                core->telemetry = NULL;
+            }
+            pthread_mutex_destroy(&core->thread_computation_mutex);
+            pthread_cond_destroy(&core->thread_computation_cond);
+            pthread_cond_destroy(&core->thread_computation_wakeup_cond);
         }
 
     }
@@ -747,10 +1745,16 @@ void lingot_core_start(LingotCore* core) {
 void lingot_core_stop(LingotCore* core) {
     void* thread_result;
 
-    int result;
+    int result = 0;
     struct timeval tout_abs;
     struct timespec tout_tspec;
 
+    // the audio callback wakes up the computation thread, so it is stopped
+    // before the synchronization objects are destroyed.
+    if (core->audio.audio_system != -1) {
+        lingot_audio_stop(&core->audio);
+    }
+
     gettimeofday(&tout_abs, NULL);
 
     if (core->running == 1) {
@@ -765,29 +1769,46 @@ void lingot_core_stop(LingotCore* core) {
         tout_tspec.tv_sec = tout_abs.tv_sec;
         tout_tspec.tv_nsec = 1000 * tout_abs.tv_usec;
 
-        // watchdog timer
+        // watchdog timer, the computation thread is woken up in case it is
+        // idle.
         pthread_mutex_lock(&core->thread_computation_mutex);
-        result = pthread_cond_timedwait(&core->thread_computation_cond,
-                                        &core->thread_computation_mutex, &tout_tspec);
+        pthread_cond_broadcast(&core->thread_computation_wakeup_cond);
+        while (!core->thread_computation_finished && (result != ETIMEDOUT)) {
+            result = pthread_cond_timedwait(&core->thread_computation_cond,
+                                            &core->thread_computation_mutex, &tout_tspec);
+        }
         pthread_mutex_unlock(&core->thread_computation_mutex);
 
+        pthread_attr_destroy(&core->thread_computation_attr);
+
         if (result == ETIMEDOUT) {
+            // the thread may still use its synchronization objects, and it
+            // is still the only writer of the snapshots, the capture and the
+            // telemetry, so they are left as they are.
             fprintf(stderr, "warning: cancelling computation thread\n");
             //			pthread_cancel(core->thread_computation);
-        } else {
-            pthread_join(core->thread_computation, &thread_result);
+            return;
         }
-        pthread_attr_destroy(&core->thread_computation_attr);
+
+        pthread_join(core->thread_computation, &thread_result);
         pthread_mutex_destroy(&core->thread_computation_mutex);
         pthread_cond_destroy(&core->thread_computation_cond);
+        pthread_cond_destroy(&core->thread_computation_wakeup_cond);
 
         int spd_size = core->conf.fft_size / 2;
         memset(core->SPL, 0, spd_size * sizeof(FLT));
         core->freq = 0.0;
+        lingot_core_publish(core);
     }
 
-    if (core->audio.audio_system != -1) {
-        lingot_audio_stop(&core->audio);
+    // the audio and analysis threads are not running anymore.
+    if (core->capture) {
+        lingot_capture_destroy(core->capture);
+        core->capture = NULL;
+    }
+    if (core->telemetry) {
+        lingot_telemetry_destroy(core->telemetry);
+        core->telemetry = NULL;
     }
 }
 
@@ -795,35 +1816,56 @@ void lingot_core_stop(LingotCore* core) {
 void* lingot_core_run_computation_thread(void* _core) {
     struct timeval tout_abs;
     struct timespec tout_tspec;
+    int result;
 
     LingotCore* core = _core;
     gettimeofday(&tout_abs, NULL);
 
     while (core->running) {
+        pthread_mutex_lock(&core->computation_mutex);
         lingot_core_compute_fundamental_fequency(core);
-        tout_abs.tv_usec += 1e6 / core->conf.calculation_rate;
-        if (tout_abs.tv_usec >= 1000000) {
+        lingot_core_publish(core);
+        pthread_mutex_unlock(&core->computation_mutex);
+
+        // the analysis slows down while the input is silent.
+        tout_abs.tv_usec += 1e6 / (core->signal_present ?
+                                       core->conf.calculation_rate :
+                                       idle_calculation_rate);
+        while (tout_abs.tv_usec >= 1000000) {
             tout_abs.tv_usec -= 1000000;
             tout_abs.tv_sec++;
         }
         tout_tspec.tv_sec = tout_abs.tv_sec;
         tout_tspec.tv_nsec = 1000 * tout_abs.tv_usec;
+        result = ETIMEDOUT;
         pthread_mutex_lock(&core->thread_computation_mutex);
-        pthread_cond_timedwait(&core->thread_computation_cond,
-                               &core->thread_computation_mutex, &tout_tspec);
+        if (core->running) {
+            result = pthread_cond_timedwait(&core->thread_computation_wakeup_cond,
+                                            &core->thread_computation_mutex,
+                                            &tout_tspec);
+        }
         pthread_mutex_unlock(&core->thread_computation_mutex);
 
+        // woken up by a note onset, the schedule restarts from now.
+        if (result != ETIMEDOUT) {
+            gettimeofday(&tout_abs, NULL);
+        }
+
         if (core->audio.audio_system != -1) {
+            pthread_mutex_lock(&core->computation_mutex);
             const unsigned int spd_size = core->conf.fft_size / 2;
             if (core->audio.interrupted) {
                 memset(core->SPL, 0, spd_size * sizeof(FLT));
                 core->freq = 0.0;
                 core->running = 0;
+                lingot_core_publish(core);
             }
+            pthread_mutex_unlock(&core->computation_mutex);
         }
     }
 
     pthread_mutex_lock(&core->thread_computation_mutex);
+    core->thread_computation_finished = 1;
     pthread_cond_broadcast(&core->thread_computation_cond);
     pthread_mutex_unlock(&core->thread_computation_mutex);
 
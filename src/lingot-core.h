@@ -28,6 +28,7 @@
 #include <pthread.h>
 
 #include "lingot-defs.h"
+#include "lingot-arena.h"
 #include "lingot-complex.h"
 #include "lingot-filter.h"
 #include "lingot-config.h"
@@ -35,25 +36,77 @@
 #include "lingot-audio.h"
 
 #include "lingot-fft.h"
+#include "lingot-tracker.h"
+#include "lingot-ring.h"
+#include "lingot-capture.h"
+#include "lingot-telemetry.h"
+#include "lingot-strobe.h"
 
+// frequency locker state, it filters the raw estimations in order to avoid
+// octave jumps and spurious values.
 typedef struct {
+    int locked;
+    FLT current_frequency;
+    int hits_counter;
+    int rehits_counter;
+    int rehits_up_counter;
+    FLT old_multiplier;
+    FLT old_multiplier2;
+} LingotCoreFrequencyLocker;
 
-    //  -- shared data --
+// maximum number of simultaneous notes (see the polyphony option).
+#define LINGOT_CORE_MAX_VOICES 6
+
+// results of an analysis pass, as published for the readers.
+typedef struct {
+    unsigned long sequence; // publication number, 0 if nothing published yet.
+    FLT freq; // computed analog frequency.
+
+    // frequencies of the locked notes found simultaneously, with freq first
+    // if it is not 0. There is only freq when the polyphony is 1.
+    unsigned int n_voices;
+    FLT voice_freq[LINGOT_CORE_MAX_VOICES];
+
+    unsigned int spd_size; // number of SPL values.
+    FLT* SPL; // visual portion of FFT.
+
+    // range of SPL values evaluated by the analysis, the ones outside are
+    // meaningless.
+    unsigned int first_bin;
+    unsigned int last_bin;
+
+#	ifdef DRAW_MARKERS
+    int markers[20];
+    int markers2[20];
+    short markers_size;
+    short markers_size2;
+#	endif
+} LingotCoreSnapshot;
+
+// flag of the exchanged snapshot index, telling that it holds a publication
+// not seen yet by the reader.
+#define LINGOT_CORE_SNAPSHOT_FRESH 4
+
+typedef struct {
+
+    // analysis results, owned by the computation thread.
     FLT freq; // computed analog frequency.
     FLT* SPL; // visual portion of FFT.
-    //  -- shared data --
+
+    // memory of the analysis buffers below and of the snapshots.
+    LingotArena arena;
 
     LingotAudioHandler audio; // audio handler.
 
     FLT* flt_read_buffer;
     FLT* temporal_buffer; // sample memory.
 
-    // precomputed hamming windows
-    FLT* hamming_window_temporal;
+    // precomputed hamming window
     FLT* hamming_window_fft;
 
-    // windowed signals
-    FLT* windowed_temporal_buffer;
+    // copy of the samples refined by the current pass, taken while the audio
+    // callback is held off, and windowed signal of the FFT.
+    FLT* temporal_buffer_copy;
     FLT* windowed_fft_buffer;
 
     // spectral power distribution esteem.
@@ -62,7 +115,25 @@ typedef struct {
 
     LingotFFTPlan fftplan;
 
-    LingotFilter antialiasing_filter; // antialiasing filter for decimation.
+    // incremental spectrum update.
+    LingotSlidingDFT sliding_dft;
+    unsigned long decimated_samples_count; // decimated samples written so far.
+    unsigned int decimation_input_index; // input position of the next decimated sample.
+    unsigned long sliding_dft_samples_count; // samples seen by the sliding DFT.
+
+    LingotFilterSOS antialiasing_filter; // antialiasing filter for decimation.
+
+    LingotCoreFrequencyLocker frequency_locker;
+
+    // notes found besides the main one (freq), each one with its own locker.
+    FLT extra_voice_freq[LINGOT_CORE_MAX_VOICES - 1];
+    LingotCoreFrequencyLocker extra_voice_locker[LINGOT_CORE_MAX_VOICES - 1];
+
+    // narrowband tracking of the locked frequency.
+    LingotTracker tracker;
+    short tracker_divisor; // divisor that relates the tracked peak and the fundamental.
+    unsigned int tracker_passes; // passes since the last full search.
+    unsigned long tracker_samples_count; // decimated samples given to the tracker.
 
     int running;
 
@@ -70,11 +141,56 @@ typedef struct {
 
     pthread_t thread_computation;
     pthread_attr_t thread_computation_attr;
-    pthread_cond_t thread_computation_cond;
     pthread_mutex_t thread_computation_mutex;
+    // signalled by the computation thread when it ends.
+    pthread_cond_t thread_computation_cond;
+    int thread_computation_finished;
+    // wakes up the computation thread on note onsets and stop requests.
+    pthread_cond_t thread_computation_wakeup_cond;
 
     pthread_mutex_t temporal_buffer_mutex;
 
+    // held by the computation thread during each analysis pass.
+    pthread_mutex_t computation_mutex;
+
+    unsigned int requested_sample_rate;
+
+    // virtual time of the offline core: analysis period and remaining
+    // samples until the next pass, in decimated samples.
+    unsigned int analysis_period;
+    unsigned int samples_to_analysis;
+
+    // silence gate, updated by the audio callback.
+    int signal_present;
+    unsigned int silence_samples; // samples below the threshold.
+    FLT silence_power; // accumulated over the current sub-block.
+    unsigned int silence_period_samples; // samples in the current sub-block.
+
+    // triple buffer with the published results. The computation thread owns
+    // the back snapshot and the reader owns the front one, while the middle
+    // one is exchanged atomically between them.
+    LingotCoreSnapshot snapshot[3];
+    int snapshot_back;
+    int snapshot_front;
+    // index | LINGOT_CORE_SNAPSHOT_FRESH, accessed atomically. It has its own
+    // cache line, so that its exchanges do not invalidate the fields used by
+    // only one of the threads.
+    int snapshot_middle __attribute__((aligned(LINGOT_CACHE_LINE_SIZE)));
+    unsigned long snapshot_sequence __attribute__((aligned(LINGOT_CACHE_LINE_SIZE)));
+
+    // SPL of every published pass, for the reader, which only gets the
+    // latest one from the snapshots.
+    LingotRing spectrum_ring;
+
+    // capture of the input and the results, NULL if disabled.
+    LingotCapture* capture;
+
+    // stream of the results to local clients, NULL if disabled.
+    LingotTelemetry* telemetry;
+
+    // strobe stage, fed with the decimated signal by the audio callback.
+    LingotStrobe strobe;
+
 #	ifdef DRAW_MARKERS
     int markers[20];
     int markers2[20];
@@ -94,6 +210,52 @@ void lingot_core_start(LingotCore*);
 // stop process
 void lingot_core_stop(LingotCore*);
 
+// applies the analysis parameters of the given configuration while the core
+// is running, without reopening the audio device. Returns 0 if the change
+// requires a restart of the core (e.g. a different audio device or thread
+// scheduling).
+int lingot_core_reconfigure(LingotCore*, LingotConfig*);
+
+// creates a core without audio source nor threads, that is fed by the caller
+// with blocks of at most block_size samples at the configured sample rate.
+// Returns 0 if there is no memory for it, and then it must not be destroyed.
+int lingot_core_offline_new(LingotCore*, LingotConfig*, unsigned int block_size);
+void lingot_core_offline_destroy(LingotCore*);
+
+// appends a block of samples to the offline core.
+void lingot_core_offline_feed(LingotCore*, const FLT* samples, unsigned int n);
+
+// runs an analysis pass on the offline core.
+void lingot_core_offline_compute(LingotCore*);
+
+// called after each analysis pass run in virtual time.
+typedef void (*LingotCoreFrameCallback)(const LingotCoreSnapshot* snapshot, void* arg);
+
+// sets the analysis period of the offline core, in decimated samples. By
+// default it corresponds to the configured calculation rate.
+void lingot_core_offline_set_analysis_period(LingotCore*, unsigned int period);
+
+// feeds any number of samples to the offline core, running an analysis pass
+// exactly every analysis period of input, i.e. in virtual time instead of wall
+// time. The results only depend on the input samples, and not on how they are
+// split in calls. The callback can be NULL. Returns the number of passes run.
+unsigned int lingot_core_offline_process(LingotCore*, const FLT* samples, unsigned int n,
+                                         LingotCoreFrameCallback callback, void* arg);
+
+// gets the latest results published by the core, without locking. The
+// returned snapshot stays consistent until the next call, which must be done
+// from the same thread (there is a single reader).
+const LingotCoreSnapshot* lingot_core_get_snapshot(LingotCore*);
+
+// takes the SPL of the oldest published pass not taken yet, with spd_size
+// values, in order to follow every pass (e.g. in a spectrogram). It must be
+// called from the reader thread. Returns 0 if there are no more.
+int lingot_core_get_pass_spectrum(LingotCore*, FLT* SPL, unsigned int spd_size);
+
+// gets the latest phases of the strobe stage, without locking. They are
+// updated with every audio block, i.e. much faster than the snapshots.
+void lingot_core_get_strobe(const LingotCore*, LingotStrobeReadout*);
+
 // tells whether the two frequencies are harmonically related, giving the
 // multipliers to the ground frequency
 int lingot_core_frequencies_related(FLT freq1, FLT freq2, FLT minFrequency,
@@ -30,6 +30,9 @@
 // floating point precission.
 #define FLT                  double
 
+// alignment of the analysis buffers, enough for any vector load.
+#define LINGOT_CACHE_LINE_SIZE    64
+
 #define CONFIG_DIR_NAME           ".config/lingot/"
 #define DEFAULT_CONFIG_FILE_NAME  "lingot.conf"
 extern char CONFIG_FILE_NAME[];
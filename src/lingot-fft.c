@@ -25,33 +25,88 @@
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "lingot-fft.h"
 #include "lingot-config.h"
 
 #ifndef LIBFFTW
 #include "lingot-complex.h"
+#else
+#include <pthread.h>
 #endif
 
 /*
  DTFT functions.
  */
 
-void lingot_fft_plan_create(LingotFFTPlan* result, FLT* in, unsigned int n) {
+#ifdef LIBFFTW
+// the FFTW planner is not thread-safe, and the plans are created and
+// destroyed from several threads (e.g. the calibration runs in background).
+static pthread_mutex_t lingot_fft_planner_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+#ifdef LIBFFTW_THREADS
+// smallest transform planned over several threads.
+#define LINGOT_FFT_THREADED_SIZE 16384
+
+// threads used by the large transforms, the computation thread is not
+// supposed to take the whole machine.
+static int lingot_fft_threads(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus > 4) {
+        cpus = 4;
+    }
+    return (cpus > 1) ? (int) cpus : 1;
+}
+#endif
+
+void lingot_fft_plan_create(LingotFFTPlan* result, FLT* in, unsigned int n,
+                            LingotArena* arena) {
 
     result->n = n;
     result->in = in;
+    result->in_arena = (arena != NULL);
 
 #ifdef LIBFFTW
-    result->fft_out = fftw_malloc(n * sizeof(fftw_complex));
-    memset(result->fft_out, 0, n * sizeof(fftw_complex));
+    pthread_mutex_lock(&lingot_fft_planner_mutex);
+
+#ifdef LIBFFTW_THREADS
+    // the large transforms are split among several threads.
+    static int threads_initialized = 0;
+    if (!threads_initialized) {
+        threads_initialized = fftw_init_threads() ? 1 : -1;
+    }
+    if (threads_initialized > 0) {
+        fftw_plan_with_nthreads((n >= LINGOT_FFT_THREADED_SIZE) ?
+                                    lingot_fft_threads() : 1);
+    }
+#endif
+
+    // the arena alignment is enough for the FFTW vector kernels.
+    if (arena) {
+        result->fft_out = lingot_arena_alloc(arena, n * sizeof(fftw_complex));
+    } else {
+        result->fft_out = fftw_malloc(n * sizeof(fftw_complex));
+        memset(result->fft_out, 0, n * sizeof(fftw_complex));
+    }
     result->fftwplan = fftw_plan_dft_r2c_1d(n, in, result->fft_out,
                                             FFTW_ESTIMATE);
+
+    pthread_mutex_unlock(&lingot_fft_planner_mutex);
 #else
     FLT alpha;
 
     // twiddle factors
-    result->wn = (LingotComplex*) malloc((n >> 1) * sizeof(LingotComplex));
+    if (arena) {
+        result->wn = lingot_arena_alloc(arena, (n >> 1) * sizeof(LingotComplex));
+        result->fft_out = lingot_arena_alloc(arena, n * sizeof(LingotComplex));
+    } else {
+        result->wn = (LingotComplex*) malloc((n >> 1) * sizeof(LingotComplex));
+        result->fft_out = malloc(n * sizeof(LingotComplex)); // complex signal in freq domain.
+        memset(result->fft_out, 0, n * sizeof(LingotComplex));
+    }
 
     unsigned int i;
     for (i = 0; i < (n >> 1); i++) {
@@ -59,8 +114,6 @@ void lingot_fft_plan_create(LingotFFTPlan* result, FLT* in, unsigned int n) {
         result->wn[i][0] = cos(alpha);
         result->wn[i][1] = sin(alpha);
     }
-    result->fft_out = malloc(n * sizeof(LingotComplex)); // complex signal in freq domain.
-    memset(result->fft_out, 0, n * sizeof(LingotComplex));
 #endif
 
 }
@@ -68,12 +121,26 @@ void lingot_fft_plan_create(LingotFFTPlan* result, FLT* in, unsigned int n) {
 void lingot_fft_plan_destroy(LingotFFTPlan* plan) {
 
 #ifdef LIBFFTW
+    pthread_mutex_lock(&lingot_fft_planner_mutex);
     fftw_destroy_plan(plan->fftwplan);
-    fftw_free(plan->fft_out);
+    pthread_mutex_unlock(&lingot_fft_planner_mutex);
+    if (!plan->in_arena) {
+        fftw_free(plan->fft_out);
+    }
 #else
-    free(plan->fft_out);
-    free(plan->wn);
+    if (!plan->in_arena) {
+        free(plan->fft_out);
+        free(plan->wn);
+    }
+#endif
+}
+
+size_t lingot_fft_plan_arena_size(unsigned int n) {
+    size_t result = lingot_arena_block_size(n * sizeof(LingotComplex));
+#ifndef LIBFFTW
+    result += lingot_arena_block_size((n >> 1) * sizeof(LingotComplex));
 #endif
+    return result;
 }
 
 #ifndef LIBFFTW
@@ -119,11 +186,7 @@ void lingot_fft_fft(LingotFFTPlan* plan) {
 
 #endif
 
-void lingot_fft_compute_dft_and_spd(LingotFFTPlan* plan, FLT* out, unsigned int n_out) {
-
-    unsigned int i;
-    double _1_N2 = 1.0 / (plan->n * plan->n);
-
+void lingot_fft_compute_dft(LingotFFTPlan* plan) {
 # ifdef LIBFFTW
     // transformation.
     fftw_execute(plan->fftwplan);
@@ -131,14 +194,236 @@ void lingot_fft_compute_dft_and_spd(LingotFFTPlan* plan, FLT* out, unsigned int
     // transformation.
     lingot_fft_fft(plan);
 #endif
+}
+
+void lingot_fft_compute_spd(LingotFFTPlan* plan, FLT* out, unsigned int n_out) {
+    lingot_fft_compute_spd_range(plan, out, 0, n_out);
+}
+
+void lingot_fft_compute_spd_range(LingotFFTPlan* plan, FLT* out,
+                                  unsigned int first, unsigned int last) {
+
+    unsigned int i;
+    const FLT _1_N2 = 1.0 / ((FLT) plan->n * plan->n);
 
     // esteem of SPD from FFT. (normalized squared module)
-    for (i = 0; i < n_out; i++) {
+    for (i = first; i < last; i++) {
         out[i] = (plan->fft_out[i][0] * plan->fft_out[i][0]
                 + plan->fft_out[i][1] * plan->fft_out[i][1]) * _1_N2;
     }
 }
 
+void lingot_fft_compute_dft_and_spd(LingotFFTPlan* plan, FLT* out, unsigned int n_out) {
+    lingot_fft_compute_dft(plan);
+    lingot_fft_compute_spd(plan, out, n_out);
+}
+
+/*
+ Sliding DFT.
+ */
+
+void lingot_fft_sliding_create(LingotSlidingDFT* sdft, unsigned int n,
+                               LingotArena* arena) {
+
+    FLT alpha;
+    unsigned int k;
+
+    sdft->n = n;
+    sdft->n_bins = (n >> 1) + 1;
+    sdft->in_arena = (arena != NULL);
+    if (arena) {
+        sdft->wn = lingot_arena_alloc(arena, sdft->n_bins * sizeof(LingotComplex));
+        sdft->X = lingot_arena_alloc(arena, sdft->n_bins * sizeof(LingotComplex));
+    } else {
+        sdft->wn = malloc(sdft->n_bins * sizeof(LingotComplex));
+        sdft->X = malloc(sdft->n_bins * sizeof(LingotComplex));
+        memset(sdft->X, 0, sdft->n_bins * sizeof(LingotComplex));
+    }
+
+    for (k = 0; k < sdft->n_bins; k++) {
+        alpha = 2.0 * k * M_PI / n;
+        sdft->wn[k][0] = cos(alpha);
+        sdft->wn[k][1] = sin(alpha);
+    }
+
+    sdft->synced = 0;
+    sdft->samples_since_resync = 0;
+    sdft->fft_time = 0.0;
+    sdft->update_time = 0.0;
+    sdft->measure_costs = 1;
+}
+
+void lingot_fft_sliding_destroy(LingotSlidingDFT* sdft) {
+    if (!sdft->in_arena) {
+        free(sdft->wn);
+        free(sdft->X);
+    }
+}
+
+size_t lingot_fft_sliding_arena_size(unsigned int n) {
+    return 2 * lingot_arena_block_size(((n >> 1) + 1) * sizeof(LingotComplex));
+}
+
+void lingot_fft_sliding_resync(LingotSlidingDFT* sdft, const LingotComplex* fft) {
+    memcpy(sdft->X, fft, sdft->n_bins * sizeof(LingotComplex));
+    sdft->synced = 1;
+    sdft->samples_since_resync = 0;
+}
+
+static double lingot_fft_cpu_time(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+    return t.tv_sec + 1e-9 * t.tv_nsec;
+}
+
+// exponential average of the measured costs, the first one is taken as is.
+static FLT lingot_fft_average_time(FLT average, FLT time) {
+    return (average > 0.0) ? average + 0.1 * (time - average) : time;
+}
+
+void lingot_fft_sliding_resync_dft(LingotSlidingDFT* sdft, LingotFFTPlan* plan) {
+    if (sdft->measure_costs) {
+        const double t0 = lingot_fft_cpu_time();
+        lingot_fft_compute_dft(plan);
+        sdft->fft_time = lingot_fft_average_time(sdft->fft_time,
+                                                 lingot_fft_cpu_time() - t0);
+    } else {
+        lingot_fft_compute_dft(plan);
+    }
+    lingot_fft_sliding_resync(sdft, (const LingotComplex*) plan->fft_out);
+}
+
+void lingot_fft_sliding_update(LingotSlidingDFT* sdft, const FLT* in, unsigned int n_samples) {
+
+    unsigned int k, i;
+    FLT Xr, Xi, Xr_old;
+    FLT wr, wi;
+    const FLT* in_old = in - sdft->n;
+    const double t0 = sdft->measure_costs ? lingot_fft_cpu_time() : 0.0;
+
+    // X_k <- (X_k + x[m] - x[m - n]) * e^(j*2*pi*k/n), for each new sample x[m].
+    // The loops are arranged bin by bin in order to keep the accumulators
+    // and the phase factor in registers.
+    for (k = 0; k < sdft->n_bins; k++) {
+
+        Xr = sdft->X[k][0];
+        Xi = sdft->X[k][1];
+        wr = sdft->wn[k][0];
+        wi = sdft->wn[k][1];
+
+        for (i = 0; i < n_samples; i++) {
+            Xr_old = Xr + in[i] - in_old[i];
+            Xr = Xr_old * wr - Xi * wi;
+            Xi = Xr_old * wi + Xi * wr;
+        }
+
+        sdft->X[k][0] = Xr;
+        sdft->X[k][1] = Xi;
+    }
+
+    if (sdft->measure_costs && (n_samples > 0)) {
+        sdft->update_time = lingot_fft_average_time(sdft->update_time,
+                                                    (lingot_fft_cpu_time() - t0)
+                                                    / ((FLT) n_samples * sdft->n_bins));
+    }
+
+    sdft->samples_since_resync += n_samples;
+}
+
+int lingot_fft_sliding_is_worth(const LingotSlidingDFT* sdft, unsigned int n_samples,
+                                unsigned int resync_period) {
+
+    FLT fft_time = sdft->fft_time;
+    FLT update_time = sdft->update_time;
+
+    if (n_samples > sdft->n) {
+        return 0;
+    }
+
+    // until both costs have been measured, a fresh FFT is taken as 2.2 (n/2)
+    // log2(n) times the cost of sliding one sample over one bin, as measured
+    // with the built-in FFT for n from 256 to 65536.
+    if ((fft_time <= 0.0) || (update_time <= 0.0)) {
+        unsigned int log2_n = 0;
+        while ((1u << log2_n) < sdft->n) {
+            log2_n++;
+        }
+        fft_time = 2.2 * (sdft->n >> 1) * log2_n;
+        update_time = 1.0;
+    }
+
+    // the periodic resynchronizations are part of the cost of sliding.
+    const FLT sliding_time = n_samples * (sdft->n_bins * update_time
+                                          + fft_time / resync_period);
+
+    return sliding_time < fft_time;
+}
+
+void lingot_fft_sliding_window(const LingotSlidingDFT* sdft, window_type_t window_type,
+                               LingotComplex* out) {
+
+    unsigned int k;
+    FLT a, b;
+    const unsigned int last = sdft->n_bins - 1;
+    const LingotComplex* X = (const LingotComplex*) sdft->X;
+
+    // the windows a - b*cos(2*pi*n/N) are three-tap kernels in the frequency
+    // domain: Y_k = a*X_k - (b/2)*(X_(k-1) + X_(k+1)).
+    switch (window_type) {
+    case HANNING:
+        a = 0.5;
+        b = 0.5;
+        break;
+    case HAMMING:
+        a = 0.53836;
+        b = 0.46164;
+        break;
+    default:
+        memcpy(out, sdft->X, sdft->n_bins * sizeof(LingotComplex));
+        return;
+    }
+
+    b *= 0.5;
+
+    // the real signal spectrum is hermitian, so X_(-1) = conj(X_1) and
+    // X_(n/2 + 1) = conj(X_(n/2 - 1)).
+    out[0][0] = a * X[0][0] - 2.0 * b * X[1][0];
+    out[0][1] = 0.0;
+    for (k = 1; k < last; k++) {
+        out[k][0] = a * X[k][0] - b * (X[k - 1][0] + X[k + 1][0]);
+        out[k][1] = a * X[k][1] - b * (X[k - 1][1] + X[k + 1][1]);
+    }
+    out[last][0] = a * X[last][0] - 2.0 * b * X[last - 1][0];
+    out[last][1] = 0.0;
+}
+
+void lingot_fft_dft_bin(const FLT* in, const FLT* window, unsigned int n,
+                        unsigned int k, LingotComplex out) {
+
+    unsigned int i;
+    FLT x, cr;
+    FLT Xr = 0.0;
+    FLT Xi = 0.0;
+
+    // e^(-j*2*pi*k*i/n) by recurrence.
+    const FLT wr = cos(2.0 * M_PI * k / n);
+    const FLT wi = -sin(2.0 * M_PI * k / n);
+    FLT cr_i = 1.0;
+    FLT ci_i = 0.0;
+
+    for (i = 0; i < n; i++) {
+        x = (window == NULL) ? in[i] : in[i] * window[i];
+        Xr += x * cr_i;
+        Xi += x * ci_i;
+        cr = cr_i * wr - ci_i * wi;
+        ci_i = cr_i * wi + ci_i * wr;
+        cr_i = cr;
+    }
+
+    out[0] = Xr;
+    out[1] = Xi;
+}
+
 /* Spectral Power Distribution esteem, selectively in frequency, by DFT.
  transforms signal in of N1 samples from frequency wi, with sample
  separation of dw rads, storing the result on buffer out with N2 samples. */
@@ -169,7 +454,7 @@ void lingot_fft_spd_diffs_eval(const FLT* in, unsigned int N, FLT w, FLT* out_d0
                                FLT* out_d1, FLT* out_d2) {
     FLT x_cos_wn;
     FLT x_sin_wn;
-    const FLT N2 = N * N;
+    const FLT N2 = (FLT) N * N;
 
     unsigned int n;
 
@@ -193,7 +478,7 @@ void lingot_fft_spd_diffs_eval(const FLT* in, unsigned int N, FLT w, FLT* out_d0
         SUM_x_n2_cos_wn += x_cos_wn * n * n;
     }
 
-    FLT N_2 = N * N;
+    const FLT N_2 = N2;
     *out_d0 = (SUM_x_cos_wn * SUM_x_cos_wn + SUM_x_sin_wn * SUM_x_sin_wn) / N2;
     *out_d1 = 2.0
             * (SUM_x_sin_wn * SUM_x_n_cos_wn - SUM_x_cos_wn * SUM_x_n_sin_wn)
@@ -203,3 +488,92 @@ void lingot_fft_spd_diffs_eval(const FLT* in, unsigned int N, FLT w, FLT* out_d0
                + SUM_x_n_sin_wn * SUM_x_n_sin_wn
                - SUM_x_cos_wn * SUM_x_n2_cos_wn) / N_2;
 }
+
+// samples between exact evaluations of the recurrences, that bounds the
+// accumulated rounding error.
+#define LINGOT_FFT_RECURRENCE_BLOCK 1024
+
+void lingot_fft_spd_diffs_eval_windowed(const FLT* in, window_type_t window_type,
+                                        unsigned int N, FLT w, FLT* out_d0,
+                                        FLT* out_d1, FLT* out_d2) {
+    FLT a, b;
+    FLT x, x_cos_wn, x_sin_wn, tmp;
+    FLT cos_wn = 1.0, sin_wn = 0.0; // e^(j*w*n)
+    FLT cos_vn = 1.0, sin_vn = 0.0; // e^(j*v*n), v being the window step.
+    const FLT N2 = (FLT) N * N;
+
+    unsigned int n, block_end;
+
+    // the windows a - b*cos(2*pi*n/(N - 1)).
+    switch (window_type) {
+    case HANNING:
+        a = 0.5;
+        b = 0.5;
+        break;
+    case HAMMING:
+        a = 0.53836;
+        b = 0.46164;
+        break;
+    default:
+        a = 1.0;
+        b = 0.0;
+        break;
+    }
+
+    const FLT v = (N > 1) ? 2.0 * M_PI / (N - 1) : 0.0;
+    const FLT cos_w = cos(w);
+    const FLT sin_w = sin(w);
+    const FLT cos_v = cos(v);
+    const FLT sin_v = sin(v);
+
+    FLT SUM_x_sin_wn = 0.0;
+    FLT SUM_x_cos_wn = 0.0;
+    FLT SUM_x_n_sin_wn = 0.0;
+    FLT SUM_x_n_cos_wn = 0.0;
+    FLT SUM_x_n2_sin_wn = 0.0;
+    FLT SUM_x_n2_cos_wn = 0.0;
+
+    for (n = 0; n < N; n = block_end) {
+
+        block_end = n + LINGOT_FFT_RECURRENCE_BLOCK;
+        if (block_end > N) {
+            block_end = N;
+        }
+
+        cos_wn = cos(w * n);
+        sin_wn = sin(w * n);
+        cos_vn = cos(v * n);
+        sin_vn = sin(v * n);
+
+        for (; n < block_end; n++) {
+
+            x = in[n] * (a - b * cos_vn);
+            x_cos_wn = x * cos_wn;
+            x_sin_wn = x * sin_wn;
+
+            SUM_x_sin_wn += x_sin_wn;
+            SUM_x_cos_wn += x_cos_wn;
+            SUM_x_n_sin_wn += x_sin_wn * n;
+            SUM_x_n_cos_wn += x_cos_wn * n;
+            SUM_x_n2_sin_wn += x_sin_wn * n * n;
+            SUM_x_n2_cos_wn += x_cos_wn * n * n;
+
+            tmp = cos_wn * cos_w - sin_wn * sin_w;
+            sin_wn = sin_wn * cos_w + cos_wn * sin_w;
+            cos_wn = tmp;
+
+            tmp = cos_vn * cos_v - sin_vn * sin_v;
+            sin_vn = sin_vn * cos_v + cos_vn * sin_v;
+            cos_vn = tmp;
+        }
+    }
+
+    *out_d0 = (SUM_x_cos_wn * SUM_x_cos_wn + SUM_x_sin_wn * SUM_x_sin_wn) / N2;
+    *out_d1 = 2.0
+            * (SUM_x_sin_wn * SUM_x_n_cos_wn - SUM_x_cos_wn * SUM_x_n_sin_wn)
+            / N2;
+    *out_d2 = 2.0
+            * (SUM_x_n_cos_wn * SUM_x_n_cos_wn - SUM_x_sin_wn * SUM_x_n2_sin_wn
+               + SUM_x_n_sin_wn * SUM_x_n_sin_wn
+               - SUM_x_cos_wn * SUM_x_n2_cos_wn) / N2;
+}
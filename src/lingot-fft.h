@@ -30,12 +30,14 @@
  */
 
 #include "lingot-defs.h"
+#include "lingot-config.h"
 
 #ifdef LIBFFTW
 # include <fftw3.h>
 #endif
 
 # include "lingot-complex.h"
+#include "lingot-arena.h"
 
 typedef struct {
 
@@ -49,14 +51,88 @@ typedef struct {
     LingotComplex* wn;
 #endif
     LingotComplex* fft_out; // complex signal in freq.
+
+    int in_arena; // whether the buffers belong to an arena.
 } LingotFFTPlan;
 
-void lingot_fft_plan_create(LingotFFTPlan*, FLT* in, unsigned int n);
+// Sliding DFT, it updates the first n/2 + 1 bins of the (unwindowed) DFT of
+// the latest n samples with O(n) operations per new sample.
+typedef struct {
+
+    unsigned int n;
+    unsigned int n_bins; // n/2 + 1
+
+    LingotComplex* wn; // phase factors e^(j*2*pi*k/n).
+    LingotComplex* X; // current unwindowed DFT.
+
+    int synced; // whether X holds valid data.
+    unsigned int samples_since_resync;
+
+    // CPU time taken by a fresh FFT, and by sliding one sample over one bin,
+    // averaged over the latest passes (seconds, 0 until measured).
+    FLT fft_time;
+    FLT update_time;
+    // whether the costs above are measured (1 by default). Otherwise only
+    // the cost model is used, so that the results are reproducible.
+    int measure_costs;
+
+    int in_arena; // whether the buffers belong to an arena.
+} LingotSlidingDFT;
+
+// the buffers are taken from the given arena, or allocated if it is NULL.
+void lingot_fft_plan_create(LingotFFTPlan*, FLT* in, unsigned int n,
+                            LingotArena* arena);
 void lingot_fft_plan_destroy(LingotFFTPlan*);
 
+// arena space taken by a plan of size n.
+size_t lingot_fft_plan_arena_size(unsigned int n);
+
+// DFT of the plan input, stored in fft_out.
+void lingot_fft_compute_dft(LingotFFTPlan*);
+
+// Spectral Power Distribution (SPD) esteem from the last computed DFT.
+void lingot_fft_compute_spd(LingotFFTPlan*, FLT* out, unsigned int n_out);
+
+// same as lingot_fft_compute_spd(), only for the bins from first to last - 1.
+void lingot_fft_compute_spd_range(LingotFFTPlan*, FLT* out, unsigned int first,
+                                  unsigned int last);
+
 // Full Spectral Power Distribution (SPD) esteem.
 void lingot_fft_compute_dft_and_spd(LingotFFTPlan*, FLT* out, unsigned int n_out);
 
+void lingot_fft_sliding_create(LingotSlidingDFT*, unsigned int n,
+                               LingotArena* arena);
+void lingot_fft_sliding_destroy(LingotSlidingDFT*);
+
+// arena space taken by a sliding DFT of size n.
+size_t lingot_fft_sliding_arena_size(unsigned int n);
+
+// sets the sliding DFT state from the unwindowed DFT given in fft.
+void lingot_fft_sliding_resync(LingotSlidingDFT*, const LingotComplex* fft);
+
+// computes the DFT of the plan input and sets the sliding DFT state from it,
+// measuring the cost of the FFT.
+void lingot_fft_sliding_resync_dft(LingotSlidingDFT*, LingotFFTPlan*);
+
+// slides the DFT over the n_samples samples starting at in. The n samples
+// preceding in must also be accessible, since they leave the window.
+void lingot_fft_sliding_update(LingotSlidingDFT*, const FLT* in, unsigned int n_samples);
+
+// tells whether sliding over n_samples samples is cheaper than a fresh FFT,
+// given that the sliding DFT is resynchronized with a fresh FFT every
+// resync_period samples.
+int lingot_fft_sliding_is_worth(const LingotSlidingDFT*, unsigned int n_samples,
+                                unsigned int resync_period);
+
+// applies the given window in the frequency domain and stores the first
+// n/2 + 1 bins in out.
+void lingot_fft_sliding_window(const LingotSlidingDFT*, window_type_t window_type,
+                               LingotComplex* out);
+
+// single DFT bin k of the n samples in, optionally windowed (window may be NULL).
+void lingot_fft_dft_bin(const FLT* in, const FLT* window, unsigned int n,
+                        unsigned int k, LingotComplex out);
+
 // Spectral Power Distribution (SPD) evaluation at a given frequency.
 void lingot_fft_spd_eval(FLT* in, unsigned int N1, FLT wi, FLT dw, FLT* out, unsigned int N2);
 
@@ -64,4 +140,11 @@ void lingot_fft_spd_eval(FLT* in, unsigned int N1, FLT wi, FLT dw, FLT* out, uns
 void lingot_fft_spd_diffs_eval(const FLT* in, unsigned int N, FLT w, FLT* out_d0,
                                FLT* out_d1, FLT* out_d2);
 
+// same as lingot_fft_spd_diffs_eval() on the N samples in multiplied by the
+// given window, which is applied on the fly instead of being stored. The
+// window and the complex exponential are computed by recurrence.
+void lingot_fft_spd_diffs_eval_windowed(const FLT* in, window_type_t window_type,
+                                        unsigned int N, FLT w, FLT* out_d0,
+                                        FLT* out_d1, FLT* out_d2);
+
 #endif
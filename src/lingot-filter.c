@@ -68,27 +68,83 @@ void lingot_filter_destroy(LingotFilter* filter) {
     free(filter->s);
 }
 
-// Digital Filter Implementation II, in & out can overlap.
-void lingot_filter_filter(LingotFilter* filter, unsigned int n, const FLT* in,
-                          FLT* out) {
-    FLT w, y;
+// maximum order with a specialized kernel.
+#define LINGOT_FILTER_MAX_FIXED_ORDER 8
+
+// Transposed Direct Form II kernel for an order N known at compile time, so
+// that the inner loops get unrolled and the status and coefs are kept in
+// registers along the block.
+static inline void lingot_filter_filter_fixed_order(LingotFilter* filter,
+                                                    const unsigned int N,
+                                                    unsigned int n,
+                                                    const FLT* in, FLT* out) {
+    FLT a[LINGOT_FILTER_MAX_FIXED_ORDER + 1];
+    FLT b[LINGOT_FILTER_MAX_FIXED_ORDER + 1];
+    FLT s[LINGOT_FILTER_MAX_FIXED_ORDER];
+    FLT x, y;
     register unsigned int i;
-    register int j;
+    unsigned int j;
+
+    for (j = 0; j <= N; j++) {
+        a[j] = filter->a[j];
+        b[j] = filter->b[j];
+    }
+    for (j = 0; j < N; j++) {
+        s[j] = filter->s[j];
+    }
 
     for (i = 0; i < n; i++) {
+        x = in[i];
+        y = b[0] * x + s[0];
+        for (j = 0; j < N - 1; j++) {
+            s[j] = b[j + 1] * x - a[j + 1] * y + s[j + 1];
+        }
+        s[N - 1] = b[N] * x - a[N] * y;
+        out[i] = y;
+    }
+
+    for (j = 0; j < N; j++) {
+        filter->s[j] = s[j];
+    }
+}
 
-        w = in[i];
-        y = 0.0;
+// Transposed Direct Form II, in & out can overlap.
+void lingot_filter_filter(LingotFilter* filter, unsigned int n, const FLT* in,
+                          FLT* out) {
+    FLT x, y;
+    register unsigned int i;
+    unsigned int j;
+    const unsigned int N = filter->N;
+
+    switch (N) {
+    case 1:
+        lingot_filter_filter_fixed_order(filter, 1, n, in, out);
+        return;
+    case 2:
+        lingot_filter_filter_fixed_order(filter, 2, n, in, out);
+        return;
+    case 8:
+        lingot_filter_filter_fixed_order(filter, 8, n, in, out);
+        return;
+    default:
+        break;
+    }
 
-        for (j = filter->N - 1; j >= 0; j--) {
-            w -= filter->a[j + 1] * filter->s[j];
-            y += filter->b[j + 1] * filter->s[j];
-            filter->s[j + 1] = filter->s[j];
+    if (N == 0) {
+        for (i = 0; i < n; i++) {
+            out[i] = filter->b[0] * in[i];
         }
+        return;
+    }
 
-        y += w * filter->b[0];
-        filter->s[0] = w;
-
+    for (i = 0; i < n; i++) {
+        x = in[i];
+        y = filter->b[0] * x + filter->s[0];
+        for (j = 0; j < N - 1; j++) {
+            filter->s[j] = filter->b[j + 1] * x - filter->a[j + 1] * y
+                    + filter->s[j + 1];
+        }
+        filter->s[N - 1] = filter->b[N] * x - filter->a[N] * y;
         out[i] = y;
     }
 }
@@ -118,20 +174,12 @@ void lingot_filter_vector_product(int n, LingotComplex* vector,
 
 }
 
-// Chebyshev filters
-void lingot_filter_cheby_design(LingotFilter* filter, unsigned int n, FLT Rp, FLT wc) {
+// Chebyshev filters, z-plane poles. Returns the overall gain.
+static FLT lingot_filter_cheby_poles(unsigned int n, FLT Rp, FLT wc,
+                                     LingotComplex* pole) {
     unsigned int i; // loops
     unsigned int k;
-    unsigned int p;
-
-    FLT a[n + 1];
-    FLT b[n + 1];
-
-    FLT new_a[n + 1];
-    FLT new_b[n + 1];
-
-    // locate poles
-    LingotComplex pole[n];
+    int j;
 
     for (i = 0; i < n; i++) {
         pole[i][0] = 0.0;
@@ -150,8 +198,8 @@ void lingot_filter_cheby_design(LingotFilter* filter, unsigned int n, FLT Rp, FL
 
     FLT t;
 
-    for (i = -(n - 1), k = 0; k < n; i += 2, k++) {
-        t = M_PI * i / (2.0 * n);
+    for (j = -((int) n - 1), k = 0; k < n; j += 2, k++) {
+        t = M_PI * j / (2.0 * n);
         pole[k][0] = -sv0 * cos(t);
         pole[k][1] = cv0 * sin(t);
     }
@@ -197,6 +245,23 @@ void lingot_filter_cheby_design(LingotFilter* filter, unsigned int n, FLT Rp, FL
         lingot_complex_div(tmp1, aux2, pole[i]);
     }
 
+    return fabs(gain[0]);
+}
+
+void lingot_filter_cheby_design(LingotFilter* filter, unsigned int n, FLT Rp, FLT wc) {
+    unsigned int i; // loops
+    unsigned int p;
+
+    FLT a[n + 1];
+    FLT b[n + 1];
+
+    FLT new_a[n + 1];
+    FLT new_b[n + 1];
+
+    // locate poles
+    LingotComplex pole[n];
+    FLT gain = lingot_filter_cheby_poles(n, Rp, wc, pole);
+
     // compute filter coefficients from pole/zero values
     a[0] = 1.0;
     b[0] = 1.0;
@@ -239,10 +304,124 @@ void lingot_filter_cheby_design(LingotFilter* filter, unsigned int n, FLT Rp, FL
         }
     }
 
-    gain[0] = fabs(gain[0]);
     for (i = 0; i <= n; i++) {
-        b[i] *= gain[0];
+        b[i] *= gain;
     }
 
     lingot_filter_new(filter, n, n, a, b);
 }
+
+//----------------------------------------------------------------------------
+
+void lingot_filter_sos_new(LingotFilterSOS* filter, unsigned int n_sections,
+                           const FLT* coefs, LingotArena* arena) {
+    filter->n_sections = n_sections;
+    filter->in_arena = (arena != NULL);
+    if (arena) {
+        // the status, written with every sample, is kept apart from the
+        // coefficients.
+        filter->coefs = lingot_arena_alloc(arena, 5 * n_sections * sizeof(FLT));
+        filter->s = lingot_arena_alloc(arena, 2 * n_sections * sizeof(FLT));
+    } else {
+        filter->coefs = malloc(5 * n_sections * sizeof(FLT));
+        filter->s = malloc(2 * n_sections * sizeof(FLT));
+    }
+
+    memcpy(filter->coefs, coefs, 5 * n_sections * sizeof(FLT));
+    lingot_filter_sos_reset(filter);
+}
+
+void lingot_filter_sos_reset(LingotFilterSOS* filter) {
+    memset(filter->s, 0, 2 * filter->n_sections * sizeof(FLT));
+}
+
+void lingot_filter_sos_destroy(LingotFilterSOS* filter) {
+    if (!filter->in_arena) {
+        free(filter->coefs);
+        free(filter->s);
+    }
+}
+
+size_t lingot_filter_sos_arena_size(unsigned int n_sections) {
+    return lingot_arena_block_size(5 * n_sections * sizeof(FLT))
+            + lingot_arena_block_size(2 * n_sections * sizeof(FLT));
+}
+
+void lingot_filter_cheby_design_sos(LingotFilterSOS* filter, unsigned int n,
+                                    FLT Rp, FLT wc, LingotArena* arena) {
+    unsigned int p;
+    const unsigned int n_sections = (n + 1) / 2;
+    FLT coefs[5 * n_sections];
+    FLT* c = coefs;
+    FLT residual_gain;
+
+    // locate poles
+    LingotComplex pole[n];
+    residual_gain = lingot_filter_cheby_poles(n, Rp, wc, pole);
+
+    // each section is normalized to unit DC gain, and the remaining gain is
+    // spread evenly, in order to keep the intermediate signals in range.
+    if (n & 1) {  // odd
+        // first subfilter is first order
+        c[3] = -pole[n / 2][0];
+        c[4] = 0.0;
+        c[0] = (1.0 + c[3]) / 2.0;
+        c[1] = c[0];
+        c[2] = 0.0;
+        residual_gain /= c[0];
+        c += 5;
+    }
+
+    // a section per conjugate pair
+    for (p = 0; p < n / 2; p++, c += 5) {
+        c[3] = -2.0 * pole[p][0];
+        c[4] = pole[p][0] * pole[p][0] + pole[p][1] * pole[p][1];
+        c[0] = (1.0 + c[3] + c[4]) / 4.0;
+        c[1] = 2.0 * c[0];
+        c[2] = c[0];
+        residual_gain /= c[0];
+    }
+
+    residual_gain = pow(residual_gain, 1.0 / n_sections);
+    for (p = 0, c = coefs; p < n_sections; p++, c += 5) {
+        c[0] *= residual_gain;
+        c[1] *= residual_gain;
+        c[2] *= residual_gain;
+    }
+
+    lingot_filter_sos_new(filter, n_sections, coefs, arena);
+}
+
+// Transposed Direct Form II, section by section, in & out can overlap.
+void lingot_filter_sos_filter(LingotFilterSOS* filter, unsigned int n,
+                              const FLT* in, FLT* out) {
+    register unsigned int i;
+    unsigned int k;
+    const FLT* x = in;
+    FLT y;
+
+    for (k = 0; k < filter->n_sections; k++) {
+
+        const FLT* c = &filter->coefs[5 * k];
+        const FLT b0 = c[0];
+        const FLT b1 = c[1];
+        const FLT b2 = c[2];
+        const FLT a1 = c[3];
+        const FLT a2 = c[4];
+        FLT s1 = filter->s[2 * k];
+        FLT s2 = filter->s[2 * k + 1];
+
+        for (i = 0; i < n; i++) {
+            y = b0 * x[i] + s1;
+            s1 = b1 * x[i] - a1 * y + s2;
+            s2 = b2 * x[i] - a2 * y;
+            out[i] = y;
+        }
+
+        filter->s[2 * k] = s1;
+        filter->s[2 * k + 1] = s2;
+
+        // the following sections work in place on the output.
+        x = out;
+    }
+}
@@ -29,6 +29,7 @@
 #include <stdlib.h>
 
 #include "lingot-defs.h"
+#include "lingot-arena.h"
 
 /*
  digital filtering implementation.
@@ -44,6 +45,18 @@ typedef struct {
 
 } LingotFilter;
 
+// cascade of second order sections (biquads).
+typedef struct {
+
+    FLT* coefs; // b0, b1, b2, a1, a2 for each section (a0 = 1).
+    FLT* s; // status, 2 values per section.
+
+    unsigned int n_sections;
+
+    int in_arena; // whether the buffers belong to an arena.
+
+} LingotFilterSOS;
+
 void lingot_filter_new(LingotFilter*, unsigned int Na, unsigned int Nb, const FLT* a,
                        const FLT* b);
 
@@ -57,11 +70,37 @@ void lingot_filter_cheby_design(LingotFilter*, unsigned int order, FLT Rp, FLT w
 
 void lingot_filter_destroy(LingotFilter*);
 
-// Digital Filter Implementation II, in & out can overlap. Vector filtering
+// Transposed Direct Form II, in & out can overlap. Vector filtering, with
+// specialized kernels for orders 1, 2 and 8.
 void lingot_filter_filter(LingotFilter*, unsigned int n, const FLT* in,
                           FLT* out);
 
 // sample filtering
 FLT lingot_filter_filter_sample(LingotFilter*, FLT in);
 
+// given the number of sections and their coefs (b0, b1, b2, a1, a2 each).
+// The buffers are taken from the given arena, or allocated if it is NULL.
+void lingot_filter_sos_new(LingotFilterSOS*, unsigned int n_sections,
+                           const FLT* coefs, LingotArena* arena);
+
+// arena space taken by a cascade of n_sections sections.
+size_t lingot_filter_sos_arena_size(unsigned int n_sections);
+
+void lingot_filter_sos_reset(LingotFilterSOS*);
+
+void lingot_filter_sos_destroy(LingotFilterSOS*);
+
+/**
+ * Same design as lingot_filter_cheby_design(), but as a cascade of second
+ * order sections, which is numerically robust for low cutoff frequencies.
+ * The buffers are taken from the given arena, or allocated if it is NULL.
+ */
+void lingot_filter_cheby_design_sos(LingotFilterSOS*, unsigned int order,
+                                    FLT Rp, FLT wc, LingotArena* arena);
+
+// Cascaded biquads in transposed Direct Form II, processed section by
+// section over the whole block. in & out can overlap.
+void lingot_filter_sos_filter(LingotFilterSOS*, unsigned int n, const FLT* in,
+                              FLT* out);
+
 #endif
@@ -22,6 +22,8 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <math.h>
+
 #include "lingot-gauge.h"
 
 void lingot_gauge_new(LingotGauge* gauge, FLT initial_position) {
@@ -69,6 +71,7 @@ void lingot_gauge_new(LingotGauge* gauge, FLT initial_position) {
     const FLT b[] = { k };
 
     lingot_filter_new(&gauge->filter, 2, 0, a, b);
+    gauge->pending_time = 0.0;
     lingot_gauge_compute(gauge, initial_position);
 }
 
@@ -79,3 +82,28 @@ void lingot_gauge_destroy(LingotGauge* gauge) {
 void lingot_gauge_compute(LingotGauge* gauge, FLT sample) {
     gauge->position = lingot_filter_filter_sample(&gauge->filter, sample);
 }
+
+int lingot_gauge_advance(LingotGauge* gauge, FLT sample, FLT elapsed_time) {
+
+    // after long pauses (e.g. the window was hidden) we don't try to catch up
+    // with more than one second.
+    static const FLT max_pending_time = 1.0;
+
+    gauge->pending_time += elapsed_time;
+    if (gauge->pending_time > max_pending_time) {
+        gauge->pending_time = max_pending_time;
+    }
+
+    // small tolerance so that the rounding of the frame times doesn't make
+    // us lose steps.
+    const FLT steps = gauge->pending_time * GAUGE_RATE;
+    int n = (int) floor(steps + 1e-6);
+    gauge->pending_time = fmax(0.0, (steps - n) / GAUGE_RATE);
+
+    int i;
+    for (i = 0; i < n; i++) {
+        lingot_gauge_compute(gauge, sample);
+    }
+
+    return n;
+}
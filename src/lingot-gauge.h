@@ -35,10 +35,16 @@
 typedef struct {
     LingotFilter filter;
     FLT position;
+    FLT pending_time; // elapsed time not yet integrated, in seconds
 } LingotGauge;
 
 void lingot_gauge_new(LingotGauge*, FLT);
 void lingot_gauge_destroy(LingotGauge*);
 void lingot_gauge_compute(LingotGauge*, FLT);
 
+// Integrates the gauge dynamics over the given elapsed time (in seconds),
+// in steps of 1/GAUGE_RATE, keeping the remainder for the next call. Returns
+// the number of steps taken, so that other filters can follow the same clock.
+int lingot_gauge_advance(LingotGauge*, FLT, FLT elapsed_time);
+
 #endif /*LINGOT_GAUGE_H*/
@@ -23,14 +23,17 @@
  */
 
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
 #include <math.h>
+#include <pthread.h>
 
 #include "lingot-gui-config-dialog.h"
 #include "lingot-gui-config-dialog-scale.h"
 #include "lingot-msg.h"
 #include "lingot-i18n.h"
 #include "lingot-io-config-scale.h"
+#include "lingot-io-scale-library.h"
 
 enum {
     COLUMN_NAME = 0,
@@ -511,6 +514,8 @@ void lingot_gui_config_dialog_scale_gui_to_data(const LingotConfigDialog* dialog
         scale->offset_ratios[1][i] = shift_den;
         i++;
     } while (gtk_tree_model_iter_next(model, &iter));
+
+    lingot_config_scale_update_index(scale);
 }
 
 void lingot_gui_config_dialog_scale_data_to_gui(LingotConfigDialog* dialog, const LingotScale* scale) {
@@ -524,12 +529,10 @@ void lingot_gui_config_dialog_scale_data_to_gui(LingotConfigDialog* dialog, cons
     int i;
     for (i = 0; i < scale->notes; i++) {
         gtk_tree_store_append(store, &iter2, NULL);
-        FLT freq = scale->base_frequency
-                * pow(2.0, scale->offset_cents[i] / 1200.0);
         lingot_config_scale_format_shift(buff, scale->offset_cents[i],
                                          scale->offset_ratios[0][i], scale->offset_ratios[1][i]);
         gtk_tree_store_set(store, &iter2, COLUMN_NAME, scale->note_name[i],
-                           COLUMN_SHIFT, buff, COLUMN_FREQUENCY, freq, -1);
+                           COLUMN_SHIFT, buff, COLUMN_FREQUENCY, scale->note_frequency[i], -1);
     }
 }
 
@@ -582,6 +585,266 @@ void lingot_gui_config_dialog_import_scl(gpointer data,
     //g_free(filefilter);
 }
 
+// the scale library is loaded from its index the first time it is browsed,
+// and kept for the rest of the session
+static LingotScaleLibrary scale_library;
+static int scale_library_loaded = 0;
+
+#define SCALE_LIBRARY_MAX_RESULTS 1000
+
+enum {
+    LIBRARY_COLUMN_NAME = 0,
+    LIBRARY_COLUMN_NOTES = 1,
+    LIBRARY_COLUMN_INDEX = 2,
+    LIBRARY_NUM_COLUMNS = 3
+};
+
+typedef struct {
+    GtkListStore* store;
+    GtkEntry* search_entry;
+    GtkFileChooser* folder_chooser;
+    GtkWidget* rescan_button;
+    GtkLabel* status_label;
+
+    // the folder is scanned in a separate thread, polled from a timeout.
+    pthread_t scan_thread;
+    guint scan_timeout_uid; // 0 if no scan is running
+    int scan_done; // set by the scan thread
+    gchar* scan_directory;
+    LingotScaleLibrary scan_result;
+} LingotScaleLibraryBrowser;
+
+static void lingot_gui_config_dialog_scale_library_index_filename(char* buff,
+                                                                   size_t size) {
+    snprintf(buff, size, "%s/" CONFIG_DIR_NAME SCALE_LIBRARY_INDEX_FILE_NAME,
+             getenv("HOME"));
+}
+
+static void lingot_gui_config_dialog_scale_library_filter(
+        LingotScaleLibraryBrowser* browser) {
+    static unsigned int results[SCALE_LIBRARY_MAX_RESULTS];
+    GtkTreeIter iter;
+    char buff[100];
+    unsigned int i;
+
+    unsigned int n = lingot_scale_library_search(&scale_library,
+                                                 gtk_entry_get_text(browser->search_entry), results,
+                                                 SCALE_LIBRARY_MAX_RESULTS);
+
+    gtk_list_store_clear(browser->store);
+    for (i = 0; i < n; i++) {
+        const LingotScaleLibraryEntry* entry = &scale_library.entries[results[i]];
+        gtk_list_store_append(browser->store, &iter);
+        gtk_list_store_set(browser->store, &iter, LIBRARY_COLUMN_NAME, entry->name,
+                           LIBRARY_COLUMN_NOTES, (guint) entry->notes,
+                           LIBRARY_COLUMN_INDEX, results[i], -1);
+    }
+
+    snprintf(buff, sizeof(buff), _("%u of %u scales"), n, scale_library.n_entries);
+    gtk_label_set_text(browser->status_label, buff);
+}
+
+static void lingot_gui_config_dialog_scale_library_search_changed(GtkWidget* widget,
+                                                                  LingotScaleLibraryBrowser* browser) {
+    (void)widget;           //  Unused parameter.
+    lingot_gui_config_dialog_scale_library_filter(browser);
+}
+
+static void* lingot_gui_config_dialog_scale_library_scan_thread(void* arg) {
+    LingotScaleLibraryBrowser* browser = (LingotScaleLibraryBrowser*) arg;
+    // the current library is only read meanwhile, by both threads.
+    lingot_scale_library_scan_from(&browser->scan_result, &scale_library,
+                                   browser->scan_directory);
+    __atomic_store_n(&browser->scan_done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+// takes the result of the scan thread, waiting for it if needed.
+static void lingot_gui_config_dialog_scale_library_scan_finish(
+        LingotScaleLibraryBrowser* browser) {
+    char index_filename[1000];
+
+    pthread_join(browser->scan_thread, NULL);
+    browser->scan_timeout_uid = 0;
+    g_free(browser->scan_directory);
+    browser->scan_directory = NULL;
+
+    lingot_scale_library_destroy(&scale_library);
+    scale_library = browser->scan_result;
+
+    lingot_gui_config_dialog_scale_library_index_filename(index_filename,
+                                                           sizeof(index_filename));
+    if (!lingot_scale_library_save_index(&scale_library, index_filename)) {
+        lingot_msg_add_warning(_("The scale library index could not be saved"));
+    }
+}
+
+static gboolean lingot_gui_config_dialog_scale_library_scan_poll(gpointer data) {
+    LingotScaleLibraryBrowser* browser = (LingotScaleLibraryBrowser*) data;
+
+    if (!__atomic_load_n(&browser->scan_done, __ATOMIC_ACQUIRE)) {
+        return G_SOURCE_CONTINUE;
+    }
+
+    lingot_gui_config_dialog_scale_library_scan_finish(browser);
+    gtk_widget_set_sensitive(GTK_WIDGET(browser->folder_chooser), TRUE);
+    gtk_widget_set_sensitive(browser->rescan_button, TRUE);
+    lingot_gui_config_dialog_scale_library_filter(browser);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void lingot_gui_config_dialog_scale_library_scan(GtkWidget* widget,
+                                                        LingotScaleLibraryBrowser* browser) {
+    (void)widget;           //  Unused parameter.
+
+    if (browser->scan_timeout_uid) {
+        return;
+    }
+
+    gchar* directory = gtk_file_chooser_get_filename(browser->folder_chooser);
+    if (directory == NULL) {
+        return;
+    }
+
+    browser->scan_directory = directory;
+    browser->scan_done = 0;
+    lingot_scale_library_new(&browser->scan_result);
+    if (pthread_create(&browser->scan_thread, NULL,
+                       lingot_gui_config_dialog_scale_library_scan_thread, browser)) {
+        g_free(browser->scan_directory);
+        browser->scan_directory = NULL;
+        lingot_msg_add_warning(_("The scale library could not be scanned"));
+        return;
+    }
+
+    // the library can still be searched while scanning.
+    gtk_widget_set_sensitive(GTK_WIDGET(browser->folder_chooser), FALSE);
+    gtk_widget_set_sensitive(browser->rescan_button, FALSE);
+    gtk_label_set_text(browser->status_label, _("Scanning..."));
+    browser->scan_timeout_uid = g_timeout_add(100,
+                                              lingot_gui_config_dialog_scale_library_scan_poll, browser);
+}
+
+static void lingot_gui_config_dialog_scale_library_row_activated(GtkTreeView* view,
+                                                                 GtkTreePath* path, GtkTreeViewColumn* column,
+                                                                 GtkDialog* dialog) {
+    (void)view;             //  Unused parameter.
+    (void)path;             //  Unused parameter.
+    (void)column;           //  Unused parameter.
+    gtk_dialog_response(dialog, GTK_RESPONSE_ACCEPT);
+}
+
+void lingot_gui_config_dialog_scale_library(gpointer data,
+                                            LingotConfigDialog* config_dialog) {
+    (void)data;             //  Unused parameter.
+    LingotScaleLibraryBrowser browser;
+    char index_filename[1000];
+
+    if (!scale_library_loaded) {
+        lingot_scale_library_new(&scale_library);
+        lingot_gui_config_dialog_scale_library_index_filename(index_filename,
+                                                               sizeof(index_filename));
+        lingot_scale_library_load_index(&scale_library, index_filename);
+        scale_library_loaded = 1;
+    }
+
+    GtkWidget* dialog = gtk_dialog_new_with_buttons(_("Scale Library"),
+                                                    GTK_WINDOW(config_dialog->win),
+                                                    GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+                                                    "_Cancel", GTK_RESPONSE_CANCEL, "_Open",
+                                                    GTK_RESPONSE_ACCEPT, NULL);
+    gtk_window_set_default_size(GTK_WINDOW(dialog), 500, 500);
+    GtkWidget* content = gtk_dialog_get_content_area(GTK_DIALOG(dialog));
+    gtk_box_set_spacing(GTK_BOX(content), 6);
+
+    GtkWidget* folder_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 6);
+    GtkWidget* folder_chooser = gtk_file_chooser_button_new(_("Scale Library Folder"),
+                                                             GTK_FILE_CHOOSER_ACTION_SELECT_FOLDER);
+    if (scale_library.directory != NULL) {
+        gtk_file_chooser_set_filename(GTK_FILE_CHOOSER(folder_chooser),
+                                      scale_library.directory);
+    }
+    GtkWidget* rescan_button = gtk_button_new_with_label(_("Rescan"));
+    gtk_widget_set_tooltip_text(rescan_button,
+                                _("Looks for new or modified .scl files in the library folder"));
+    gtk_box_pack_start(GTK_BOX(folder_box), gtk_label_new(_("Folder")), FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(folder_box), folder_chooser, TRUE, TRUE, 0);
+    gtk_box_pack_start(GTK_BOX(folder_box), rescan_button, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(content), folder_box, FALSE, FALSE, 0);
+
+    GtkWidget* search_entry = gtk_search_entry_new();
+    gtk_box_pack_start(GTK_BOX(content), search_entry, FALSE, FALSE, 0);
+
+    GtkListStore* store = gtk_list_store_new(LIBRARY_NUM_COLUMNS, G_TYPE_STRING,
+                                             G_TYPE_UINT, G_TYPE_UINT);
+    GtkWidget* view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(store));
+    gtk_tree_view_insert_column_with_attributes(GTK_TREE_VIEW(view), -1,
+                                                _("Name"), gtk_cell_renderer_text_new(), "text",
+                                                LIBRARY_COLUMN_NAME, NULL);
+    gtk_tree_view_insert_column_with_attributes(GTK_TREE_VIEW(view), -1,
+                                                _("Notes"), gtk_cell_renderer_text_new(), "text",
+                                                LIBRARY_COLUMN_NOTES, NULL);
+    GtkWidget* scroll = gtk_scrolled_window_new(NULL, NULL);
+    gtk_container_add(GTK_CONTAINER(scroll), view);
+    gtk_box_pack_start(GTK_BOX(content), scroll, TRUE, TRUE, 0);
+
+    GtkWidget* status_label = gtk_label_new("");
+    gtk_widget_set_halign(status_label, GTK_ALIGN_START);
+    gtk_box_pack_start(GTK_BOX(content), status_label, FALSE, FALSE, 0);
+
+    browser.store = store;
+    browser.search_entry = GTK_ENTRY(search_entry);
+    browser.folder_chooser = GTK_FILE_CHOOSER(folder_chooser);
+    browser.rescan_button = rescan_button;
+    browser.status_label = GTK_LABEL(status_label);
+    browser.scan_timeout_uid = 0;
+    browser.scan_directory = NULL;
+
+    g_signal_connect(G_OBJECT(search_entry), "search-changed",
+                     G_CALLBACK(lingot_gui_config_dialog_scale_library_search_changed), &browser);
+    g_signal_connect(G_OBJECT(folder_chooser), "file-set",
+                     G_CALLBACK(lingot_gui_config_dialog_scale_library_scan), &browser);
+    g_signal_connect(G_OBJECT(rescan_button), "clicked",
+                     G_CALLBACK(lingot_gui_config_dialog_scale_library_scan), &browser);
+    g_signal_connect(G_OBJECT(view), "row-activated",
+                     G_CALLBACK(lingot_gui_config_dialog_scale_library_row_activated), dialog);
+
+    lingot_gui_config_dialog_scale_library_filter(&browser);
+    gtk_widget_show_all(content);
+
+    if (gtk_dialog_run(GTK_DIALOG(dialog)) == GTK_RESPONSE_ACCEPT) {
+        GtkTreeModel* model;
+        GtkTreeIter iter;
+        guint index;
+
+        if (gtk_tree_selection_get_selected(
+                    gtk_tree_view_get_selection(GTK_TREE_VIEW(view)), &model, &iter)) {
+            gtk_tree_model_get(model, &iter, LIBRARY_COLUMN_INDEX, &index, -1);
+
+            // only the selected scale is parsed
+            LingotScale scale;
+            lingot_config_scale_new(&scale);
+            if (lingot_scale_library_load_scale(&scale_library, index, &scale)) {
+                lingot_gui_config_dialog_scale_data_to_gui(config_dialog, &scale);
+            } else {
+                lingot_msg_add_error(_("Error opening scale file"));
+            }
+            lingot_config_scale_destroy(&scale);
+        }
+    }
+
+    // the listed indexes refer to the current library, so a pending scan is
+    // only taken once the selected scale has been loaded.
+    if (browser.scan_timeout_uid) {
+        g_source_remove(browser.scan_timeout_uid);
+        lingot_gui_config_dialog_scale_library_scan_finish(&browser);
+    }
+
+    g_object_unref(G_OBJECT(store));
+    gtk_widget_destroy(dialog);
+}
+
 gint lingot_gui_config_dialog_scale_key_press_cb(GtkWidget *widget,
                                                  GdkEventKey *kevent, gpointer data) {
     (void)widget;           //  Unused parameter.
@@ -695,6 +958,8 @@ void lingot_gui_config_dialog_scale_show(LingotConfigDialog* dialog, GtkBuilder*
                 gtk_builder_get_object(builder, "button_scale_add"));
     GtkButton* button_import = GTK_BUTTON(
                 gtk_builder_get_object(builder, "button_scale_import"));
+    GtkButton* button_library = GTK_BUTTON(
+                gtk_builder_get_object(builder, "button_scale_library"));
 
     g_signal_connect(G_OBJECT(dialog->scale_treeview), "key_press_event",
                      G_CALLBACK(lingot_gui_config_dialog_scale_key_press_cb), dialog);
@@ -707,6 +972,8 @@ void lingot_gui_config_dialog_scale_show(LingotConfigDialog* dialog, GtkBuilder*
                      dialog->scale_treeview);
     g_signal_connect(G_OBJECT(button_import), "clicked",
                      G_CALLBACK( lingot_gui_config_dialog_import_scl), dialog);
+    g_signal_connect(G_OBJECT(button_library), "clicked",
+                     G_CALLBACK( lingot_gui_config_dialog_scale_library), dialog);
 
     gtk_widget_set_has_tooltip(GTK_WIDGET(dialog->scale_treeview), TRUE);
     g_signal_connect(G_OBJECT(dialog->scale_treeview), "query-tooltip",
@@ -23,6 +23,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <math.h>
 #include <unistd.h>
 #include <signal.h>
@@ -32,6 +33,7 @@
 #include "lingot-defs.h"
 
 #include "lingot-config.h"
+#include "lingot-calibration.h"
 #include "lingot-gui-mainframe.h"
 #include "lingot-gui-config-dialog.h"
 #include "lingot-gauge.h"
@@ -50,9 +52,23 @@ void lingot_gui_mainframe_draw_labels(const LingotMainFrame*);
 static int gauge_size_x = 0;
 static int gauge_size_y = 0;
 
+// the gauge background only depends on the size and on the scale, so it is
+// rendered once into an offscreen surface and composited on each frame.
+static cairo_surface_t* gauge_background = NULL;
+static int gauge_background_size_x = 0;
+static int gauge_background_size_y = 0;
+static FLT gauge_background_max_offset = 0.0;
+
 static int spectrum_size_x = 0;
 static int spectrum_size_y = 0;
 
+// cached spectrum grid and labels, which depend on the size and on the
+// maximum visible frequency.
+static cairo_surface_t* spectrum_background = NULL;
+static int spectrum_background_size_x = 0;
+static int spectrum_background_size_y = 0;
+static FLT spectrum_background_max_frequency = 0.0;
+
 static FLT spectrum_bottom_margin;
 static FLT spectrum_top_margin;
 static FLT spectrum_left_margin;
@@ -87,11 +103,26 @@ void lingot_gui_mainframe_callback_redraw_spectrum(GtkWidget* w, cairo_t *cr, co
     lingot_gui_mainframe_draw_spectrum(cr, frame);
 }
 
+void lingot_gui_mainframe_callback_redraw_spectrogram(GtkWidget* w, cairo_t *cr, const LingotMainFrame* frame) {
+    (void)w;                //  Unused parameter.
+    lingot_gui_spectrogram_draw(&frame->spectrogram, cr);
+}
+
+void lingot_gui_mainframe_callback_redraw_strobe(GtkWidget* w, cairo_t *cr, const LingotMainFrame* frame) {
+    LingotStrobeReadout readout;
+    GtkAllocation alloc;
+    gtk_widget_get_allocation(w, &alloc);
+    lingot_core_get_strobe(&frame->core, &readout);
+    lingot_gui_strobe_draw(&readout, cr, alloc.width, alloc.height);
+}
+
 void lingot_gui_mainframe_callback_destroy(GtkWidget* w, LingotMainFrame* frame) {
     (void)w;                //  Unused parameter.
-    g_source_remove(frame->visualization_timer_uid);
-    g_source_remove(frame->freq_computation_timer_uid);
-    g_source_remove(frame->gauge_computation_uid);
+    gtk_widget_remove_tick_callback(frame->win, frame->tick_callback_uid);
+    if (frame->error_dispatcher_uid) {
+        g_source_remove(frame->error_dispatcher_uid);
+        frame->error_dispatcher_uid = 0;
+    }
     gtk_main_quit();
 }
 
@@ -165,89 +196,236 @@ void lingot_gui_mainframe_callback_view_spectrum(GtkWidget* w, LingotMainFrame*
     gtk_widget_set_visible(frame->spectrum_frame, visible);
 }
 
+void lingot_gui_mainframe_callback_view_spectrogram(GtkWidget* w, LingotMainFrame* frame) {
+    (void)w;                //  Unused parameter.
+    gboolean visible = gtk_check_menu_item_get_active(
+                GTK_CHECK_MENU_ITEM(frame->view_spectrogram_item));
+    gtk_widget_set_visible(frame->spectrogram_area, visible);
+}
+
+void lingot_gui_mainframe_callback_view_strobe(GtkWidget* w, LingotMainFrame* frame) {
+    (void)w;                //  Unused parameter.
+    gboolean strobe = gtk_check_menu_item_get_active(
+                GTK_CHECK_MENU_ITEM(frame->view_strobe_item));
+    gtk_widget_set_visible(frame->gauge_area, !strobe);
+    gtk_widget_set_visible(frame->strobe_area, strobe);
+}
+
 void lingot_gui_mainframe_callback_config_dialog(GtkWidget* w,
                                                  LingotMainFrame* frame) {
     (void)w;                //  Unused parameter.
     lingot_gui_config_dialog_show(frame, NULL);
 }
 
-/* timeout for gauge and labels visualization */
-gboolean lingot_gui_mainframe_callback_tout_visualization(gpointer data) {
-    unsigned int period;
+/* integrates the gauge dynamics over the elapsed frame time */
+static void lingot_gui_mainframe_update_gauge(LingotMainFrame* frame,
+                                              FLT elapsed_time) {
 
-    LingotMainFrame* frame = (LingotMainFrame*) data;
+    const FLT freq = frame->snapshot->freq;
 
-    period = 1000 / frame->conf.visualization_rate;
-    frame->visualization_timer_uid = g_timeout_add(period,
-                                                   lingot_gui_mainframe_callback_tout_visualization, frame);
+    // ignore continuous component
+    if (!frame->core.running || isnan(freq)
+            || (freq <= frame->conf.internal_min_frequency)) {
+        frequency = 0.0;
+        lingot_gauge_advance(&frame->gauge, frame->conf.gauge_rest_value,
+                             elapsed_time);
+    } else {
+        FLT error_cents; // do not use, unfiltered
+        closest_note_index = lingot_config_scale_get_closest_note_index(
+                    &frame->conf.scale, freq,
+                    frame->conf.root_frequency_error, &error_cents);
+        // the gauge goes back to rest when the error cannot be measured.
+        int steps = lingot_gauge_advance(&frame->gauge,
+                                         isnan(error_cents) ? frame->conf.gauge_rest_value : error_cents,
+                                         elapsed_time);
+        // the displayed frequency is filtered on the gauge clock.
+        for (; steps > 0; steps--) {
+            frequency = lingot_filter_filter_sample(&frame->freq_filter, freq);
+        }
+    }
+}
 
-    gtk_widget_queue_draw(frame->gauge_area);
+/* tells whether a periodic task is due at the given frame time, and schedules
+ * the next one. The schedule doesn't drift, but it doesn't try to catch up
+ * either when we are late. Times in microseconds. */
+static int lingot_gui_mainframe_is_due(gint64 now, gint64* next, gint64 period) {
+    if (now < *next) {
+        return 0;
+    }
+    *next += period;
+    if (*next <= now) {
+        *next = now + period;
+    }
+    return 1;
+}
 
-    return 0;
+gboolean lingot_gui_mainframe_callback_error_dispatcher(gpointer data);
+
+static void* lingot_gui_mainframe_calibration_thread(void* arg) {
+    LingotMainFrame* frame = (LingotMainFrame*) arg;
+    lingot_calibration_run(&frame->calibration_conf);
+    __atomic_store_n(&frame->calibration_done, 1, __ATOMIC_RELEASE);
+    return NULL;
 }
 
-/* timeout for spectrum computation and display */
-gboolean lingot_gui_mainframe_callback_tout_spectrum_computation_display(
-        gpointer data) {
-    unsigned int period;
+/* the calibration takes a while, the tuner runs with the current parameters
+ meanwhile */
+static void lingot_gui_mainframe_start_calibration(LingotMainFrame* frame) {
+    if (frame->calibration_running || !lingot_calibration_is_due(&frame->conf)) {
+        return;
+    }
 
-    LingotMainFrame* frame = (LingotMainFrame*) data;
+    lingot_config_copy(&frame->calibration_conf, &frame->conf);
+    frame->calibration_done = 0;
+    if (pthread_create(&frame->calibration_thread, NULL,
+                       lingot_gui_mainframe_calibration_thread, frame) == 0) {
+        frame->calibration_running = 1;
+    } else {
+        lingot_config_destroy(&frame->calibration_conf);
+    }
+}
 
-    period = 1000 / frame->conf.calculation_rate;
-    frame->freq_computation_timer_uid = g_timeout_add(period,
-                                                      lingot_gui_mainframe_callback_tout_spectrum_computation_display,
-                                                      frame);
+/* takes the result of the finished calibration thread, the configuration may
+ have been changed by the user meanwhile */
+static void lingot_gui_mainframe_apply_calibration(LingotMainFrame* frame) {
+    LingotConfig conf;
 
-    gtk_widget_queue_draw(frame->spectrum_area);
-    lingot_gui_mainframe_draw_labels(frame);
+    pthread_join(frame->calibration_thread, NULL);
+    frame->calibration_running = 0;
 
-    return 0;
+    lingot_config_copy(&conf, &frame->conf);
+    const int applied = lingot_calibration_apply(&conf,
+                                                 &frame->calibration_conf);
+    lingot_config_destroy(&frame->calibration_conf);
+
+    if (applied) {
+        // the result is cached in the config file.
+        lingot_gui_mainframe_change_config(frame, &conf);
+        lingot_io_config_save(&frame->conf, CONFIG_FILE_NAME);
+    } else {
+        lingot_gui_mainframe_start_calibration(frame);
+    }
+    lingot_config_destroy(&conf);
+}
+
+// appends a column to the spectrogram for every analysis pass since the
+// previous tick. The passes are also taken while it is not visible, so that
+// it resumes with the latest ones.
+static void lingot_gui_mainframe_update_spectrogram(LingotMainFrame* frame, int visible) {
+
+    const unsigned int spd_size = frame->snapshot->spd_size;
+    LingotCoreSnapshot column = *frame->snapshot;
+    GtkAllocation alloc;
+    int appended = 0;
+
+    if (frame->spectrogram_column_size != spd_size) {
+        free(frame->spectrogram_column);
+        frame->spectrogram_column = malloc(spd_size * sizeof(FLT));
+        frame->spectrogram_column_size = frame->spectrogram_column ? spd_size : 0;
+    }
+
+    if (!frame->spectrogram_column_size) {
+        return;
+    }
+
+    column.SPL = frame->spectrogram_column;
+    if (visible) {
+        gtk_widget_get_allocation(frame->spectrogram_area, &alloc);
+    }
+
+    while (lingot_core_get_pass_spectrum(&frame->core, column.SPL, spd_size)) {
+        if (visible) {
+            lingot_gui_spectrogram_append(&frame->spectrogram, &column,
+                                          alloc.width, alloc.height);
+            appended = 1;
+        }
+    }
+
+    if (appended) {
+        gtk_widget_queue_draw(frame->spectrogram_area);
+    }
 }
 
-/* timeout for a new gauge position computation */
-gboolean lingot_gui_mainframe_callback_gauge_computation(gpointer data) {
-    unsigned int period;
+/* frame clock tick, drives all the periodic updates of the window */
+gboolean lingot_gui_mainframe_callback_tick(GtkWidget* widget,
+                                            GdkFrameClock* frame_clock, gpointer data) {
+
     LingotMainFrame* frame = (LingotMainFrame*) data;
+    const gint64 now = gdk_frame_clock_get_frame_time(frame_clock);
 
-    period = 1000 / GAUGE_RATE;
-    frame->gauge_computation_uid = g_timeout_add(period,
-                                                 lingot_gui_mainframe_callback_gauge_computation, frame);
+    // latest analysis results, used by all the drawings until the next tick.
+    frame->snapshot = lingot_core_get_snapshot(&frame->core);
 
-    // ignore continuous component
-    if (!frame->core.running || isnan(frame->core.freq)
-            || (frame->core.freq <= frame->conf.internal_min_frequency)) {
-        frequency = 0.0;
-        lingot_gauge_compute(&frame->gauge, frame->conf.gauge_rest_value);
-    } else {
-        FLT error_cents; // do not use, unfiltered
-        frequency = lingot_filter_filter_sample(&frame->freq_filter,
-                                                frame->core.freq);
-        closest_note_index = lingot_config_scale_get_closest_note_index(
-                    &frame->conf.scale, frame->core.freq,
-                    frame->conf.root_frequency_error, &error_cents);
-        if (!isnan(error_cents)) {
-            lingot_gauge_compute(&frame->gauge, error_cents);
+    if (frame->calibration_running
+            && __atomic_load_n(&frame->calibration_done, __ATOMIC_ACQUIRE)) {
+        lingot_gui_mainframe_apply_calibration(frame);
+    }
+
+    // nothing to do while the window is hidden or minimised
+    GdkWindow* window = gtk_widget_get_window(widget);
+    if (!gtk_widget_get_visible(widget) || (window == NULL)
+            || (gdk_window_get_state(window)
+                & (GDK_WINDOW_STATE_ICONIFIED | GDK_WINDOW_STATE_WITHDRAWN))) {
+        lingot_gui_mainframe_update_spectrogram(frame, 0);
+        frame->last_frame_time = 0;
+        return G_SOURCE_CONTINUE;
+    }
+
+    if (frame->last_frame_time != 0) {
+        lingot_gui_mainframe_update_gauge(frame,
+                                          1e-6 * (now - frame->last_frame_time));
+    }
+    frame->last_frame_time = now;
+
+    lingot_gui_mainframe_update_spectrogram(frame,
+                                            gtk_widget_get_visible(frame->spectrogram_area));
+
+    if (lingot_gui_mainframe_is_due(now, &frame->next_visualization_time,
+                                    1e6 / frame->conf.visualization_rate)) {
+        gtk_widget_queue_draw(frame->gauge_area);
+    }
+
+    // the strobe phases are updated with every audio block, so the bands are
+    // redrawn in every frame.
+    if (gtk_widget_get_visible(frame->strobe_area)) {
+        gtk_widget_queue_draw(frame->strobe_area);
+    }
+
+    if (lingot_gui_mainframe_is_due(now, &frame->next_spectrum_time,
+                                    1e6 / frame->conf.calculation_rate)) {
+        // the spectrum is only redrawn when something new has been published.
+        if (frame->snapshot->sequence != frame->spectrum_sequence) {
+            frame->spectrum_sequence = frame->snapshot->sequence;
+            gtk_widget_queue_draw(frame->spectrum_area);
         }
+        lingot_gui_mainframe_draw_labels(frame);
     }
 
-    return 0;
+    // the message dialogs run their own loop, so they are shown from an idle
+    // callback instead of from the tick.
+    if (lingot_gui_mainframe_is_due(now, &frame->next_error_dispatch_time,
+                                    1e6 / ERROR_DISPATCH_RATE)
+            && !frame->error_dispatcher_uid) {
+        frame->error_dispatcher_uid = g_idle_add(
+                    lingot_gui_mainframe_callback_error_dispatcher, frame);
+    }
+
+    return G_SOURCE_CONTINUE;
 }
 
-/* timeout for dispatching the error queue */
+/* idle callback for dispatching the error queue */
 gboolean lingot_gui_mainframe_callback_error_dispatcher(gpointer data) {
-    unsigned int period;
     GtkWidget* message_dialog;
     LingotMainFrame* frame = (LingotMainFrame*) data;
 
-    char* error_message = NULL;
-    message_type_t message_type;
-    int error_code;
+    LingotMessage error_message;
     int more_messages;
 
     do {
-        more_messages = lingot_msg_get(&error_message, &message_type, &error_code);
+        more_messages = lingot_msg_get(&error_message);
 
         if (more_messages) {
+            const message_type_t message_type = error_message.type;
             GtkWindow* parent =
                     GTK_WINDOW(
                         (frame->config_dialog != NULL) ? frame->config_dialog->win : frame->win);
@@ -258,9 +436,9 @@ gboolean lingot_gui_mainframe_callback_error_dispatcher(gpointer data) {
 
             message_pointer += snprintf(message_pointer,
                                         (message - message_pointer) + sizeof(message), "%s",
-                                        error_message);
+                                        error_message.text);
 
-            if (error_code == EBUSY) {
+            if (error_message.error_code == EBUSY) {
                 message_pointer +=
                         snprintf(message_pointer,
                                  (message - message_pointer) + sizeof(message),
@@ -294,7 +472,6 @@ gboolean lingot_gui_mainframe_callback_error_dispatcher(gpointer data) {
                                 gtk_window_get_icon(GTK_WINDOW(frame->win)));
             gtk_dialog_run(GTK_DIALOG(message_dialog));
             gtk_widget_destroy(message_dialog);
-            free(error_message);
 
             //			if ((message_type == ERROR) && !frame->core.running) {
             //				lingot_gui_mainframe_callback_config_dialog(NULL, frame);
@@ -303,11 +480,9 @@ gboolean lingot_gui_mainframe_callback_error_dispatcher(gpointer data) {
         }
     } while (more_messages);
 
-    period = 1000 / ERROR_DISPATCH_RATE;
-    frame->error_dispatcher_uid = g_timeout_add(period,
-                                                lingot_gui_mainframe_callback_error_dispatcher, frame);
+    frame->error_dispatcher_uid = 0;
 
-    return 0;
+    return G_SOURCE_REMOVE;
 }
 
 void lingot_gui_mainframe_callback_open_config(gpointer data,
@@ -432,7 +607,12 @@ void lingot_gui_mainframe_create(int argc, char *argv[]) {
         filechooser_config_last_folder = strdup(buff);
     }
 
-    frame = malloc(sizeof(LingotMainFrame));
+    // aligned, as the core keeps some fields on their own cache lines.
+    if (posix_memalign((void**) &frame, LINGOT_CACHE_LINE_SIZE,
+                       sizeof(LingotMainFrame))) {
+        fprintf(stderr, "Cannot allocate the main window\n");
+        return;
+    }
 
     frame->config_dialog = NULL;
 
@@ -441,6 +621,9 @@ void lingot_gui_mainframe_create(int argc, char *argv[]) {
     lingot_io_config_load(conf, CONFIG_FILE_NAME);
 
     lingot_gauge_new(&frame->gauge, conf->gauge_rest_value); // gauge in rest situation
+    lingot_gui_spectrogram_new(&frame->spectrogram, spectrum_min_db, spectrum_max_db);
+    frame->spectrogram_column = NULL;
+    frame->spectrogram_column_size = 0;
 
     // ----- FREQUENCY FILTER CONFIGURATION ------
 
@@ -475,12 +658,22 @@ void lingot_gui_mainframe_create(int argc, char *argv[]) {
                 gtk_builder_get_object(builder, "tone_label"));
     frame->error_label = GTK_WIDGET(
                 gtk_builder_get_object(builder, "error_label"));
+    frame->voices_label = GTK_WIDGET(
+                gtk_builder_get_object(builder, "voices_label"));
 
     frame->spectrum_frame = GTK_WIDGET(
                 gtk_builder_get_object(builder, "spectrum_frame"));
     frame->view_spectrum_item = GTK_WIDGET(
                 gtk_builder_get_object(builder, "spectrum_item"));
     frame->labelsbox = GTK_WIDGET(gtk_builder_get_object(builder, "labelsbox"));
+    frame->spectrogram_area = GTK_WIDGET(
+                gtk_builder_get_object(builder, "spectrogram_area"));
+    frame->view_spectrogram_item = GTK_WIDGET(
+                gtk_builder_get_object(builder, "spectrogram_item"));
+    frame->strobe_area = GTK_WIDGET(
+                gtk_builder_get_object(builder, "strobe_area"));
+    frame->view_strobe_item = GTK_WIDGET(
+                gtk_builder_get_object(builder, "strobe_item"));
 
     gtk_check_menu_item_set_active(
                 GTK_CHECK_MENU_ITEM(frame->view_spectrum_item), TRUE);
@@ -508,6 +701,12 @@ void lingot_gui_mainframe_create(int argc, char *argv[]) {
     g_signal_connect(gtk_builder_get_object(builder, "spectrum_item"),
                      "activate", G_CALLBACK(lingot_gui_mainframe_callback_view_spectrum),
                      frame);
+    g_signal_connect(gtk_builder_get_object(builder, "spectrogram_item"),
+                     "activate", G_CALLBACK(lingot_gui_mainframe_callback_view_spectrogram),
+                     frame);
+    g_signal_connect(gtk_builder_get_object(builder, "strobe_item"),
+                     "activate", G_CALLBACK(lingot_gui_mainframe_callback_view_strobe),
+                     frame);
     g_signal_connect(gtk_builder_get_object(builder, "open_config_item"),
                      "activate", G_CALLBACK(lingot_gui_mainframe_callback_open_config),
                      frame);
@@ -519,6 +718,10 @@ void lingot_gui_mainframe_create(int argc, char *argv[]) {
                      G_CALLBACK(lingot_gui_mainframe_callback_redraw_gauge), frame);
     g_signal_connect(frame->spectrum_area, "draw",
                      G_CALLBACK(lingot_gui_mainframe_callback_redraw_spectrum), frame);
+    g_signal_connect(frame->spectrogram_area, "draw",
+                     G_CALLBACK(lingot_gui_mainframe_callback_redraw_spectrogram), frame);
+    g_signal_connect(frame->strobe_area, "draw",
+                     G_CALLBACK(lingot_gui_mainframe_callback_redraw_strobe), frame);
     g_signal_connect(frame->win, "destroy",
                      G_CALLBACK(lingot_gui_mainframe_callback_destroy), frame);
 
@@ -532,26 +735,21 @@ void lingot_gui_mainframe_create(int argc, char *argv[]) {
                 "activate", accel_group, 'p', GDK_CONTROL_MASK, GTK_ACCEL_VISIBLE);
     gtk_window_add_accel_group(GTK_WINDOW(frame->win), accel_group);
 
-    unsigned int period;
-    period = 1000 / conf->visualization_rate;
-    frame->visualization_timer_uid = g_timeout_add(period,
-                                                   lingot_gui_mainframe_callback_tout_visualization, frame);
-
-    period = 1000 / conf->calculation_rate;
-    frame->freq_computation_timer_uid = g_timeout_add(period,
-                                                      lingot_gui_mainframe_callback_tout_spectrum_computation_display,
-                                                      frame);
-
-    period = 1000 / GAUGE_RATE;
-    frame->gauge_computation_uid = g_timeout_add(period,
-                                                 lingot_gui_mainframe_callback_gauge_computation, frame);
-
-    period = 1000 / ERROR_DISPATCH_RATE;
-    frame->error_dispatcher_uid = g_timeout_add(period,
-                                                lingot_gui_mainframe_callback_error_dispatcher, frame);
+    frame->last_frame_time = 0;
+    frame->next_visualization_time = 0;
+    frame->next_spectrum_time = 0;
+    frame->next_error_dispatch_time = 0;
+    frame->error_dispatcher_uid = 0;
+    frame->tick_callback_uid = gtk_widget_add_tick_callback(frame->win,
+                                                            lingot_gui_mainframe_callback_tick, frame, NULL);
 
     lingot_core_new(&frame->core, conf);
     lingot_core_start(&frame->core);
+    frame->snapshot = lingot_core_get_snapshot(&frame->core);
+    frame->spectrum_sequence = 0;
+
+    frame->calibration_running = 0;
+    lingot_gui_mainframe_start_calibration(frame);
 
     g_object_unref(builder);
 
@@ -560,11 +758,28 @@ void lingot_gui_mainframe_create(int argc, char *argv[]) {
 
 void lingot_gui_mainframe_destroy(LingotMainFrame* frame) {
 
+    if (frame->calibration_running) {
+        pthread_join(frame->calibration_thread, NULL);
+        lingot_config_destroy(&frame->calibration_conf);
+    }
+
     lingot_core_stop(&frame->core);
     lingot_core_destroy(&frame->core);
 
     lingot_gauge_destroy(&frame->gauge);
+    lingot_gui_spectrogram_destroy(&frame->spectrogram);
+    free(frame->spectrogram_column);
     lingot_filter_destroy(&frame->freq_filter);
+
+    if (gauge_background) {
+        cairo_surface_destroy(gauge_background);
+        gauge_background = NULL;
+    }
+    if (spectrum_background) {
+        cairo_surface_destroy(spectrum_background);
+        spectrum_background = NULL;
+    }
+
     lingot_config_destroy(&frame->conf);
     if (frame->config_dialog) {
         lingot_gui_config_dialog_destroy(frame->config_dialog);
@@ -772,6 +987,34 @@ static void lingot_gui_mainframe_draw_gauge_background(cairo_t *cr,
                                         frequencyBarMajorTicRadius, frequencyBarRadius, 0.0);
 }
 
+static void lingot_gui_mainframe_paint_gauge_background(cairo_t *cr,
+                                                        const LingotMainFrame* frame) {
+
+    if ((gauge_background == NULL)
+            || (gauge_background_size_x != gauge_size_x)
+            || (gauge_background_size_y != gauge_size_y)
+            || (gauge_background_max_offset != frame->conf.scale.max_offset_rounded)) {
+
+        if (gauge_background) {
+            cairo_surface_destroy(gauge_background);
+        }
+
+        gauge_background = gdk_window_create_similar_surface(
+                    gtk_widget_get_window(frame->gauge_area),
+                    CAIRO_CONTENT_COLOR, gauge_size_x, gauge_size_y);
+        gauge_background_size_x = gauge_size_x;
+        gauge_background_size_y = gauge_size_y;
+        gauge_background_max_offset = frame->conf.scale.max_offset_rounded;
+
+        cairo_t* background_cr = cairo_create(gauge_background);
+        lingot_gui_mainframe_draw_gauge_background(background_cr, frame);
+        cairo_destroy(background_cr);
+    }
+
+    cairo_set_source_surface(cr, gauge_background, 0, 0);
+    cairo_paint(cr);
+}
+
 void lingot_gui_mainframe_draw_gauge(cairo_t *cr, const LingotMainFrame* frame) {
 
     // normalized dimensions
@@ -808,7 +1051,7 @@ void lingot_gui_mainframe_draw_gauge(cairo_t *cr, const LingotMainFrame* frame)
     const FLT gaugeCenterRadius = height * gauge_gaugeCenterRadius;
     const FLT gaugeStroke = height * gauge_gaugeStroke;
 
-    lingot_gui_mainframe_draw_gauge_background(cr, frame);
+    lingot_gui_mainframe_paint_gauge_background(cr, frame);
 
     const double normalized_error = frame->gauge.position
             / frame->conf.scale.max_offset_rounded;
@@ -832,7 +1075,7 @@ void lingot_gui_mainframe_draw_gauge(cairo_t *cr, const LingotMainFrame* frame)
 
 FLT lingot_gui_mainframe_get_signal(const LingotMainFrame* frame, int i,
                                     FLT min, FLT max) {
-    FLT signal = frame->core.SPL[i];
+    FLT signal = frame->snapshot->SPL[i];
     if (signal < min) {
         signal = min;
     } else if (signal > max) {
@@ -1010,15 +1253,47 @@ void lingot_gui_mainframe_draw_spectrum_background(cairo_t *cr, const LingotMain
     }
 }
 
+static void lingot_gui_mainframe_paint_spectrum_background(cairo_t *cr,
+                                                           const LingotMainFrame* frame) {
+
+    const FLT max_frequency = 0.5 * frame->conf.sample_rate
+            / frame->conf.oversampling;
+
+    if ((spectrum_background == NULL)
+            || (spectrum_background_size_x != spectrum_size_x)
+            || (spectrum_background_size_y != spectrum_size_y)
+            || (spectrum_background_max_frequency != max_frequency)) {
+
+        if (spectrum_background) {
+            cairo_surface_destroy(spectrum_background);
+        }
+
+        spectrum_background = gdk_window_create_similar_surface(
+                    gtk_widget_get_window(frame->spectrum_area),
+                    CAIRO_CONTENT_COLOR, spectrum_size_x, spectrum_size_y);
+        spectrum_background_size_x = spectrum_size_x;
+        spectrum_background_size_y = spectrum_size_y;
+        spectrum_background_max_frequency = max_frequency;
+
+        // also updates the margins and the dB density used by the spectrum
+        cairo_t* background_cr = cairo_create(spectrum_background);
+        lingot_gui_mainframe_draw_spectrum_background(background_cr, frame);
+        cairo_destroy(background_cr);
+    }
+
+    cairo_set_source_surface(cr, spectrum_background, 0, 0);
+    cairo_paint(cr);
+}
+
 void lingot_gui_mainframe_draw_spectrum(cairo_t *cr, const LingotMainFrame* frame) {
 
     unsigned int i;
 
-    lingot_gui_mainframe_draw_spectrum_background(cr, frame);
+    lingot_gui_mainframe_paint_spectrum_background(cr, frame);
 
-    // TODO: change access to frame->core.X
     // spectrum drawing.
-    if (frame->core.running) {
+    if (frame->core.running
+            && (frame->snapshot->last_bin > frame->snapshot->first_bin + 1)) {
 
         cairo_set_line_width(cr, 1.0);
         cairo_set_line_cap(cr, CAIRO_LINE_CAP_BUTT);
@@ -1026,10 +1301,12 @@ void lingot_gui_mainframe_draw_spectrum(cairo_t *cr, const LingotMainFrame* fram
         FLT x;
         FLT y = -1;
 
-        const unsigned int min_index = 0;
-        const unsigned int max_index = frame->conf.fft_size / 2;
+        // only the bins evaluated by the analysis are drawn, on the axis of
+        // the whole spectrum.
+        const unsigned int min_index = frame->snapshot->first_bin;
+        const unsigned int max_index = frame->snapshot->last_bin;
 
-        FLT index_density = spectrum_inner_x / max_index;
+        FLT index_density = spectrum_inner_x / frame->snapshot->spd_size;
         // TODO: step
         const unsigned int index_step = 1;
 
@@ -1053,32 +1330,61 @@ void lingot_gui_mainframe_draw_spectrum(cairo_t *cr, const LingotMainFrame* fram
                 * lingot_gui_mainframe_get_signal(frame, min_index,
                                                   spectrum_min_db, spectrum_max_db); // dB.
 
-        cairo_move_to(cr, 0, 0);
-        cairo_line_to(cr, 0, y);
-
-        FLT yp1 = -spectrum_db_density
-                * lingot_gui_mainframe_get_signal(frame, min_index + 1,
-                                                  spectrum_min_db, spectrum_max_db);
-        FLT ym1 = y;
-
-        for (i = index_step; i < max_index - 1; i += index_step) {
-
-            x = index_density * i;
-            ym1 = y;
-            y = yp1;
-            yp1 = -spectrum_db_density
-                    * lingot_gui_mainframe_get_signal(frame, i + 1,
+        cairo_move_to(cr, index_density * min_index, 0);
+        cairo_line_to(cr, index_density * min_index, y);
+
+        if (index_density < 1.0) {
+
+            // more bins than pixels: the spectrum is reduced to its min/max
+            // envelope on each pixel column, so the path size is bounded by
+            // the widget width.
+            int column = (int) (index_density * min_index);
+            FLT y_min = y;
+            FLT y_max = y;
+            for (i = min_index + 1; i < max_index; i++) {
+                const int bin_column = (int) (index_density * i);
+                y = -spectrum_db_density
+                        * lingot_gui_mainframe_get_signal(frame, i,
+                                                          spectrum_min_db, spectrum_max_db);
+                if (bin_column != column) {
+                    cairo_line_to(cr, column, y_max);
+                    cairo_line_to(cr, column, y_min);
+                    column = bin_column;
+                    y_min = y;
+                    y_max = y;
+                } else if (y < y_min) {
+                    y_min = y;
+                } else if (y > y_max) {
+                    y_max = y;
+                }
+            }
+            cairo_line_to(cr, column, y_max);
+            cairo_line_to(cr, column, y_min);
+        } else {
+            FLT yp1 = -spectrum_db_density
+                    * lingot_gui_mainframe_get_signal(frame, min_index + 1,
                                                       spectrum_min_db, spectrum_max_db);
-            FLT dydx = (yp1 - ym1) / (2 * index_density);
-            static const FLT dx = 0.4;
-            FLT x1 = x - (1 - dx) * index_density;
-            FLT x2 = x - dx * index_density;
-            FLT y1 = ym1 + dydxm1 * dx;
-            FLT y2 = y - dydx * dx;
-
-            dydxm1 = dydx;
-            cairo_curve_to(cr, x1, y1, x2, y2, x, y);
-            //			cairo_line_to(cr, x, y);
+            FLT ym1 = y;
+
+            for (i = min_index + index_step; i < max_index - 1; i += index_step) {
+
+                x = index_density * i;
+                ym1 = y;
+                y = yp1;
+                yp1 = -spectrum_db_density
+                        * lingot_gui_mainframe_get_signal(frame, i + 1,
+                                                          spectrum_min_db, spectrum_max_db);
+                FLT dydx = (yp1 - ym1) / (2 * index_density);
+                static const FLT dx = 0.4;
+                FLT x1 = x - (1 - dx) * index_density;
+                FLT x2 = x - dx * index_density;
+                FLT y1 = ym1 + dydxm1 * dx;
+                FLT y2 = y - dydx * dx;
+
+                dydxm1 = dydx;
+                cairo_curve_to(cr, x1, y1, x2, y2, x, y);
+                //			cairo_line_to(cr, x, y);
+            }
         }
 
         y = -spectrum_db_density
@@ -1096,12 +1402,12 @@ void lingot_gui_mainframe_draw_spectrum(cairo_t *cr, const LingotMainFrame* fram
         cairo_set_line_cap(cr, CAIRO_LINE_CAP_ROUND);
         cairo_set_line_width(cr, 10.0);
 
-        for (i = 0; i < frame->core.markers_size2; i++) {
+        for (i = 0; i < frame->snapshot->markers_size2; i++) {
 
-            x = index_density * frame->core.markers2[i];
+            x = index_density * frame->snapshot->markers2[i];
             y = -spectrum_db_density
                     * lingot_gui_mainframe_get_signal(frame,
-                                                      frame->core.markers2[i], spectrum_min_db,
+                                                      frame->snapshot->markers2[i], spectrum_min_db,
                                                       spectrum_max_db); // dB.
             cairo_move_to(cr, x, y);
             cairo_rel_line_to(cr, 0, 0);
@@ -1111,12 +1417,12 @@ void lingot_gui_mainframe_draw_spectrum(cairo_t *cr, const LingotMainFrame* fram
         cairo_set_line_width(cr, 4.0);
         cairo_set_source_rgba(cr, 0.13, 0.13, 1.0, 1.0);
 
-        for (i = 0; i < frame->core.markers_size; i++) {
+        for (i = 0; i < frame->snapshot->markers_size; i++) {
 
-            x = index_density * frame->core.markers[i];
+            x = index_density * frame->snapshot->markers[i];
             y = -spectrum_db_density
                     * lingot_gui_mainframe_get_signal(frame,
-                                                      frame->core.markers[i], spectrum_min_db,
+                                                      frame->snapshot->markers[i], spectrum_min_db,
                                                       spectrum_max_db); // dB.
             cairo_move_to(cr, x, y);
             cairo_rel_line_to(cr, 0, 0);
@@ -1126,7 +1432,7 @@ void lingot_gui_mainframe_draw_spectrum(cairo_t *cr, const LingotMainFrame* fram
         cairo_set_line_width(cr, 1.0);
 #endif
 
-        if (frame->core.freq != 0.0) {
+        if (frame->snapshot->freq != 0.0) {
 
             cairo_set_dash(cr, dashed1, len1, 0);
 
@@ -1137,7 +1443,7 @@ void lingot_gui_mainframe_draw_spectrum(cairo_t *cr, const LingotMainFrame* fram
             cairo_set_line_width(cr, 1.0);
 
             // index of closest sample to fundamental frequency.
-            x = index_density * frame->core.freq * frame->conf.fft_size
+            x = index_density * frame->snapshot->freq * frame->conf.fft_size
                     * frame->conf.oversampling / frame->conf.sample_rate;
             cairo_move_to(cr, x, 0);
             cairo_rel_line_to(cr, 0.0, -spectrum_inner_y);
@@ -1165,20 +1471,62 @@ void lingot_gui_mainframe_draw_spectrum(cairo_t *cr, const LingotMainFrame* fram
         y = -spectrum_db_density
                 * lingot_gui_mainframe_get_noise(frame, spectrum_min_db,
                                                  spectrum_max_db); // dB.
+        // noise threshold drawing, which is flat along the whole spectrum.
         cairo_move_to(cr, 0, y);
-        // noise threshold drawing.
-        for (i = min_index + index_step; i < max_index - 1; i += index_step) {
+        cairo_line_to(cr, index_density * (max_index - 1), y);
+        cairo_stroke(cr);
 
-            x = index_density * i;
-            y = -spectrum_db_density
-                    * lingot_gui_mainframe_get_noise(frame, spectrum_min_db,
-                                                     spectrum_max_db); // dB.
-            cairo_line_to(cr, x, y);
+    }
+
+}
+
+// lists the notes found simultaneously, from the lowest to the highest.
+static void lingot_gui_mainframe_draw_voices_label(const LingotMainFrame* frame) {
+
+    unsigned int i, j;
+    FLT voices[LINGOT_CORE_MAX_VOICES];
+    const unsigned int n_voices = frame->snapshot->n_voices;
+    char voices_string[LINGOT_CORE_MAX_VOICES * 32] = "";
+
+    gtk_widget_set_visible(frame->voices_label, frame->conf.polyphony > 1);
+    if (frame->conf.polyphony <= 1) {
+        return;
+    }
+
+    for (i = 0; i < n_voices; i++) {
+        FLT f = frame->snapshot->voice_freq[i];
+        for (j = i; (j > 0) && (voices[j - 1] > f); j--) {
+            voices[j] = voices[j - 1];
         }
-        cairo_stroke(cr);
+        voices[j] = f;
+    }
 
+    for (i = 0; i < n_voices; i++) {
+        FLT error_cents;
+        const int note_index = lingot_config_scale_get_closest_note_index(
+                    &frame->conf.scale, voices[i],
+                    frame->conf.root_frequency_error, &error_cents);
+        if (isnan(error_cents)) {
+            continue;
+        }
+        const size_t len = strlen(voices_string);
+        snprintf(&voices_string[len], sizeof(voices_string) - len,
+                 "%s%s%d %+2.0f", (len > 0) ? "   " : "",
+                 frame->conf.scale.note_name[lingot_config_scale_get_note_index(
+                     &frame->conf.scale, note_index)],
+                lingot_config_scale_get_octave(&frame->conf.scale, note_index) + 4,
+                error_cents);
     }
 
+    if (voices_string[0] == '\0') {
+        strcpy(voices_string, "---");
+    }
+
+    const int font_size = 8 + labelsbox_size_x / 100;
+    char* markup = g_markup_printf_escaped("<span font_desc=\"%d\">%s</span>",
+                                           font_size, voices_string);
+    gtk_label_set_markup(GTK_LABEL(frame->voices_label), markup);
+    g_free(markup);
 }
 
 void lingot_gui_mainframe_draw_labels(const LingotMainFrame* frame) {
@@ -1224,19 +1572,29 @@ void lingot_gui_mainframe_draw_labels(const LingotMainFrame* frame) {
                 octave_string);
     gtk_label_set_markup(GTK_LABEL(frame->tone_label), markup);
     g_free(markup);
+
+    lingot_gui_mainframe_draw_voices_label(frame);
 }
 
 void lingot_gui_mainframe_change_config(LingotMainFrame* frame,
                                         LingotConfig* conf) {
-    lingot_core_stop(&frame->core);
-    lingot_core_destroy(&frame->core);
-
     // dup.
     lingot_config_copy(&frame->conf, conf);
 
-    lingot_core_new(&frame->core, &frame->conf);
-    lingot_core_start(&frame->core);
+    // the analysis parameters can be changed on the fly, otherwise the audio
+    // device has to be reopened.
+    if (!lingot_core_reconfigure(&frame->core, &frame->conf)) {
+        lingot_core_stop(&frame->core);
+        lingot_core_destroy(&frame->core);
+
+        lingot_core_new(&frame->core, &frame->conf);
+        lingot_core_start(&frame->core);
+    }
+    frame->snapshot = lingot_core_get_snapshot(&frame->core);
 
     // some parameters may have changed
     lingot_config_copy(conf, &frame->conf);
+
+    // the new settings may need their own calibration.
+    lingot_gui_mainframe_start_calibration(frame);
 }
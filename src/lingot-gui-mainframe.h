@@ -31,8 +31,11 @@
 #include "lingot-config.h"
 #include "lingot-filter.h"
 #include "lingot-gui-config-dialog.h"
+#include "lingot-gui-spectrogram.h"
+#include "lingot-gui-strobe.h"
 
 #include <gtk/gtk.h>
+#include <pthread.h>
 
 // Window that contains all controls, graphics, etc. of the tuner.
 
@@ -45,9 +48,14 @@ struct _LingotMainFrame {
     GtkWidget* tone_label;
     GtkWidget* view_spectrum_item;
     GtkWidget* spectrum_frame;
+    GtkWidget* spectrogram_area;
+    GtkWidget* view_spectrogram_item;
+    GtkWidget* strobe_area;
+    GtkWidget* view_strobe_item;
 
     GtkWidget* freq_label;
     GtkWidget* error_label;
+    GtkWidget* voices_label; // notes found with polyphony.
 
     GtkWidget* labelsbox;
 
@@ -55,7 +63,13 @@ struct _LingotMainFrame {
 
     LingotGauge gauge;
 
+    LingotSpectrogram spectrogram;
+    FLT* spectrogram_column; // SPL of the analysis passes taken from the core.
+    unsigned int spectrogram_column_size;
+
     LingotCore core;
+    const LingotCoreSnapshot* snapshot; // analysis results being displayed.
+    unsigned long spectrum_sequence; // publication shown in the spectrum.
 
     GtkWidget* win;
 
@@ -65,11 +79,19 @@ struct _LingotMainFrame {
     LingotConfigDialog* config_dialog;
     LingotConfig conf;
 
-    // timer uids
-    guint visualization_timer_uid;
-    guint freq_computation_timer_uid;
-    guint gauge_computation_uid;
+    // frame clock driven updates (times in microseconds)
+    guint tick_callback_uid;
+    gint64 last_frame_time;
+    gint64 next_visualization_time;
+    gint64 next_spectrum_time;
+    gint64 next_error_dispatch_time;
     guint error_dispatcher_uid;
+
+    // background calibration of the analysis parameters.
+    pthread_t calibration_thread;
+    int calibration_running;
+    int calibration_done; // set by the calibration thread.
+    LingotConfig calibration_conf;
 };
 
 void lingot_gui_mainframe_create(int argc, char *argv[]);
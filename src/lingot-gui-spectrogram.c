@@ -0,0 +1,171 @@
+/*
+ * lingot, a musical instrument tuner.
+ *
+ * Copyright (C) 2004-2019  Iban Cereijo.
+ * Copyright (C) 2004-2008  Jairo Chapela.
+
+ *
+ * This file is part of lingot.
+ *
+ * lingot is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * lingot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with lingot; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <string.h>
+#include <math.h>
+
+#include "lingot-gui-spectrogram.h"
+
+void lingot_gui_spectrogram_new(LingotSpectrogram* spectrogram, FLT min_db,
+                                FLT max_db) {
+
+    // colour ramp black - blue - green - yellow - red, by linear
+    // interpolation between the control points.
+    static const FLT points[][3] = {
+        { 0.0, 0.0, 0.0 },
+        { 0.0, 0.0, 0.6 },
+        { 0.0, 0.8, 0.2 },
+        { 1.0, 1.0, 0.0 },
+        { 1.0, 0.1, 0.1 },
+    };
+    static const int n_points = sizeof(points) / sizeof(points[0]);
+    int i, c;
+
+    spectrogram->surface = NULL;
+    spectrogram->width = 0;
+    spectrogram->height = 0;
+    spectrogram->next_column = 0;
+    spectrogram->min_db = min_db;
+    spectrogram->max_db = max_db;
+
+    for (i = 0; i < 256; i++) {
+        const FLT x = i * (n_points - 1) / 255.0;
+        const int k = (x < n_points - 1) ? (int) x : n_points - 2;
+        const FLT t = x - k;
+        uint32_t color = 0;
+        for (c = 0; c < 3; c++) {
+            const FLT value = (1.0 - t) * points[k][c] + t * points[k + 1][c];
+            color = (color << 8) | (uint32_t) (255.0 * value + 0.5);
+        }
+        spectrogram->colors[i] = color;
+    }
+}
+
+void lingot_gui_spectrogram_destroy(LingotSpectrogram* spectrogram) {
+    if (spectrogram->surface) {
+        cairo_surface_destroy(spectrogram->surface);
+        spectrogram->surface = NULL;
+    }
+}
+
+void lingot_gui_spectrogram_append(LingotSpectrogram* spectrogram,
+                                   const LingotCoreSnapshot* snapshot, int width, int height) {
+
+    int row;
+
+    if ((width <= 0) || (height <= 0) || (snapshot->last_bin <= snapshot->first_bin)) {
+        return;
+    }
+
+    if ((spectrogram->surface == NULL) || (width != spectrogram->width)
+            || (height != spectrogram->height)) {
+        lingot_gui_spectrogram_destroy(spectrogram);
+        spectrogram->surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24,
+                                                          width, height);
+        spectrogram->width = width;
+        spectrogram->height = height;
+        spectrogram->next_column = 0;
+
+        // starts black.
+        cairo_surface_flush(spectrogram->surface);
+        memset(cairo_image_surface_get_data(spectrogram->surface), 0,
+               cairo_image_surface_get_stride(spectrogram->surface) * height);
+        cairo_surface_mark_dirty(spectrogram->surface);
+    }
+
+    cairo_surface_flush(spectrogram->surface);
+
+    unsigned char* data = cairo_image_surface_get_data(spectrogram->surface);
+    const int stride = cairo_image_surface_get_stride(spectrogram->surface);
+    const int column = spectrogram->next_column;
+    const FLT scale = 255.0 / (spectrogram->max_db - spectrogram->min_db);
+
+    // each row takes the maximum SPL of the bins it covers, with the lowest
+    // frequencies at the bottom. The rows outside the bins evaluated by the
+    // analysis are left at the floor colour.
+    for (row = 0; row < height; row++) {
+        unsigned int bin = (unsigned int) (((unsigned long) row * snapshot->spd_size) / height);
+        unsigned int last_bin = (unsigned int) (((unsigned long) (row + 1) * snapshot->spd_size) / height);
+        if (last_bin <= bin) {
+            last_bin = bin + 1;
+        }
+        if (bin < snapshot->first_bin) {
+            bin = snapshot->first_bin;
+        }
+        if (last_bin > snapshot->last_bin) {
+            last_bin = snapshot->last_bin;
+        }
+
+        FLT spl = spectrogram->min_db;
+        for (; bin < last_bin; bin++) {
+            if (snapshot->SPL[bin] > spl) {
+                spl = snapshot->SPL[bin];
+            }
+        }
+
+        int index = (int) ((spl - spectrogram->min_db) * scale);
+        if (index < 0) {
+            index = 0;
+        } else if (index > 255) {
+            index = 255;
+        }
+
+        uint32_t* pixel = (uint32_t*) (data + (height - 1 - row) * stride) + column;
+        *pixel = spectrogram->colors[index];
+    }
+
+    cairo_surface_mark_dirty_rectangle(spectrogram->surface, column, 0, 1, height);
+
+    spectrogram->next_column = (column + 1) % width;
+}
+
+void lingot_gui_spectrogram_draw(const LingotSpectrogram* spectrogram,
+                                 cairo_t *cr) {
+
+    cairo_set_source_rgb(cr, 0.0, 0.0, 0.0);
+    cairo_paint(cr);
+
+    if (spectrogram->surface == NULL) {
+        return;
+    }
+
+    // the oldest columns, from next_column to the end of the ring, go first.
+    const int split = spectrogram->width - spectrogram->next_column;
+
+    cairo_save(cr);
+    cairo_rectangle(cr, 0, 0, split, spectrogram->height);
+    cairo_clip(cr);
+    cairo_set_source_surface(cr, spectrogram->surface, -spectrogram->next_column, 0);
+    cairo_paint(cr);
+    cairo_restore(cr);
+
+    if (spectrogram->next_column > 0) {
+        cairo_save(cr);
+        cairo_rectangle(cr, split, 0, spectrogram->next_column, spectrogram->height);
+        cairo_clip(cr);
+        cairo_set_source_surface(cr, spectrogram->surface, split, 0);
+        cairo_paint(cr);
+        cairo_restore(cr);
+    }
+}
@@ -0,0 +1,63 @@
+/*
+ * lingot, a musical instrument tuner.
+ *
+ * Copyright (C) 2004-2019  Iban Cereijo.
+ * Copyright (C) 2004-2008  Jairo Chapela.
+
+ *
+ * This file is part of lingot.
+ *
+ * lingot is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * lingot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with lingot; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LINGOT_GUI_SPECTROGRAM_H
+#define LINGOT_GUI_SPECTROGRAM_H
+
+#include <stdint.h>
+#include <gtk/gtk.h>
+
+#include "lingot-defs.h"
+#include "lingot-core.h"
+
+/*
+ * Scrolling spectrogram (waterfall). Each analysis pass is appended as a
+ * column of a persistent image, used as a ring buffer, so the history is
+ * never rendered again: drawing just blits the two parts of the ring.
+ */
+
+typedef struct {
+    cairo_surface_t* surface; // ring of columns, the oldest at next_column.
+    int width;
+    int height;
+    int next_column; // column to be written next.
+
+    FLT min_db; // SPL range mapped to the colour table.
+    FLT max_db;
+    uint32_t colors[256]; // colour lookup table, in RGB24 format.
+} LingotSpectrogram;
+
+void lingot_gui_spectrogram_new(LingotSpectrogram*, FLT min_db, FLT max_db);
+void lingot_gui_spectrogram_destroy(LingotSpectrogram*);
+
+// appends the SPL of the given snapshot, i.e. of an analysis pass, as the
+// newest column. The history is
+// cleared if the size has changed.
+void lingot_gui_spectrogram_append(LingotSpectrogram*,
+                                   const LingotCoreSnapshot* snapshot, int width, int height);
+
+// draws the spectrogram, with the newest column on the right.
+void lingot_gui_spectrogram_draw(const LingotSpectrogram*, cairo_t *cr);
+
+#endif /* LINGOT_GUI_SPECTROGRAM_H */
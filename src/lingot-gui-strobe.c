@@ -0,0 +1,74 @@
+/*
+ * lingot, a musical instrument tuner.
+ *
+ * Copyright (C) 2004-2019  Iban Cereijo.
+ * Copyright (C) 2004-2008  Jairo Chapela.
+
+ *
+ * This file is part of lingot.
+ *
+ * lingot is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * lingot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with lingot; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <math.h>
+
+#include "lingot-gui-strobe.h"
+
+// stripes of the band of the fundamental.
+static const int lingot_gui_strobe_stripes = 4;
+
+void lingot_gui_strobe_draw(const LingotStrobeReadout* readout, cairo_t *cr,
+                            int width, int height) {
+
+    unsigned int h;
+    int k;
+    FLT max_magnitude = 0.0;
+
+    cairo_set_source_rgb(cr, 0.06, 0.06, 0.06);
+    cairo_paint(cr);
+
+    if ((readout->n_harmonics == 0) || (width <= 0) || (height <= 0)) {
+        return;
+    }
+
+    for (h = 0; h < readout->n_harmonics; h++) {
+        if (readout->magnitude[h] > max_magnitude) {
+            max_magnitude = readout->magnitude[h];
+        }
+    }
+    if (max_magnitude <= 0.0) {
+        return;
+    }
+
+    const FLT band_height = ((FLT) height) / readout->n_harmonics;
+
+    for (h = 0; h < readout->n_harmonics; h++) {
+
+        // the weak harmonics are dimmed, as their phase is less reliable.
+        const FLT intensity = readout->magnitude[h] / max_magnitude;
+        const int stripes = lingot_gui_strobe_stripes * (h + 1);
+        const FLT period = ((FLT) width) / stripes;
+        const FLT offset = period * readout->phase[h] / (2.0 * M_PI);
+        const FLT y = band_height * h;
+
+        cairo_set_source_rgb(cr, 0.1 + 0.8 * intensity,
+                             0.4 + 0.5 * intensity, 0.1);
+        for (k = -1; k <= stripes; k++) {
+            cairo_rectangle(cr, k * period + offset, y + 1.0, 0.5 * period,
+                            band_height - 2.0);
+        }
+        cairo_fill(cr);
+    }
+}
@@ -0,0 +1,44 @@
+/*
+ * lingot, a musical instrument tuner.
+ *
+ * Copyright (C) 2004-2019  Iban Cereijo.
+ * Copyright (C) 2004-2008  Jairo Chapela.
+
+ *
+ * This file is part of lingot.
+ *
+ * lingot is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * lingot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with lingot; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LINGOT_GUI_STROBE_H
+#define LINGOT_GUI_STROBE_H
+
+#include <gtk/gtk.h>
+
+#include "lingot-defs.h"
+#include "lingot-strobe.h"
+
+/*
+ * Strobe display. Each harmonic followed by the strobe stage is drawn as a
+ * band of stripes, shifted according to its phase. The bands of the higher
+ * harmonics have proportionally more stripes, so all of them move at the
+ * same speed when the note is detuned, to the right when it is sharp.
+ */
+
+// draws the strobe bands for the given readout, in an area of the given size.
+void lingot_gui_strobe_draw(const LingotStrobeReadout* readout, cairo_t *cr,
+                            int width, int height);
+
+#endif /* LINGOT_GUI_STROBE_H */
@@ -26,6 +26,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
+#include <limits.h>
 #include <math.h>
 
 #include "lingot-io-config-scale.h"
@@ -34,10 +35,8 @@
 
 int lingot_config_scale_parse_shift(char* char_buffer, double* cents,
                                     short int* numerator, short int* denominator) {
-    static const char* delim = "/";
-    char* char_buffer_pointer1 = strtok(char_buffer, delim);
-    char* char_buffer_pointer2 = strtok(NULL, delim);
-    short int num, den;
+    char* end;
+    long num, den;
     int result = 1;
 
     if (numerator != NULL) {
@@ -48,39 +47,48 @@ int lingot_config_scale_parse_shift(char* char_buffer, double* cents,
         *denominator = -1;
     }
 
-    int n = 0;
-    if (!char_buffer_pointer2) {
-        if (!char_buffer_pointer1) {
+    // the shift is a ratio if its first token has a slash. No strtok here,
+    // the callers may be in the middle of their own tokenization.
+    const char* token = char_buffer + strspn(char_buffer, " \t");
+    const char* slash = strchr(token, '/');
+    if ((slash != NULL) && (slash >= token + strcspn(token, " \t\n"))) {
+        slash = NULL;
+    }
+
+    if (slash == NULL) {
+        if (sscanf(token, "%lf", cents) != 1) {
             result = 0;
-        } else {
-            n = sscanf(char_buffer_pointer1, "%lf", cents);
-            if (!n) {
-                result = 0;
-            }
         }
     } else {
-        n = sscanf(char_buffer_pointer1, "%hd", &num);
-        if (!n) {
+        num = strtol(token, &end, 10);
+        if ((end == token) || (num <= 0)) {
             result = 0;
         } else {
-            n = sscanf(char_buffer_pointer2, "%hd", &den);
-            if (!n) {
+            den = strtol(slash + 1, &end, 10);
+            if ((end == slash + 1) || (den <= 0)) {
                 result = 0;
             } else {
                 *cents = 1200.0 * log2(1.0 * num / den);
-                if (numerator != NULL) {
-                    *numerator = num;
-                }
-                if (denominator != NULL) {
-                    *denominator = den;
+                // larger ratios are only kept in cents.
+                if ((num <= SHRT_MAX) && (den <= SHRT_MAX)) {
+                    if (numerator != NULL) {
+                        *numerator = (short int) num;
+                    }
+                    if (denominator != NULL) {
+                        *denominator = (short int) den;
+                    }
                 }
             }
         }
     }
 
     if (!result) {
-        *numerator = 1;
-        *denominator = 1;
+        if (numerator != NULL) {
+            *numerator = 1;
+        }
+        if (denominator != NULL) {
+            *denominator = 1;
+        }
         *cents = 0.0;
     }
 
@@ -195,6 +203,8 @@ int lingot_config_scale_load_scl(LingotScale* scale, char* filename) {
             sprintf(char_buffer, "%d", i + 1);
             scale->note_name[i] = strdup(char_buffer);
         }
+
+        lingot_config_scale_update_index(scale);
     } catch {
         result = 0;
         char buff[1000];
@@ -36,7 +36,7 @@
 #include "lingot-audio.h"
 
 
-#define N_MAX_OPTIONS 30
+#define N_MAX_OPTIONS 64
 
 static LingotConfigParameterSpec parameters[N_MAX_OPTIONS];
 static unsigned int parameters_count = 0;
@@ -102,7 +102,9 @@ void lingot_io_config_create_parameter_specs(void) {
     lingot_config_add_double_parameter_spec(LINGOT_PARAMETER_ID_ROOT_FREQUENCY_ERROR,
                                             "ROOT_FREQUENCY_ERROR", "cents", -500.0, 500.0, 0);
     lingot_config_add_integer_parameter_spec(LINGOT_PARAMETER_ID_FFT_SIZE,
-                                             "FFT_SIZE", "samples", 256, 4096, 0);
+                                             "FFT_SIZE", "samples",
+                                             LINGOT_CONFIG_MIN_FFT_SIZE,
+                                             LINGOT_CONFIG_MAX_FFT_SIZE, 0);
     lingot_config_add_double_parameter_spec(LINGOT_PARAMETER_ID_TEMPORAL_WINDOW,
                                             "TEMPORAL_WINDOW", "seconds", 0.0, 15.00, 0);
     lingot_config_add_double_parameter_spec(LINGOT_PARAMETER_ID_CALCULATION_RATE,
@@ -113,6 +115,40 @@ void lingot_io_config_create_parameter_specs(void) {
                                             "MINIMUM_FREQUENCY", "Hz", 0.0, 22050.0, 0);
     lingot_config_add_double_parameter_spec(LINGOT_PARAMETER_ID_MAXIMUM_FREQUENCY,
                                             "MAXIMUM_FREQUENCY", "Hz", 0.0, 22050.0, 0);
+    lingot_config_add_integer_parameter_spec(LINGOT_PARAMETER_ID_NARROWBAND_TRACKING,
+                                             "NARROWBAND_TRACKING", NULL, 0, 1, 0);
+    lingot_config_add_integer_parameter_spec(LINGOT_PARAMETER_ID_INCREMENTAL_SPECTRUM,
+                                             "INCREMENTAL_SPECTRUM", NULL, 0, 1, 0);
+    lingot_config_add_integer_parameter_spec(LINGOT_PARAMETER_ID_FREQUENCY_REFINEMENT,
+                                             "FREQUENCY_REFINEMENT", NULL, 0, 1, 0);
+    lingot_config_add_double_parameter_spec(LINGOT_PARAMETER_ID_CALIBRATION_BUDGET,
+                                            "CALIBRATION_BUDGET", "ms", 0.0, 1000.0, 0);
+    lingot_config_add_string_parameter_spec(LINGOT_PARAMETER_ID_CALIBRATION_ID,
+                                            "CALIBRATION_ID", 256, 0);
+    lingot_config_add_integer_parameter_spec(LINGOT_PARAMETER_ID_OVERSAMPLING_LIMIT,
+                                             "OVERSAMPLING_LIMIT", NULL, 0, 1000, 0);
+    lingot_config_add_double_parameter_spec(LINGOT_PARAMETER_ID_SILENCE_THRESHOLD,
+                                            "SILENCE_THRESHOLD", "dBFS", -200.0, 0.0, 0);
+    lingot_config_add_string_parameter_spec(LINGOT_PARAMETER_ID_CAPTURE_PREFIX,
+                                            "CAPTURE_PREFIX", 256, 0);
+    lingot_config_add_string_parameter_spec(LINGOT_PARAMETER_ID_TELEMETRY_SOCKET,
+                                            "TELEMETRY_SOCKET", 256, 0);
+    lingot_config_add_integer_parameter_spec(LINGOT_PARAMETER_ID_POLYPHONY,
+                                             "POLYPHONY", NULL, 1, 6, 0);
+    lingot_config_add_integer_parameter_spec(LINGOT_PARAMETER_ID_STROBE_HARMONICS,
+                                             "STROBE_HARMONICS", NULL, 0, 8, 0);
+    lingot_config_add_integer_parameter_spec(LINGOT_PARAMETER_ID_CAPTURE_THREAD_POLICY,
+                                             "CAPTURE_THREAD_POLICY", NULL, 0, 2, 0);
+    lingot_config_add_integer_parameter_spec(LINGOT_PARAMETER_ID_CAPTURE_THREAD_PRIORITY,
+                                             "CAPTURE_THREAD_PRIORITY", NULL, 1, 99, 0);
+    lingot_config_add_string_parameter_spec(LINGOT_PARAMETER_ID_CAPTURE_THREAD_AFFINITY,
+                                            "CAPTURE_THREAD_AFFINITY", 64, 0);
+    lingot_config_add_integer_parameter_spec(LINGOT_PARAMETER_ID_ANALYSIS_THREAD_POLICY,
+                                             "ANALYSIS_THREAD_POLICY", NULL, 0, 2, 0);
+    lingot_config_add_integer_parameter_spec(LINGOT_PARAMETER_ID_ANALYSIS_THREAD_PRIORITY,
+                                             "ANALYSIS_THREAD_PRIORITY", NULL, 1, 99, 0);
+    lingot_config_add_string_parameter_spec(LINGOT_PARAMETER_ID_ANALYSIS_THREAD_AFFINITY,
+                                            "ANALYSIS_THREAD_AFFINITY", 64, 0);
 
     // ----------- obsolete -----------
     lingot_config_add_double_parameter_spec(LINGOT_PARAMETER_ID_GAIN, "GAIN",
@@ -182,6 +218,40 @@ static void lingot_config_map_parameters(LingotConfig* config, void* params[]) {
                             .value = &config->min_frequency }, //
                           { .id = LINGOT_PARAMETER_ID_MAXIMUM_FREQUENCY,
                             .value = &config->max_frequency }, //
+                          { .id = LINGOT_PARAMETER_ID_NARROWBAND_TRACKING,
+                            .value = &config->narrowband_tracking }, //
+                          { .id = LINGOT_PARAMETER_ID_INCREMENTAL_SPECTRUM,
+                            .value = &config->incremental_spectrum }, //
+                          { .id = LINGOT_PARAMETER_ID_FREQUENCY_REFINEMENT,
+                            .value = &config->frequency_refinement }, //
+                          { .id = LINGOT_PARAMETER_ID_CALIBRATION_BUDGET,
+                            .value = &config->calibration_budget }, //
+                          { .id = LINGOT_PARAMETER_ID_CALIBRATION_ID,
+                            .value = config->calibration_id }, //
+                          { .id = LINGOT_PARAMETER_ID_OVERSAMPLING_LIMIT,
+                            .value = &config->oversampling_limit }, //
+                          { .id = LINGOT_PARAMETER_ID_SILENCE_THRESHOLD,
+                            .value = &config->silence_threshold }, //
+                          { .id = LINGOT_PARAMETER_ID_CAPTURE_PREFIX,
+                            .value = config->capture_prefix }, //
+                          { .id = LINGOT_PARAMETER_ID_TELEMETRY_SOCKET,
+                            .value = config->telemetry_socket }, //
+                          { .id = LINGOT_PARAMETER_ID_POLYPHONY,
+                            .value = &config->polyphony }, //
+                          { .id = LINGOT_PARAMETER_ID_STROBE_HARMONICS,
+                            .value = &config->strobe_harmonics }, //
+                          { .id = LINGOT_PARAMETER_ID_CAPTURE_THREAD_POLICY,
+                            .value = &config->capture_thread.policy }, //
+                          { .id = LINGOT_PARAMETER_ID_CAPTURE_THREAD_PRIORITY,
+                            .value = &config->capture_thread.priority }, //
+                          { .id = LINGOT_PARAMETER_ID_CAPTURE_THREAD_AFFINITY,
+                            .value = config->capture_thread.affinity }, //
+                          { .id = LINGOT_PARAMETER_ID_ANALYSIS_THREAD_POLICY,
+                            .value = &config->analysis_thread.policy }, //
+                          { .id = LINGOT_PARAMETER_ID_ANALYSIS_THREAD_PRIORITY,
+                            .value = &config->analysis_thread.priority }, //
+                          { .id = LINGOT_PARAMETER_ID_ANALYSIS_THREAD_AFFINITY,
+                            .value = config->analysis_thread.affinity }, //
                           { .id = -1,
                             .value = NULL }, // null terminated
                         };
@@ -543,13 +613,14 @@ int lingot_io_config_load(LingotConfig* config, const char* filename) {
 
                 // TODO: generalize validation?
                 if (parameters[option_index].id == LINGOT_PARAMETER_ID_FFT_SIZE) {
-                    if ((int_value != 256) && (int_value != 512)
-                            && (int_value != 1024) && (int_value != 2048)
-                            && (int_value != 4096)) {
+                    if ((int_value < LINGOT_CONFIG_MIN_FFT_SIZE)
+                            || (int_value > LINGOT_CONFIG_MAX_FFT_SIZE)
+                            || (int_value & (int_value - 1))) {
                         fprintf(stderr,
-                                "error: parse error at line %i, '%s = %s': invalid value (allowed values are 256, 512, 1024, 2048 and 4096), assuming default value %i\n",
+                                "error: parse error at line %i, '%s = %s': invalid value (allowed values are the powers of two from %i to %i), assuming default value %i\n",
                                 line, parameters[option_index].name,
-                                char_buffer_pointer, *((unsigned int*) param));
+                                char_buffer_pointer, LINGOT_CONFIG_MIN_FFT_SIZE,
+                                LINGOT_CONFIG_MAX_FFT_SIZE, *((unsigned int*) param));
                         parse_errors = 1;
                     } else {
                         *((int*) param) = int_value;
@@ -39,6 +39,23 @@ typedef enum LingotConfigParameterId {
     LINGOT_PARAMETER_ID_VISUALIZATION_RATE, //
     LINGOT_PARAMETER_ID_MINIMUM_FREQUENCY, //
     LINGOT_PARAMETER_ID_MAXIMUM_FREQUENCY, //
+    LINGOT_PARAMETER_ID_NARROWBAND_TRACKING, //
+    LINGOT_PARAMETER_ID_INCREMENTAL_SPECTRUM, //
+    LINGOT_PARAMETER_ID_FREQUENCY_REFINEMENT, //
+    LINGOT_PARAMETER_ID_CALIBRATION_BUDGET, //
+    LINGOT_PARAMETER_ID_CALIBRATION_ID, //
+    LINGOT_PARAMETER_ID_SILENCE_THRESHOLD, //
+    LINGOT_PARAMETER_ID_CAPTURE_PREFIX, //
+    LINGOT_PARAMETER_ID_TELEMETRY_SOCKET, //
+    LINGOT_PARAMETER_ID_POLYPHONY, //
+    LINGOT_PARAMETER_ID_STROBE_HARMONICS, //
+    LINGOT_PARAMETER_ID_CAPTURE_THREAD_POLICY, //
+    LINGOT_PARAMETER_ID_CAPTURE_THREAD_PRIORITY, //
+    LINGOT_PARAMETER_ID_CAPTURE_THREAD_AFFINITY, //
+    LINGOT_PARAMETER_ID_ANALYSIS_THREAD_POLICY, //
+    LINGOT_PARAMETER_ID_ANALYSIS_THREAD_PRIORITY, //
+    LINGOT_PARAMETER_ID_ANALYSIS_THREAD_AFFINITY, //
+    LINGOT_PARAMETER_ID_OVERSAMPLING_LIMIT, //
     // ------- obsolete ---------
     LINGOT_PARAMETER_ID_MIN_FREQUENCY, //
     LINGOT_PARAMETER_ID_GAIN, //
@@ -0,0 +1,471 @@
+/*
+ * lingot, a musical instrument tuner.
+ *
+ * Copyright (C) 2004-2019  Iban Cereijo.
+ * Copyright (C) 2004-2008  Jairo Chapela.
+
+ *
+ * This file is part of lingot.
+ *
+ * lingot is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * lingot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with lingot; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <limits.h>
+#include <math.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "lingot-io-scale-library.h"
+#include "lingot-io-config-scale.h"
+
+#define SCALE_LIBRARY_MAX_LINE_SIZE 1000
+
+// FNV-1a, accumulated over the lines of the file
+static unsigned int lingot_scale_library_hash(unsigned int hash, const char* text) {
+    for (; *text; text++) {
+        hash ^= (unsigned char) *text;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void lingot_scale_library_trim(char* text) {
+    char* end = text + strlen(text);
+    while ((end > text) && isspace((unsigned char) end[-1])) {
+        *--end = '\0';
+    }
+}
+
+// parses a pitch line of a Scala file, in cents (with a period) or as a ratio
+// (with or without denominator). Anything after the first token is ignored.
+static int lingot_scale_library_parse_pitch(const char* text, FLT* cents,
+                                            short int* numerator, short int* denominator) {
+    char pitch[64];
+
+    text += strspn(text, " \t");
+    size_t length = strcspn(text, " \t!");
+    if (length + sizeof("/1") > sizeof(pitch)) {
+        return 0;
+    }
+    memcpy(pitch, text, length);
+    pitch[length] = '\0';
+
+    // integers are ratios with denominator 1.
+    if (!strpbrk(pitch, "./")) {
+        strcat(pitch, "/1");
+    }
+
+    return lingot_config_scale_parse_shift(pitch, cents, numerator, denominator);
+}
+
+// Parses a Scala file leniently: comment lines may appear anywhere, and the
+// final line (the period of the scale) is not required. The scale must be
+// initialized with _new. No error messages are posted, so that whole trees
+// of files of unknown quality can be indexed.
+static int lingot_scale_library_parse_file(const char* filename,
+                                           LingotScale* scale, unsigned int* hash) {
+    FILE* fp;
+    char char_buffer[SCALE_LIBRARY_MAX_LINE_SIZE];
+    char* name = NULL;
+    int notes = -1;
+    int note = 1;
+    int result = 1;
+
+    if ((fp = fopen(filename, "r")) == NULL) {
+        return 0;
+    }
+
+    *hash = 2166136261u;
+
+    while (fgets(char_buffer, sizeof(char_buffer), fp)) {
+        *hash = lingot_scale_library_hash(*hash, char_buffer);
+
+        if (char_buffer[0] == '!') {
+            continue;
+        }
+
+        lingot_scale_library_trim(char_buffer);
+
+        if (!name) {
+            name = strdup(char_buffer);
+        } else if (notes < 0) {
+            if ((sscanf(char_buffer, "%d", &notes) != 1) || (notes <= 0)
+                    || (notes > USHRT_MAX)) {
+                result = 0;
+                break;
+            }
+            lingot_config_scale_allocate(scale, (unsigned short int) notes);
+            scale->note_name[0] = strdup("1");
+            scale->offset_cents[0] = 0.0;
+            scale->offset_ratios[0][0] = 1;
+            scale->offset_ratios[1][0] = 1; // 1/1
+        } else if (note < notes) {
+            if (!lingot_scale_library_parse_pitch(char_buffer,
+                                                  &scale->offset_cents[note],
+                                                  &scale->offset_ratios[0][note],
+                                                  &scale->offset_ratios[1][note])
+                    || (scale->offset_cents[note] <= scale->offset_cents[note - 1])) {
+                result = 0;
+                break;
+            }
+            snprintf(char_buffer, sizeof(char_buffer), "%d", note + 1);
+            scale->note_name[note] = strdup(char_buffer);
+            note++;
+        }
+        // the period line and anything after it are only hashed
+    }
+
+    if ((notes < 0) || (note < notes)) {
+        result = 0;
+    }
+
+    fclose(fp);
+
+    if (result) {
+        scale->name = name;
+        scale->base_frequency = MID_C_FREQUENCY;
+        lingot_config_scale_update_index(scale);
+    } else {
+        free(name);
+    }
+
+    return result;
+}
+
+static void lingot_scale_library_entry_destroy(LingotScaleLibraryEntry* entry) {
+    free(entry->path);
+    free(entry->name);
+    free(entry->key);
+}
+
+static char* lingot_scale_library_make_key(const char* name, const char* path) {
+    const char* base = strrchr(path, '/');
+    base = base ? base + 1 : path;
+    size_t length = strlen(name) + strlen(base) + 2;
+    char* key = malloc(length);
+    char* c;
+
+    snprintf(key, length, "%s %s", name, base);
+    for (c = key; *c; c++) {
+        *c = (char) tolower((unsigned char) *c);
+    }
+
+    return key;
+}
+
+static LingotScaleLibraryEntry* lingot_scale_library_append(LingotScaleLibrary* library) {
+    if (library->n_entries == library->capacity) {
+        library->capacity = library->capacity ? 2 * library->capacity : 64;
+        library->entries = realloc(library->entries,
+                                   library->capacity * sizeof(LingotScaleLibraryEntry));
+    }
+
+    LingotScaleLibraryEntry* entry = &library->entries[library->n_entries++];
+    memset(entry, 0, sizeof(*entry));
+    return entry;
+}
+
+void lingot_scale_library_new(LingotScaleLibrary* library) {
+    library->directory = NULL;
+    library->n_entries = 0;
+    library->capacity = 0;
+    library->entries = NULL;
+}
+
+void lingot_scale_library_destroy(LingotScaleLibrary* library) {
+    unsigned int i;
+    for (i = 0; i < library->n_entries; i++) {
+        lingot_scale_library_entry_destroy(&library->entries[i]);
+    }
+    free(library->entries);
+    free(library->directory);
+    lingot_scale_library_new(library);
+}
+
+static int lingot_scale_library_compare_paths(const void* a, const void* b) {
+    return strcmp(((const LingotScaleLibraryEntry*) a)->path,
+                  ((const LingotScaleLibraryEntry*) b)->path);
+}
+
+static int lingot_scale_library_has_scl_extension(const char* name) {
+    size_t length = strlen(name);
+    return (length > 4) && !strcasecmp(name + length - 4, ".scl");
+}
+
+static void lingot_scale_library_scan_directory(LingotScaleLibrary* library,
+                                                const LingotScaleLibrary* previous, const char* directory, int depth) {
+    DIR* dir;
+    struct dirent* dirent;
+    struct stat st;
+    char path[4096];
+
+    if ((depth > 32) || ((dir = opendir(directory)) == NULL)) {
+        return;
+    }
+
+    while ((dirent = readdir(dir)) != NULL) {
+        if (dirent->d_name[0] == '.') {
+            continue;
+        }
+
+        snprintf(path, sizeof(path), "%s/%s", directory, dirent->d_name);
+        if (stat(path, &st)) {
+            continue;
+        }
+
+        if (S_ISDIR(st.st_mode)) {
+            lingot_scale_library_scan_directory(library, previous, path, depth + 1);
+            continue;
+        }
+
+        if (!S_ISREG(st.st_mode)
+                || !lingot_scale_library_has_scl_extension(dirent->d_name)) {
+            continue;
+        }
+
+        // the previous entries are sorted by path, so unchanged files are
+        // taken from the index without reading them
+        LingotScaleLibraryEntry pattern;
+        pattern.path = path;
+        const LingotScaleLibraryEntry* known = previous->n_entries ?
+                    bsearch(&pattern, previous->entries, previous->n_entries,
+                            sizeof(LingotScaleLibraryEntry),
+                            lingot_scale_library_compare_paths) : NULL;
+
+        if (known && (known->mtime == (long) st.st_mtime)
+                && (known->size == (long) st.st_size)) {
+            LingotScaleLibraryEntry* entry = lingot_scale_library_append(library);
+            *entry = *known;
+            entry->path = strdup(known->path);
+            entry->name = strdup(known->name);
+            entry->key = strdup(known->key);
+            continue;
+        }
+
+        LingotScale scale;
+        unsigned int hash;
+        lingot_config_scale_new(&scale);
+        if (lingot_scale_library_parse_file(path, &scale, &hash)) {
+            LingotScaleLibraryEntry* entry = lingot_scale_library_append(library);
+            entry->path = strdup(path);
+            entry->name = strdup(scale.name);
+            entry->key = lingot_scale_library_make_key(entry->name, entry->path);
+            entry->notes = scale.notes;
+            entry->hash = hash;
+            entry->mtime = (long) st.st_mtime;
+            entry->size = (long) st.st_size;
+        }
+        lingot_config_scale_destroy(&scale);
+    }
+
+    closedir(dir);
+}
+
+unsigned int lingot_scale_library_scan_from(LingotScaleLibrary* library,
+                                           const LingotScaleLibrary* previous, const char* directory) {
+    lingot_scale_library_destroy(library);
+    library->directory = strdup(directory);
+
+    lingot_scale_library_scan_directory(library, previous, directory, 0);
+
+    if (library->n_entries) {
+        qsort(library->entries, library->n_entries, sizeof(LingotScaleLibraryEntry),
+              lingot_scale_library_compare_paths);
+    }
+
+    return library->n_entries;
+}
+
+unsigned int lingot_scale_library_scan(LingotScaleLibrary* library, const char* directory) {
+    LingotScaleLibrary previous = *library;
+
+    lingot_scale_library_new(library);
+    lingot_scale_library_scan_from(library, &previous, directory);
+    lingot_scale_library_destroy(&previous);
+
+    return library->n_entries;
+}
+
+/*
+ * The index is a text file with a header line holding the scanned directory,
+ * and one line per scale with tab separated fields:
+ *
+ *   hash  mtime  size  notes  path  name
+ */
+
+#define SCALE_LIBRARY_INDEX_HEADER "# lingot scale library index, version 2"
+
+int lingot_scale_library_save_index(const LingotScaleLibrary* library,
+                                    const char* filename) {
+    FILE* fp;
+    unsigned int i;
+
+    if ((fp = fopen(filename, "w")) == NULL) {
+        return 0;
+    }
+
+    fprintf(fp, "%s\n", SCALE_LIBRARY_INDEX_HEADER);
+    fprintf(fp, "DIRECTORY\t%s\n", library->directory ? library->directory : "");
+
+    for (i = 0; i < library->n_entries; i++) {
+        const LingotScaleLibraryEntry* entry = &library->entries[i];
+        fprintf(fp, "%08x\t%ld\t%ld\t%hu\t%s\t%s\n", entry->hash, entry->mtime,
+                entry->size, entry->notes, entry->path, entry->name);
+    }
+
+    return !fclose(fp);
+}
+
+// reads a whole line of arbitrary length, returns NULL at end of file
+static char* lingot_scale_library_read_line(FILE* fp, char** buffer, size_t* size) {
+    size_t length = 0;
+
+    for (;;) {
+        if (*size - length < 2) {
+            *size = *size ? 2 * *size : SCALE_LIBRARY_MAX_LINE_SIZE;
+            *buffer = realloc(*buffer, *size);
+        }
+        if (!fgets(*buffer + length, (int) (*size - length), fp)) {
+            return length ? *buffer : NULL;
+        }
+        length += strlen(*buffer + length);
+        if ((*buffer)[length - 1] == '\n') {
+            (*buffer)[length - 1] = '\0';
+            return *buffer;
+        }
+    }
+}
+
+int lingot_scale_library_load_index(LingotScaleLibrary* library,
+                                    const char* filename) {
+    FILE* fp;
+    char* line = NULL;
+    size_t size = 0;
+    int result = 1;
+
+    if ((fp = fopen(filename, "r")) == NULL) {
+        return 0;
+    }
+
+    // indexes written by other versions are ignored, the library has to be
+    // scanned again.
+    if (!lingot_scale_library_read_line(fp, &line, &size)
+            || strcmp(line, SCALE_LIBRARY_INDEX_HEADER)) {
+        free(line);
+        fclose(fp);
+        return 0;
+    }
+
+    lingot_scale_library_destroy(library);
+
+    while (result && lingot_scale_library_read_line(fp, &line, &size)) {
+        char* fields[6];
+        char* cursor = line;
+        unsigned int n_fields = 0;
+
+        if ((line[0] == '#') || (line[0] == '\0')) {
+            continue;
+        }
+
+        if (!strncmp(line, "DIRECTORY\t", 10)) {
+            free(library->directory);
+            library->directory = strdup(line + 10);
+            continue;
+        }
+
+        // the name is the last field, so it may contain tabs
+        while (n_fields < 5) {
+            fields[n_fields++] = cursor;
+            cursor = strchr(cursor, '\t');
+            if (!cursor) {
+                break;
+            }
+            *cursor++ = '\0';
+        }
+        if (!cursor) {
+            result = 0;
+            break;
+        }
+        fields[n_fields++] = cursor;
+
+        LingotScaleLibraryEntry* entry = lingot_scale_library_append(library);
+        entry->hash = (unsigned int) strtoul(fields[0], NULL, 16);
+        entry->mtime = strtol(fields[1], NULL, 10);
+        entry->size = strtol(fields[2], NULL, 10);
+        entry->notes = (unsigned short int) strtoul(fields[3], NULL, 10);
+        entry->path = strdup(fields[4]);
+        entry->name = strdup(fields[5]);
+        entry->key = lingot_scale_library_make_key(entry->name, entry->path);
+    }
+
+    free(line);
+    fclose(fp);
+
+    if (!result) {
+        lingot_scale_library_destroy(library);
+    } else if (library->n_entries) {
+        qsort(library->entries, library->n_entries, sizeof(LingotScaleLibraryEntry),
+              lingot_scale_library_compare_paths);
+    }
+
+    return result;
+}
+
+unsigned int lingot_scale_library_search(const LingotScaleLibrary* library,
+                                         const char* text, unsigned int* results, unsigned int max_results) {
+    char pattern[SCALE_LIBRARY_MAX_LINE_SIZE];
+    unsigned int i, n = 0;
+    size_t j;
+
+    for (j = 0; text[j] && (j < sizeof(pattern) - 1); j++) {
+        pattern[j] = (char) tolower((unsigned char) text[j]);
+    }
+    pattern[j] = '\0';
+
+    for (i = 0; (i < library->n_entries) && (n < max_results); i++) {
+        if (strstr(library->entries[i].key, pattern)) {
+            results[n++] = i;
+        }
+    }
+
+    return n;
+}
+
+int lingot_scale_library_load_scale(const LingotScaleLibrary* library,
+                                    unsigned int index, LingotScale* scale) {
+    LingotScale loaded;
+    unsigned int hash;
+    int result;
+
+    if (index >= library->n_entries) {
+        return 0;
+    }
+
+    lingot_config_scale_new(&loaded);
+    result = lingot_scale_library_parse_file(library->entries[index].path,
+                                             &loaded, &hash)
+            && (hash == library->entries[index].hash);
+    if (result) {
+        lingot_config_scale_copy(scale, &loaded);
+    }
+    lingot_config_scale_destroy(&loaded);
+
+    return result;
+}
@@ -0,0 +1,84 @@
+/*
+ * lingot, a musical instrument tuner.
+ *
+ * Copyright (C) 2004-2019  Iban Cereijo.
+ * Copyright (C) 2004-2008  Jairo Chapela.
+
+ *
+ * This file is part of lingot.
+ *
+ * lingot is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * lingot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with lingot; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LINGOT_IO_SCALE_LIBRARY_H
+#define LINGOT_IO_SCALE_LIBRARY_H
+
+#include "lingot-config-scale.h"
+
+/*
+ * Library of Scala (.scl) scales found in a directory tree. A compact index
+ * with the name, note count and content hash of each scale is kept in a file,
+ * so the library can be searched without reading the scales, and a scale is
+ * only fully parsed when it is selected.
+ */
+
+#define SCALE_LIBRARY_INDEX_FILE_NAME "scales.idx"
+
+typedef struct {
+    char* path; // .scl file
+    char* name; // description of the scale
+    char* key; // lowercase name and file name, for searching
+    unsigned short int notes;
+    unsigned int hash; // hash of the file contents
+    long mtime; // modification time and size of the indexed file
+    long size;
+} LingotScaleLibraryEntry;
+
+typedef struct {
+    char* directory; // root of the scanned tree
+    unsigned int n_entries;
+    unsigned int capacity;
+    LingotScaleLibraryEntry* entries;
+} LingotScaleLibrary;
+
+void lingot_scale_library_new(LingotScaleLibrary*);
+void lingot_scale_library_destroy(LingotScaleLibrary*);
+
+// scans the given directory tree, reusing the entries of the files that have
+// not changed since they were indexed. Returns the number of scales found.
+unsigned int lingot_scale_library_scan(LingotScaleLibrary*, const char* directory);
+
+// same as above, but the entries are taken from a previous library, which is
+// left untouched, so that it can still be searched while scanning. Both must
+// be initialized with _new.
+unsigned int lingot_scale_library_scan_from(LingotScaleLibrary*,
+                                           const LingotScaleLibrary* previous, const char* directory);
+
+// loads and saves the index, return 0 on failure.
+int lingot_scale_library_load_index(LingotScaleLibrary*, const char* filename);
+int lingot_scale_library_save_index(const LingotScaleLibrary*, const char* filename);
+
+// finds the scales whose name or file name contain the given text, ignoring
+// case. Returns the number of matches stored in results.
+unsigned int lingot_scale_library_search(const LingotScaleLibrary*,
+                                         const char* text, unsigned int* results, unsigned int max_results);
+
+// parses the given scale of the library. The scale argument must be
+// initialized with _new. Returns 0 on failure, or if the file has changed
+// since it was indexed.
+int lingot_scale_library_load_scale(const LingotScaleLibrary*,
+                                    unsigned int index, LingotScale* scale);
+
+#endif // LINGOT_IO_SCALE_LIBRARY_H
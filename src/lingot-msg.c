@@ -24,19 +24,71 @@
 
 #include <stdio.h>
 #include <string.h>
-#include <pthread.h>
 
 #include "lingot-msg.h"
 
-#define MAX_MESSAGES 	5
+/*
+ * Bounded multiple-producer queue after D. Vyukov. Each cell carries a
+ * sequence number telling whether it is free for the enqueue position or
+ * ready for the dequeue one, so the producers only contend on an atomic
+ * increment of the enqueue position.
+ */
+
+#define MAX_MESSAGES 	16 // must be a power of two
+
+typedef struct {
+    // sequence number minus the cell index, so that the queue is ready
+    // with a zero initialization.
+    unsigned long sequence;
+    unsigned int hash;
+    LingotMessage message;
+} LingotMessageCell;
+
+static LingotMessageCell cells[MAX_MESSAGES];
 
-char message[MAX_MESSAGES][1000];
-message_type_t message_type[MAX_MESSAGES];
-int error_codes[MAX_MESSAGES];
+static unsigned long enqueue_position = 0;
+static unsigned long dequeue_position = 0; // only used by the consumer
 
-int front = 0, rear = 0;
+// position plus one of the latest message enqueued and not yet consumed, for
+// coalescing, or zero if there is none.
+static unsigned long pending_position = 0;
 
-pthread_mutex_t message_queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+static unsigned long dropped_messages = 0;
+static unsigned long coalesced_messages = 0;
+static unsigned long reported_dropped_messages = 0; // only used by the consumer
+
+#define CELL_SEQUENCE(i) (__atomic_load_n(&cells[(i)].sequence, __ATOMIC_ACQUIRE) + (i))
+#define SET_CELL_SEQUENCE(i, s) __atomic_store_n(&cells[(i)].sequence, (s) - (i), __ATOMIC_RELEASE)
+
+// FNV-1a, never zero.
+static unsigned int lingot_msg_hash(const char* msg, message_type_t type) {
+    unsigned int hash = 2166136261u ^ (unsigned int) type;
+    unsigned int i;
+    for (i = 0; (i < LINGOT_MSG_MAX_LENGTH) && msg[i]; i++) {
+        hash = (hash ^ (unsigned char) msg[i]) * 16777619u;
+    }
+    return hash ? hash : 1;
+}
+
+// tells whether the given message is the latest one pending. The cell can
+// only be rewritten after being consumed, so its text is compared only while
+// its sequence number shows that it is still ready to be consumed.
+static int lingot_msg_is_pending(const char* msg, message_type_t type,
+                                 unsigned int hash) {
+    const unsigned long position = __atomic_load_n(&pending_position, __ATOMIC_RELAXED);
+    if (!position) {
+        return 0;
+    }
+
+    const unsigned int index = (position - 1) & (MAX_MESSAGES - 1);
+    if ((CELL_SEQUENCE(index) != position) || (cells[index].hash != hash)) {
+        return 0;
+    }
+
+    const int same = (cells[index].message.type == type)
+            && !strncmp(cells[index].message.text, msg, LINGOT_MSG_MAX_LENGTH - 1);
+    return same && (CELL_SEQUENCE(index) == position);
+}
 
 void lingot_msg_add_error(const char* msg) {
     lingot_msg_add(msg, ERROR, 0);
@@ -56,50 +108,78 @@ void lingot_msg_add_info(const char* msg) {
 
 void lingot_msg_add(const char* msg, message_type_t type, int error_code) {
 
-    pthread_mutex_lock(&message_queue_mutex);
-    if (front == ((rear + 1) % MAX_MESSAGES)) {
-        fprintf(stderr, "warning: the messages queue is full!\n");
-    } else {
-        // check if the message is already in the queue
-        int duplicated = 0;
-        int i = front;
-        while (i != rear) {
-            i = (i + 1) % MAX_MESSAGES;
-            if (!strcmp(message[i], msg)) {
-                duplicated = 1;
-                fprintf(stderr, "warning: duplicated message: %s\n", msg);
-                break;
-            }
-        }
+    const unsigned int hash = lingot_msg_hash(msg, type);
+
+    // the same message is already waiting to be consumed.
+    if (lingot_msg_is_pending(msg, type, hash)) {
+        __atomic_add_fetch(&coalesced_messages, 1, __ATOMIC_RELAXED);
+        return;
+    }
 
-        if (!duplicated) {
-            rear = ((rear + 1) % MAX_MESSAGES);
-            strcpy(message[rear], msg);
-            message_type[rear] = type;
-            error_codes[rear] = error_code;
+    unsigned long position = __atomic_load_n(&enqueue_position, __ATOMIC_RELAXED);
+    unsigned int index;
 
-            if (type != INFO) {
-                fprintf(stderr, "%s: %s\n",
-                        (type == ERROR) ? "error" : "warning", msg);
+    for (;;) {
+        index = position & (MAX_MESSAGES - 1);
+        const long diff = (long) (CELL_SEQUENCE(index) - position);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&enqueue_position, &position,
+                                            position + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
             }
+        } else if (diff < 0) {
+            // full
+            __atomic_add_fetch(&dropped_messages, 1, __ATOMIC_RELAXED);
+            return;
+        } else {
+            position = __atomic_load_n(&enqueue_position, __ATOMIC_RELAXED);
         }
     }
-    pthread_mutex_unlock(&message_queue_mutex);
+
+    LingotMessage* const message = &cells[index].message;
+    strncpy(message->text, msg, LINGOT_MSG_MAX_LENGTH - 1);
+    message->text[LINGOT_MSG_MAX_LENGTH - 1] = '\0';
+    message->type = type;
+    message->error_code = error_code;
+    cells[index].hash = hash;
+
+    SET_CELL_SEQUENCE(index, position + 1);
+    __atomic_store_n(&pending_position, position + 1, __ATOMIC_RELAXED);
 }
 
-int lingot_msg_get(char** msg, message_type_t* type, int* error_code) {
-    int result = 0;
-    *msg = NULL;
-
-    pthread_mutex_lock(&message_queue_mutex);
-    if (front != rear) {
-        front = (front + 1) % MAX_MESSAGES;
-        *msg = strdup(message[front]);
-        *type = message_type[front];
-        *error_code = error_codes[front];
-        result = 1;
+int lingot_msg_get(LingotMessage* message) {
+
+    const unsigned int index = dequeue_position & (MAX_MESSAGES - 1);
+
+    const unsigned long dropped = __atomic_load_n(&dropped_messages, __ATOMIC_RELAXED);
+    if (dropped != reported_dropped_messages) {
+        fprintf(stderr, "warning: the messages queue is full, %lu messages dropped\n",
+                dropped - reported_dropped_messages);
+        reported_dropped_messages = dropped;
     }
-    pthread_mutex_unlock(&message_queue_mutex);
 
-    return result;
+    if (CELL_SEQUENCE(index) != dequeue_position + 1) {
+        return 0;
+    }
+
+    *message = cells[index].message;
+    SET_CELL_SEQUENCE(index, dequeue_position + MAX_MESSAGES);
+    dequeue_position++;
+
+    // from now on, the same message is shown again.
+    unsigned long expected = dequeue_position;
+    __atomic_compare_exchange_n(&pending_position, &expected, 0, 0,
+                                __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+
+    if (message->type != INFO) {
+        fprintf(stderr, "%s: %s\n",
+                (message->type == ERROR) ? "error" : "warning", message->text);
+    }
+
+    return 1;
+}
+
+void lingot_msg_get_counters(unsigned long* dropped, unsigned long* coalesced) {
+    *dropped = __atomic_load_n(&dropped_messages, __ATOMIC_RELAXED);
+    *coalesced = __atomic_load_n(&coalesced_messages, __ATOMIC_RELAXED);
 }
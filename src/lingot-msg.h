@@ -25,21 +25,37 @@
 #ifndef LINGOT_MESSAGES_H
 #define LINGOT_MESSAGES_H
 
-// asynchronous message handling
+// asynchronous message handling. Messages can be added from any thread,
+// including the realtime audio ones, without blocking nor allocating, and
+// they are consumed by a single thread (the GUI).
+
+#define LINGOT_MSG_MAX_LENGTH	1000
 
 // message types
 typedef enum message_type_t {
     ERROR = 0, WARNING = 1, INFO = 2
 } message_type_t;
 
-// add messages to the queue
+// preformatted message record
+typedef struct {
+    char text[LINGOT_MSG_MAX_LENGTH];
+    message_type_t type;
+    int error_code;
+} LingotMessage;
+
+// add messages to the queue. If the queue is full the message is dropped, and
+// if it is identical to the latest one still pending, it is coalesced with it.
 void lingot_msg_add(const char* message, message_type_t type, int error_code);
 void lingot_msg_add_error(const char* message);
 void lingot_msg_add_error_with_code(const char* message, int error_code);
 void lingot_msg_add_warning(const char* message);
 void lingot_msg_add_info(const char* message);
 
-// gets a message from the queue, it returns 0 if no messages are available
-int lingot_msg_get(char** msg, message_type_t* type, int* error_code);
+// copies a message from the queue into the given record, it returns 0 if no
+// messages are available
+int lingot_msg_get(LingotMessage* message);
+
+// number of messages dropped and coalesced so far
+void lingot_msg_get_counters(unsigned long* dropped, unsigned long* coalesced);
 
 #endif
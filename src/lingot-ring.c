@@ -0,0 +1,129 @@
+/*
+ * lingot, a musical instrument tuner.
+ *
+ * Copyright (C) 2004-2019  Iban Cereijo.
+ * Copyright (C) 2004-2008  Jairo Chapela.
+
+ *
+ * This file is part of lingot.
+ *
+ * lingot is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * lingot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with lingot; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "lingot-ring.h"
+
+// each record starts with its type and length, and it is padded so that the
+// headers are always aligned.
+typedef struct {
+    unsigned int type;
+    unsigned int length;
+} LingotRingRecordHeader;
+
+#define LINGOT_RING_ALIGNMENT sizeof(LingotRingRecordHeader)
+
+static unsigned int lingot_ring_padded(unsigned int length) {
+    return (length + LINGOT_RING_ALIGNMENT - 1) & ~(LINGOT_RING_ALIGNMENT - 1);
+}
+
+int lingot_ring_new(LingotRing* ring, unsigned int size) {
+    unsigned int actual_size = 64;
+
+    while (actual_size < size) {
+        actual_size <<= 1;
+    }
+
+    ring->buffer = malloc(actual_size);
+    ring->size = ring->buffer ? actual_size : 0;
+    ring->mask = ring->size - 1;
+    ring->head = 0;
+    ring->tail = 0;
+    ring->dropped = 0;
+
+    return ring->buffer != NULL;
+}
+
+void lingot_ring_destroy(LingotRing* ring) {
+    free(ring->buffer);
+    ring->buffer = NULL;
+    ring->size = 0;
+}
+
+// copies into the ring at the given position, wrapping around the end.
+static void lingot_ring_copy_in(LingotRing* ring, unsigned int position,
+                                const void* data, unsigned int length) {
+    const unsigned int offset = position & ring->mask;
+    const unsigned int first = (length < ring->size - offset) ?
+                length : ring->size - offset;
+    memcpy(ring->buffer + offset, data, first);
+    memcpy(ring->buffer, (const unsigned char*) data + first, length - first);
+}
+
+static void lingot_ring_copy_out(const LingotRing* ring, unsigned int position,
+                                 void* data, unsigned int length) {
+    const unsigned int offset = position & ring->mask;
+    const unsigned int first = (length < ring->size - offset) ?
+                length : ring->size - offset;
+    memcpy(data, ring->buffer + offset, first);
+    memcpy((unsigned char*) data + first, ring->buffer, length - first);
+}
+
+int lingot_ring_write(LingotRing* ring, unsigned int type,
+                      const void* data, unsigned int length) {
+    const unsigned int tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    const unsigned int needed = sizeof(LingotRingRecordHeader)
+            + lingot_ring_padded(length);
+    LingotRingRecordHeader header;
+
+    // the counters wrap around, their difference is the used space.
+    if ((length > ring->size) || (needed > ring->size - (ring->head - tail))) {
+        __atomic_store_n(&ring->dropped, ring->dropped + 1, __ATOMIC_RELAXED);
+        return 0;
+    }
+
+    header.type = type;
+    header.length = length;
+    lingot_ring_copy_in(ring, ring->head, &header, sizeof(header));
+    lingot_ring_copy_in(ring, ring->head + sizeof(header), data, length);
+
+    __atomic_store_n(&ring->head, ring->head + needed, __ATOMIC_RELEASE);
+    return 1;
+}
+
+int lingot_ring_read(LingotRing* ring, unsigned int* type,
+                     void* data, unsigned int max_length) {
+    const unsigned int head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    LingotRingRecordHeader header;
+
+    if (head == ring->tail) {
+        return -1;
+    }
+
+    lingot_ring_copy_out(ring, ring->tail, &header, sizeof(header));
+    lingot_ring_copy_out(ring, ring->tail + sizeof(header), data,
+                         (header.length < max_length) ? header.length : max_length);
+    *type = header.type;
+
+    __atomic_store_n(&ring->tail,
+                     ring->tail + sizeof(header) + lingot_ring_padded(header.length),
+                     __ATOMIC_RELEASE);
+    return (int) header.length;
+}
+
+unsigned long lingot_ring_get_dropped(const LingotRing* ring) {
+    return __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,64 @@
+/*
+ * lingot, a musical instrument tuner.
+ *
+ * Copyright (C) 2004-2019  Iban Cereijo.
+ * Copyright (C) 2004-2008  Jairo Chapela.
+
+ *
+ * This file is part of lingot.
+ *
+ * lingot is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * lingot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with lingot; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LINGOT_RING_H
+#define LINGOT_RING_H
+
+/*
+ * Lock-free ring buffer of variable length records, with a single producer
+ * and a single consumer. Writing never blocks nor allocates, so it can be
+ * done from the audio and analysis threads: the records that do not fit are
+ * dropped and counted.
+ */
+
+typedef struct {
+    unsigned char* buffer;
+    unsigned int size; // power of two
+    unsigned int mask;
+
+    unsigned int head; // bytes written, updated by the producer
+    unsigned int tail; // bytes read, updated by the consumer
+
+    unsigned long dropped; // records dropped by the producer
+} LingotRing;
+
+// creates a ring of at least the given size in bytes. Returns 0 on failure.
+int lingot_ring_new(LingotRing*, unsigned int size);
+void lingot_ring_destroy(LingotRing*);
+
+// appends a record of the given type, only from the producer thread.
+// Returns 0 if it has been dropped because the ring is full.
+int lingot_ring_write(LingotRing*, unsigned int type,
+                      const void* data, unsigned int length);
+
+// takes the oldest record, only from the consumer thread. The data buffer
+// must be able to hold the longest record written, longer records are
+// truncated. Returns the length of the record, or -1 if the ring is empty.
+int lingot_ring_read(LingotRing*, unsigned int* type,
+                     void* data, unsigned int max_length);
+
+// records dropped so far, it can be read from any thread.
+unsigned long lingot_ring_get_dropped(const LingotRing*);
+
+#endif // LINGOT_RING_H
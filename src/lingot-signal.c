@@ -89,24 +89,26 @@ static FLT lingot_signal_frequency_penalty(FLT freq) {
     return freq * freqPenaltyA + freqPenaltyB;
 }
 
-// search the fundamental peak given the SPD and its 2nd derivative
-FLT lingot_signal_estimate_fundamental_frequency(const FLT* snr,
-                                                 FLT freq,
-                                                 const LingotComplex* fft,
-                                                 unsigned int N,
-                                                 unsigned int n_peaks,
-                                                 unsigned int lowest_index,
-                                                 unsigned int highest_index,
-                                                 unsigned short peak_half_width,
-                                                 FLT delta_f_fft,
-                                                 FLT min_snr,
-                                                 FLT min_q,
-                                                 FLT min_freq,
-                                                 LingotCore* core,
-                                                 short* divisor) {
+// finds the n_peaks highest peaks with SNR above the required, giving more
+// importance to the harmonics of the given frequencies. The peaks much lower
+// than the maximum are discarded. Returns the number of peaks, stored in
+// increasing order with their interpolated frequencies.
+static unsigned int lingot_signal_find_peaks(const FLT* snr,
+                                             const FLT* freqs,
+                                             unsigned int n_freqs,
+                                             const LingotComplex* fft,
+                                             unsigned int N,
+                                             unsigned int n_peaks,
+                                             unsigned int lowest_index,
+                                             unsigned int highest_index,
+                                             unsigned short peak_half_width,
+                                             FLT delta_f_fft,
+                                             FLT min_snr,
+                                             LingotCore* core,
+                                             int* p_index,
+                                             FLT* freq_interpolated) {
     register unsigned int i, j, m;
-    int p_index[n_peaks];
-    FLT magnitude[n_peaks];
+    FLT magnitude[LINGOT_SIGNAL_MAX_PEAKS];
 
 #ifdef DRAW_MARKERS
     core->markers_size = 0;
@@ -132,11 +134,12 @@ FLT lingot_signal_estimate_fundamental_frequency(const FLT* snr,
 
         FLT factor = 1.0;
 
-        if (freq != 0.0) {
+        for (j = 0; j < n_freqs; j++) {
 
             FLT f = i * delta_f_fft;
-            if (fabs(f / freq - round(f / freq)) < 0.07) { // TODO: tune and put in conf
+            if (fabs(f / freqs[j] - round(f / freqs[j])) < 0.07) { // TODO: tune and put in conf
                 factor = 1.5; // TODO: tune and put in conf
+                break;
             }
 
         }
@@ -177,7 +180,7 @@ FLT lingot_signal_estimate_fundamental_frequency(const FLT* snr,
     }
 
     if (n_found_peaks == 0) {
-        return 0.0;
+        return 0;
     }
 
     FLT maximum = 0.0;
@@ -200,7 +203,6 @@ FLT lingot_signal_estimate_fundamental_frequency(const FLT* snr,
     qsort(p_index, n_found_peaks, sizeof(int), &lingot_signal_compare_int);
     n_found_peaks -= delete_counter;
 
-    FLT freq_interpolated[n_found_peaks];
     FLT delta = 0.0;
     for (i = 0; i < n_found_peaks; i++) {
         delta = lingot_signal_fft_bin_interpolate_quinn2(fft[p_index[i] - 1],
@@ -208,13 +210,34 @@ FLT lingot_signal_estimate_fundamental_frequency(const FLT* snr,
         freq_interpolated[i] = delta_f_fft * (p_index[i] + delta);
 
 #ifdef DRAW_MARKERS
-        core->markers[core->markers_size++] = p_index[i];
+        if (core->markers_size < (short) (sizeof(core->markers) / sizeof(int))) {
+            core->markers[core->markers_size++] = p_index[i];
+        }
 #endif
     }
 
+    return n_found_peaks;
+}
+
+// selects the harmonic group with the best quality factor among the peaks
+// not used yet (used can be NULL), and flags its peaks in members. The ground
+// frequency is searched up to the max_divisor subharmonic of each peak.
+// Returns the frequency of its strongest harmonic, being divisor the number of
+// that harmonic, or 0 if there is no group with the minimum quality.
+static FLT lingot_signal_best_harmonic_group(const FLT* snr,
+                                             const int* p_index,
+                                             const FLT* freq_interpolated,
+                                             unsigned int n_found_peaks,
+                                             FLT min_q,
+                                             FLT min_freq,
+                                             short max_divisor,
+                                             const char* used,
+                                             char* members,
+                                             short* divisor) {
+    register unsigned int i;
+
     // maximum ratio error
     static const FLT ratioTol = 0.02; // TODO: tune
-    static const short max_divisor = 4;
 
     unsigned short tone_index = 0;
     short div = 0;
@@ -226,16 +249,23 @@ FLT lingot_signal_estimate_fundamental_frequency(const FLT* snr,
 
     FLT bestQ = 0.0;
     short best_indices_related[n_found_peaks];
+    unsigned short best_n_indices_related = 0;
     FLT bestF = 0;
     short bestDivisor = 1;
 
     // possible ground frequencies
     for (tone_index = 0; tone_index < n_found_peaks; tone_index++) {
+        if (used && used[tone_index]) {
+            continue;
+        }
         for (div = 1; div <= max_divisor; div++) {
             groundFreq = freq_interpolated[tone_index] / div;
             if (groundFreq > min_freq) {
                 n_indices_related = 0;
                 for (i = 0; i < n_found_peaks; i++) {
+                    if (used && used[i]) {
+                        continue;
+                    }
                     ratios[i] = freq_interpolated[i] / groundFreq;
                     error[i] = (ratios[i] - round(ratios[i]));
                     // harmonically related frequencies
@@ -245,12 +275,10 @@ FLT lingot_signal_estimate_fundamental_frequency(const FLT* snr,
                 }
 
                 // add the penalties for short sets and high divisors
-                //				int highest_harmonic_index = n_indices_related - 1;
                 int highest_harmonic_index = 0;
                 FLT highest_harmonic_magnitude = 0.0;
                 FLT q = 0.0;
                 FLT f = 0.0;
-                //				FLT snrsum = 0.0;
                 for (i = 0; i < n_indices_related; i++) {
                     // add up contributions to the quality factor
                     q += snr[p_index[indices_related[i]]]
@@ -261,44 +289,17 @@ FLT lingot_signal_estimate_fundamental_frequency(const FLT* snr,
                         highest_harmonic_magnitude =
                                 snr[p_index[indices_related[i]]];
                     }
-
-                    //					snrsum += snr[p_index[indices_related[i]]];
-                    //					short myDivisor = round(
-                    //							freq_interpolated[indices_related[i]] / groundFreq);
-                    //					f += snr[p_index[indices_related[i]]]
-                    //							* freq_interpolated[indices_related[i]] / myDivisor;
                 }
 
                 f = freq_interpolated[indices_related[highest_harmonic_index]];
 
-                //				f /= snrsum;
-
-                //				printf(">>>>>>>>>< f = %f\n", f);
-
-                //				printf(
-                //						"tone = %i, divisor = %i, gf = %f, q = %f, n = %i, f = %f, ",
-                //						tone, divisor, groundFreq, q, n_indices_related, f);
-                //				for (i = 0; i < n_indices_related; i++) {
-                //					printf("%f ", freq_interpolated[indices_related[i]]);
-                //				}
-                //				printf("\n");
-
                 if (q > bestQ) {
                     bestQ = q;
                     memcpy(best_indices_related, indices_related,
                            n_indices_related * sizeof(short));
+                    best_n_indices_related = n_indices_related;
                     bestDivisor = round(f / groundFreq);
                     bestF = f;
-
-#ifdef DRAW_MARKERS
-                    core->markers_size2 = 0;
-                    for (i = 0; i < n_indices_related; i++) {
-                        core->markers2[core->markers_size2++] =
-                                p_index[indices_related[i]];
-                    }
-#endif
-
-                    //					printf("%d\n", n_indices_related);
                 }
 
             } else {
@@ -307,52 +308,202 @@ FLT lingot_signal_estimate_fundamental_frequency(const FLT* snr,
         }
     }
 
-    //	printf("BEST selected f = %f, f* = %f, div = %i, q = %f, n = %i, ",
-    //			bestF / bestDivisor, bestDivisor, bestF, bestQ,
-    //			best_n_indices_related);
-    //	for (i = 0; i < best_n_indices_related; i++) {
-    //		printf("%f ", freq_interpolated[best_indices_related[i]]);
-    //	}
-    //	printf("\n");
-
     if ((bestF != 0.0) && (bestQ < min_q)) {
         bestF = 0.0;
-        //		printf("q < mq!!\n");
     }
 
+    memset(members, 0, n_found_peaks);
+    if (bestF != 0.0) {
+        for (i = 0; i < best_n_indices_related; i++) {
+            members[best_indices_related[i]] = 1;
+        }
+    }
+
+    *divisor = bestDivisor;
+    return bestF;
+}
+
 #ifdef DRAW_MARKERS
-    if (bestF == 0.0) {
-        core->markers_size2 = 0;
+static void lingot_signal_add_group_markers(LingotCore* core, const int* p_index,
+                                            const char* members, unsigned int n_found_peaks) {
+    unsigned int i;
+    for (i = 0; i < n_found_peaks; i++) {
+        if (members[i] && (core->markers_size2
+                           < (short) (sizeof(core->markers2) / sizeof(int)))) {
+            core->markers2[core->markers_size2++] = p_index[i];
+        }
     }
+}
+#endif
+
+// search the fundamental peak given the SPD and its 2nd derivative
+FLT lingot_signal_estimate_fundamental_frequency(const FLT* snr,
+                                                 FLT freq,
+                                                 const LingotComplex* fft,
+                                                 unsigned int N,
+                                                 unsigned int n_peaks,
+                                                 unsigned int lowest_index,
+                                                 unsigned int highest_index,
+                                                 unsigned short peak_half_width,
+                                                 FLT delta_f_fft,
+                                                 FLT min_snr,
+                                                 FLT min_q,
+                                                 FLT min_freq,
+                                                 LingotCore* core,
+                                                 short* divisor) {
+    int p_index[LINGOT_SIGNAL_MAX_PEAKS];
+    FLT freq_interpolated[LINGOT_SIGNAL_MAX_PEAKS];
+    char members[LINGOT_SIGNAL_MAX_PEAKS];
+
+    if (n_peaks > LINGOT_SIGNAL_MAX_PEAKS) {
+        n_peaks = LINGOT_SIGNAL_MAX_PEAKS;
+    }
+
+#ifdef DRAW_MARKERS
+    core->markers_size2 = 0;
+#endif
+
+    unsigned int n_found_peaks = lingot_signal_find_peaks(snr, &freq,
+                                                          (freq != 0.0) ? 1 : 0, fft, N, n_peaks, lowest_index,
+                                                          highest_index, peak_half_width, delta_f_fft, min_snr, core,
+                                                          p_index, freq_interpolated);
+
+    if (n_found_peaks == 0) {
+        return 0.0;
+    }
+
+    FLT bestF = lingot_signal_best_harmonic_group(snr, p_index,
+                                                  freq_interpolated, n_found_peaks, min_q, min_freq, 4, NULL,
+                                                  members, divisor);
+
+#ifdef DRAW_MARKERS
+    lingot_signal_add_group_markers(core, p_index, members, n_found_peaks);
 #endif
 
-    *divisor = bestDivisor;
     return bestF;
+}
+
+unsigned int lingot_signal_estimate_fundamental_frequencies(const FLT* snr,
+                                                            const FLT* freqs,
+                                                            unsigned int n_freqs,
+                                                            const LingotComplex* fft,
+                                                            unsigned int N,
+                                                            unsigned int n_peaks,
+                                                            unsigned int lowest_index,
+                                                            unsigned int highest_index,
+                                                            unsigned short peak_half_width,
+                                                            FLT delta_f_fft,
+                                                            FLT min_snr,
+                                                            FLT min_q,
+                                                            FLT min_freq,
+                                                            LingotCore* core,
+                                                            unsigned int max_tones,
+                                                            FLT* tones,
+                                                            short* divisors) {
+    int p_index[LINGOT_SIGNAL_MAX_PEAKS];
+    FLT freq_interpolated[LINGOT_SIGNAL_MAX_PEAKS];
+    char members[LINGOT_SIGNAL_MAX_PEAKS];
+    char used[LINGOT_SIGNAL_MAX_PEAKS];
+    unsigned int i, k, n_tones = 0;
+
+    if (n_peaks > LINGOT_SIGNAL_MAX_PEAKS) {
+        n_peaks = LINGOT_SIGNAL_MAX_PEAKS;
+    }
+
+    // the same ground frequency with a different divisor is not a new tone.
+    static const FLT same_tone_tol = 0.03;
+
+#ifdef DRAW_MARKERS
+    core->markers_size2 = 0;
+#endif
+
+    unsigned int n_found_peaks = lingot_signal_find_peaks(snr, freqs, n_freqs,
+                                                          fft, N, n_peaks, lowest_index, highest_index, peak_half_width,
+                                                          delta_f_fft, min_snr, core, p_index, freq_interpolated);
+
+    memset(used, 0, sizeof(used));
+
+    // the groups are taken greedily, each one from the peaks left by the
+    // previous ones. The subharmonics of a note in a chord easily gather the
+    // harmonics of other notes (e.g. G2 from G3 and D4), so each note must
+    // have its fundamental peak.
+    while ((n_tones < max_tones) && (n_found_peaks > 0)) {
+        FLT f = lingot_signal_best_harmonic_group(snr, p_index,
+                                                  freq_interpolated, n_found_peaks, min_q, min_freq, 1, used,
+                                                  members, &divisors[n_tones]);
+        if (f == 0.0) {
+            break;
+        }
+
+        for (i = 0; i < n_found_peaks; i++) {
+            used[i] |= members[i];
+        }
+
+        const FLT ground = f / divisors[n_tones];
+        for (k = 0; k < n_tones; k++) {
+            if (fabs(ground * divisors[k] / tones[k] - 1.0) < same_tone_tol) {
+                break;
+            }
+        }
+        if (k < n_tones) {
+            continue;
+        }
+
+#ifdef DRAW_MARKERS
+        lingot_signal_add_group_markers(core, p_index, members, n_found_peaks);
+#endif
+
+        tones[n_tones++] = f;
+    }
 
+    return n_tones;
 }
 
 void lingot_signal_compute_noise_level(const FLT* spd,
                                        int N,
                                        int cbuffer_size,
+                                       FLT smoothing_bins,
                                        FLT* noise_level) {
 
-    // low pass IIR filter.
-    const FLT c = 0.1;
-    const FLT filter_a[] = { 1.0, c - 1.0 };
-    const FLT filter_b[] = { c };
-    static char initialized = 0;
-    static LingotFilter filter;
+    // first order low pass IIR filter, y[n] = c*x[n] + (1 - c)*y[n - 1].
+    const FLT c = (smoothing_bins > 1.0) ? 1.0 / smoothing_bins : 1.0;
+    FLT y = 0.0;
+    int i;
 
-    if (! initialized) {
-        initialized = 1;
-        lingot_filter_new(&filter, 1, 0, filter_a, filter_b);
+    if (cbuffer_size > N) {
+        cbuffer_size = N;
     }
 
-    lingot_filter_reset(&filter);
+    for (i = 0; i < cbuffer_size; i++) {
+        y = c * spd[i] + (1.0 - c) * y;
+    }
+
+    for (i = 0; i < N; i++) {
+        y = c * spd[i] + (1.0 - c) * y;
+        noise_level[i] = y;
+    }
+}
+
+//---------------------------------------------------------------------------
+
+FLT lingot_signal_phase_vocoder_frequency(const LingotComplex X0,
+                                          const LingotComplex X1,
+                                          FLT w0,
+                                          unsigned int hop) {
+
+    // phase advance between frames, as the argument of X1 * conj(X0).
+    const FLT re = X1[0] * X0[0] + X1[1] * X0[1];
+    const FLT im = X1[1] * X0[0] - X1[0] * X0[1];
+
+    if ((hop == 0) || ((re == 0.0) && (im == 0.0))) {
+        return w0;
+    }
 
-    lingot_filter_filter(&filter, cbuffer_size, spd, noise_level);
-    lingot_filter_filter(&filter, N, spd, noise_level);
+    // deviation from the expected advance, wrapped to (-pi, pi].
+    FLT dphi = atan2(im, re) - w0 * hop;
+    dphi -= 2.0 * M_PI * floor(0.5 + dphi / (2.0 * M_PI));
 
+    return w0 + dphi / hop;
 }
 
 //---------------------------------------------------------------------------
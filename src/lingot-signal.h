@@ -34,6 +34,9 @@
 #include "lingot-complex.h"
 #include "lingot-core.h"
 
+// maximum number of peaks taken from a spectrum.
+#define LINGOT_SIGNAL_MAX_PEAKS 64
+
 FLT lingot_signal_estimate_fundamental_frequency(const FLT* snr,
                                                  FLT freq,
                                                  const LingotComplex* fft,
@@ -49,11 +52,46 @@ FLT lingot_signal_estimate_fundamental_frequency(const FLT* snr,
                                                  LingotCore* core,
                                                  short* divisor);
 
+// searches up to max_tones fundamental frequencies in the same spectrum, from
+// groups of harmonics that do not share any peak, the best one first. The
+// harmonics of the given frequencies (of the previous pass) are favoured.
+// Returns the number of tones found, with the same meaning as the result and
+// the divisor of lingot_signal_estimate_fundamental_frequency().
+unsigned int lingot_signal_estimate_fundamental_frequencies(const FLT* snr,
+                                                            const FLT* freqs,
+                                                            unsigned int n_freqs,
+                                                            const LingotComplex* fft,
+                                                            unsigned int N,
+                                                            unsigned int n_peaks,
+                                                            unsigned int lowest_index,
+                                                            unsigned int highest_index,
+                                                            unsigned short peak_half_width,
+                                                            FLT delta_f_fft,
+                                                            FLT min_snr,
+                                                            FLT min_q,
+                                                            FLT min_freq,
+                                                            LingotCore* core,
+                                                            unsigned int max_tones,
+                                                            FLT* tones,
+                                                            short* divisors);
+
+// smoothed spectrum, from a low pass filter whose time constant is the given
+// number of bins, that is warmed up on the first cbuffer_size bins.
 void lingot_signal_compute_noise_level(const FLT* spd,
                                        int N,
                                        int cbuffer_size,
+                                       FLT smoothing_bins,
                                        FLT* noise_level);
 
+// refines the frequency w0 (rads per sample) from the phase advance of the
+// same DFT bin between two frames separated by hop samples, X0 being the
+// earlier one. The estimation is unambiguous as long as the error in w0 is
+// below pi/hop. The result is w0 if the phase advance can't be measured.
+FLT lingot_signal_phase_vocoder_frequency(const LingotComplex X0,
+                                          const LingotComplex X1,
+                                          FLT w0,
+                                          unsigned int hop);
+
 // generates a Hamming window of N samples
 void lingot_signal_window(int N,
                           FLT* out,
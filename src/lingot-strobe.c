@@ -0,0 +1,179 @@
+/*
+ * lingot, a musical instrument tuner.
+ *
+ * Copyright (C) 2004-2019  Iban Cereijo.
+ * Copyright (C) 2004-2008  Jairo Chapela.
+
+ *
+ * This file is part of lingot.
+ *
+ * lingot is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * lingot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with lingot; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "lingot-strobe.h"
+
+// time constant of each of the two low-pass stages. It must reject the
+// images at twice the harmonic frequencies and the neighbour harmonics, while
+// following the drift of a detuned note.
+static const FLT lingot_strobe_time_constant = 0.02; // seconds
+
+// the harmonics must stay below this fraction of the sample rate, where the
+// decimated signal is still free of aliasing.
+static const FLT lingot_strobe_max_relative_frequency = 0.45;
+
+// publishes the phases of the filtered products.
+static void lingot_strobe_publish(LingotStrobe* strobe) {
+
+    unsigned int h;
+    LingotStrobeReadout* const readout = &strobe->readout;
+    const unsigned int sequence = strobe->sequence;
+
+    __atomic_store_n(&strobe->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    __atomic_store(&readout->frequency, &strobe->frequency, __ATOMIC_RELAXED);
+    __atomic_store_n(&readout->n_harmonics, strobe->n_harmonics,
+                     __ATOMIC_RELAXED);
+    for (h = 0; h < strobe->n_harmonics; h++) {
+        const FLT* const z = strobe->stage2[h];
+        FLT phase = atan2(z[1], z[0]);
+        FLT magnitude = 2.0 * sqrt(z[0] * z[0] + z[1] * z[1]);
+        __atomic_store(&readout->phase[h], &phase, __ATOMIC_RELAXED);
+        __atomic_store(&readout->magnitude[h], &magnitude, __ATOMIC_RELAXED);
+    }
+
+    __atomic_store_n(&strobe->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+void lingot_strobe_new(LingotStrobe* strobe, unsigned int n_harmonics,
+                       FLT sample_rate) {
+    memset(strobe, 0, sizeof(LingotStrobe));
+    lingot_strobe_configure(strobe, n_harmonics, sample_rate);
+}
+
+void lingot_strobe_configure(LingotStrobe* strobe, unsigned int n_harmonics,
+                             FLT sample_rate) {
+    strobe->max_harmonics = (n_harmonics < LINGOT_STROBE_MAX_HARMONICS) ?
+                n_harmonics : LINGOT_STROBE_MAX_HARMONICS;
+    strobe->sample_rate = sample_rate;
+    strobe->smoothing = 1.0
+            - exp(-1.0 / (lingot_strobe_time_constant * sample_rate));
+    lingot_strobe_set_frequency(strobe, 0.0);
+}
+
+void lingot_strobe_set_frequency(LingotStrobe* strobe, FLT frequency) {
+
+    unsigned int h;
+
+    strobe->frequency = (frequency > 0.0) ? frequency : 0.0;
+    strobe->n_harmonics = 0;
+    if (strobe->frequency > 0.0) {
+        while ((strobe->n_harmonics < strobe->max_harmonics)
+               && ((strobe->n_harmonics + 1) * strobe->frequency
+                   < lingot_strobe_max_relative_frequency * strobe->sample_rate)) {
+            strobe->n_harmonics++;
+        }
+    }
+
+    for (h = 0; h < LINGOT_STROBE_MAX_HARMONICS; h++) {
+        const FLT w = 2.0 * M_PI * (h + 1) * strobe->frequency
+                / strobe->sample_rate;
+        strobe->rotation[h][0] = cos(w);
+        strobe->rotation[h][1] = -sin(w);
+        strobe->oscillator[h][0] = 1.0;
+        strobe->oscillator[h][1] = 0.0;
+        strobe->stage1[h][0] = strobe->stage1[h][1] = 0.0;
+        strobe->stage2[h][0] = strobe->stage2[h][1] = 0.0;
+    }
+
+    lingot_strobe_publish(strobe);
+}
+
+void lingot_strobe_process(LingotStrobe* strobe, const FLT* samples,
+                           unsigned int n) {
+
+    unsigned int h, i;
+    const FLT a = strobe->smoothing;
+
+    if (strobe->n_harmonics == 0) {
+        return;
+    }
+
+    for (h = 0; h < strobe->n_harmonics; h++) {
+
+        const FLT rr = strobe->rotation[h][0];
+        const FLT ri = strobe->rotation[h][1];
+        FLT osc_r = strobe->oscillator[h][0];
+        FLT osc_i = strobe->oscillator[h][1];
+        FLT z1_r = strobe->stage1[h][0];
+        FLT z1_i = strobe->stage1[h][1];
+        FLT z2_r = strobe->stage2[h][0];
+        FLT z2_i = strobe->stage2[h][1];
+
+        for (i = 0; i < n; i++) {
+            z1_r += a * (samples[i] * osc_r - z1_r);
+            z1_i += a * (samples[i] * osc_i - z1_i);
+            z2_r += a * (z1_r - z2_r);
+            z2_i += a * (z1_i - z2_i);
+
+            const FLT aux = osc_r * rr - osc_i * ri;
+            osc_i = osc_r * ri + osc_i * rr;
+            osc_r = aux;
+        }
+
+        // keeps the oscillator in the unit circle, the error after a block
+        // is small enough for a first order correction.
+        const FLT gain = 1.5 - 0.5 * (osc_r * osc_r + osc_i * osc_i);
+        strobe->oscillator[h][0] = osc_r * gain;
+        strobe->oscillator[h][1] = osc_i * gain;
+        strobe->stage1[h][0] = z1_r;
+        strobe->stage1[h][1] = z1_i;
+        strobe->stage2[h][0] = z2_r;
+        strobe->stage2[h][1] = z2_i;
+    }
+
+    lingot_strobe_publish(strobe);
+}
+
+void lingot_strobe_read(const LingotStrobe* strobe,
+                        LingotStrobeReadout* readout) {
+
+    unsigned int h, sequence;
+    const LingotStrobeReadout* const published = &strobe->readout;
+
+    do {
+        sequence = __atomic_load_n(&strobe->sequence, __ATOMIC_ACQUIRE);
+
+        __atomic_load(&published->frequency, &readout->frequency,
+                      __ATOMIC_RELAXED);
+        readout->n_harmonics = __atomic_load_n(&published->n_harmonics,
+                                               __ATOMIC_RELAXED);
+        if (readout->n_harmonics > LINGOT_STROBE_MAX_HARMONICS) {
+            readout->n_harmonics = LINGOT_STROBE_MAX_HARMONICS;
+        }
+        for (h = 0; h < readout->n_harmonics; h++) {
+            __atomic_load(&published->phase[h], &readout->phase[h],
+                          __ATOMIC_RELAXED);
+            __atomic_load(&published->magnitude[h], &readout->magnitude[h],
+                          __ATOMIC_RELAXED);
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((sequence & 1)
+             || (sequence != __atomic_load_n(&strobe->sequence, __ATOMIC_RELAXED)));
+}
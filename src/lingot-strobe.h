@@ -0,0 +1,95 @@
+/*
+ * lingot, a musical instrument tuner.
+ *
+ * Copyright (C) 2004-2019  Iban Cereijo.
+ * Copyright (C) 2004-2008  Jairo Chapela.
+
+ *
+ * This file is part of lingot.
+ *
+ * lingot is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * lingot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with lingot; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LINGOT_STROBE_H
+#define LINGOT_STROBE_H
+
+/*
+ Strobe stage.
+
+ The decimated signal is mixed with quadrature oscillators at the reference
+ note frequency and its first harmonics, and each product is low-pass
+ filtered. The phase of each filtered product is the phase of the harmonic
+ relative to its reference, which stays still when the note is in tune and
+ drifts at the detuning rate otherwise, like the bands of a strobe tuner.
+ The oscillators are computed by recurrence, so the stage only costs a few
+ multiply-adds per sample and harmonic, and it runs on every audio block.
+ */
+
+#include "lingot-defs.h"
+#include "lingot-complex.h"
+
+#define LINGOT_STROBE_MAX_HARMONICS 8
+
+// latest phases of the strobe stage, as read by the GUI.
+typedef struct {
+    FLT frequency; // reference frequency in Hz, 0 if there is no reference.
+    unsigned int n_harmonics; // harmonics below the Nyquist frequency.
+    FLT phase[LINGOT_STROBE_MAX_HARMONICS]; // relative phase, in rads.
+    FLT magnitude[LINGOT_STROBE_MAX_HARMONICS]; // amplitude of each harmonic.
+} LingotStrobeReadout;
+
+typedef struct {
+
+    FLT sample_rate; // of the processed signal.
+    unsigned int max_harmonics; // harmonics requested.
+    FLT smoothing; // coefficient of the low-pass filters.
+
+    unsigned int n_harmonics; // harmonics in use for the current reference.
+    FLT frequency; // reference frequency.
+
+    LingotComplex rotation[LINGOT_STROBE_MAX_HARMONICS]; // oscillator steps.
+    LingotComplex oscillator[LINGOT_STROBE_MAX_HARMONICS]; // e^{-j h w n}
+    LingotComplex stage1[LINGOT_STROBE_MAX_HARMONICS]; // low-pass filter states.
+    LingotComplex stage2[LINGOT_STROBE_MAX_HARMONICS];
+
+    // readout published after each block, guarded by a sequence counter that
+    // is odd while it is being written.
+    unsigned int sequence;
+    LingotStrobeReadout readout;
+
+} LingotStrobe;
+
+// prepares a stage with up to n_harmonics harmonics, for a signal sampled at
+// the given rate. There is no reference frequency until one is set.
+void lingot_strobe_new(LingotStrobe*, unsigned int n_harmonics, FLT sample_rate);
+
+// changes the number of harmonics and the sample rate of a stage that may be
+// being read, removing the reference frequency.
+void lingot_strobe_configure(LingotStrobe*, unsigned int n_harmonics, FLT sample_rate);
+
+// sets the reference frequency, in Hz, restarting the oscillators. A
+// frequency of 0 stops the stage.
+void lingot_strobe_set_frequency(LingotStrobe*, FLT frequency);
+
+// mixes a block of samples and publishes the resulting phases. It must not
+// run at the same time as lingot_strobe_set_frequency() nor
+// lingot_strobe_configure().
+void lingot_strobe_process(LingotStrobe*, const FLT* samples, unsigned int n);
+
+// gets the latest published phases. It can be called from any thread while
+// another one is processing.
+void lingot_strobe_read(const LingotStrobe*, LingotStrobeReadout*);
+
+#endif /*LINGOT_STROBE_H*/
@@ -0,0 +1,320 @@
+/*
+ * lingot, a musical instrument tuner.
+ *
+ * Copyright (C) 2004-2019  Iban Cereijo.
+ * Copyright (C) 2004-2008  Jairo Chapela.
+
+ *
+ * This file is part of lingot.
+ *
+ * lingot is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * lingot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with lingot; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "lingot-telemetry.h"
+
+// the ring holds about one second of results at the highest calculation rate
+static const unsigned int telemetry_ring_size = 1 << 14; // bytes
+
+// the server also wakes up periodically, in order to notice the stop request
+static const int telemetry_poll_timeout = 100; // ms
+
+static void lingot_telemetry_set_nonblocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+static void lingot_telemetry_disconnect(LingotTelemetryClient* client) {
+    close(client->fd);
+    client->fd = -1;
+}
+
+static void lingot_telemetry_accept(LingotTelemetry* telemetry) {
+    unsigned int i;
+    int fd;
+
+    while ((fd = accept(telemetry->listen_fd, NULL, NULL)) >= 0) {
+        for (i = 0; i < LINGOT_TELEMETRY_MAX_CLIENTS; i++) {
+            if (telemetry->clients[i].fd < 0) {
+                break;
+            }
+        }
+
+        if (i == LINGOT_TELEMETRY_MAX_CLIENTS) {
+            close(fd); // no room for more clients
+            continue;
+        }
+
+        LingotTelemetryClient* client = &telemetry->clients[i];
+        lingot_telemetry_set_nonblocking(fd);
+        client->fd = fd;
+        client->queue_head = 0;
+        client->queue_count = 0;
+        client->sent_bytes = 0;
+        client->dropped = 0;
+    }
+}
+
+// queues a record for every client, dropping the oldest one of the clients
+// that are too far behind.
+static void lingot_telemetry_enqueue(LingotTelemetry* telemetry,
+                                     const LingotTelemetryRecord* record) {
+    unsigned int i;
+
+    for (i = 0; i < LINGOT_TELEMETRY_MAX_CLIENTS; i++) {
+        LingotTelemetryClient* client = &telemetry->clients[i];
+        if (client->fd < 0) {
+            continue;
+        }
+
+        if (client->queue_count == LINGOT_TELEMETRY_CLIENT_QUEUE_SIZE) {
+            const unsigned int next = (client->queue_head + 1)
+                    % LINGOT_TELEMETRY_CLIENT_QUEUE_SIZE;
+            // a record partially sent must be completed, so the following
+            // one is dropped instead.
+            if (client->sent_bytes) {
+                client->queue[next] = client->queue[client->queue_head];
+            }
+            client->queue_head = next;
+            client->queue_count--;
+            client->dropped++;
+            __atomic_store_n(&telemetry->dropped, telemetry->dropped + 1,
+                             __ATOMIC_RELAXED);
+        }
+
+        const unsigned int tail = (client->queue_head + client->queue_count)
+                % LINGOT_TELEMETRY_CLIENT_QUEUE_SIZE;
+        client->queue[tail] = *record;
+        client->queue_count++;
+    }
+}
+
+// sends the queued records of a client in as few calls as possible.
+static void lingot_telemetry_flush(LingotTelemetryClient* client) {
+
+    while (client->queue_count) {
+        // records until the end of the circular queue, sent at once
+        unsigned int n = LINGOT_TELEMETRY_CLIENT_QUEUE_SIZE - client->queue_head;
+        if (n > client->queue_count) {
+            n = client->queue_count;
+        }
+
+        const char* data = (const char*) &client->queue[client->queue_head]
+                + client->sent_bytes;
+        const size_t length = n * sizeof(LingotTelemetryRecord) - client->sent_bytes;
+        const ssize_t sent = send(client->fd, data, length,
+                                  MSG_DONTWAIT | MSG_NOSIGNAL);
+
+        if (sent < 0) {
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) {
+                lingot_telemetry_disconnect(client);
+            }
+            return;
+        }
+
+        const size_t total = client->sent_bytes + (size_t) sent;
+        const unsigned int records = total / sizeof(LingotTelemetryRecord);
+        client->sent_bytes = total % sizeof(LingotTelemetryRecord);
+        client->queue_head = (client->queue_head + records)
+                % LINGOT_TELEMETRY_CLIENT_QUEUE_SIZE;
+        client->queue_count -= records;
+
+        if ((size_t) sent < length) {
+            return; // the socket buffer is full
+        }
+    }
+}
+
+static void* lingot_telemetry_run_server_thread(void* arg) {
+    LingotTelemetry* telemetry = arg;
+    struct pollfd fds[2 + LINGOT_TELEMETRY_MAX_CLIENTS];
+    int client_index[2 + LINGOT_TELEMETRY_MAX_CLIENTS];
+    LingotTelemetryRecord record;
+    unsigned int type;
+    char wake_buffer[64];
+    unsigned int i, n;
+
+    while (__atomic_load_n(&telemetry->running, __ATOMIC_ACQUIRE)) {
+
+        fds[0].fd = telemetry->listen_fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = telemetry->wake_pipe[0];
+        fds[1].events = POLLIN;
+        n = 2;
+        for (i = 0; i < LINGOT_TELEMETRY_MAX_CLIENTS; i++) {
+            if (telemetry->clients[i].fd >= 0) {
+                fds[n].fd = telemetry->clients[i].fd;
+                fds[n].events = telemetry->clients[i].queue_count ?
+                            POLLIN | POLLOUT : POLLIN;
+                client_index[n] = i;
+                n++;
+            }
+        }
+
+        if (poll(fds, n, telemetry_poll_timeout) < 0) {
+            continue;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            lingot_telemetry_accept(telemetry);
+        }
+
+        if (fds[1].revents & POLLIN) {
+            while (read(telemetry->wake_pipe[0], wake_buffer,
+                        sizeof(wake_buffer)) > 0) {
+            }
+        }
+
+        // the clients are not expected to send anything, so readability
+        // means that they have hung up.
+        for (i = 2; i < n; i++) {
+            LingotTelemetryClient* client = &telemetry->clients[client_index[i]];
+            if (fds[i].revents & (POLLIN | POLLERR | POLLHUP)) {
+                const ssize_t r = recv(client->fd, wake_buffer,
+                                       sizeof(wake_buffer), MSG_DONTWAIT);
+                if ((r == 0) || ((r < 0) && (errno != EAGAIN)
+                                 && (errno != EWOULDBLOCK) && (errno != EINTR))) {
+                    lingot_telemetry_disconnect(client);
+                }
+            }
+        }
+
+        while (lingot_ring_read(&telemetry->ring, &type, &record,
+                                sizeof(record)) >= 0) {
+            lingot_telemetry_enqueue(telemetry, &record);
+        }
+
+        for (i = 0; i < LINGOT_TELEMETRY_MAX_CLIENTS; i++) {
+            if (telemetry->clients[i].fd >= 0) {
+                lingot_telemetry_flush(&telemetry->clients[i]);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+LingotTelemetry* lingot_telemetry_new(const char* path) {
+    LingotTelemetry* telemetry;
+    struct sockaddr_un address;
+    struct stat st;
+    unsigned int i;
+
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        return NULL;
+    }
+
+    telemetry = malloc(sizeof(LingotTelemetry));
+    if (!telemetry) {
+        return NULL;
+    }
+
+    snprintf(telemetry->path, sizeof(telemetry->path), "%s", path);
+    telemetry->dropped = 0;
+    telemetry->running = 0;
+    telemetry->wake_pipe[0] = -1;
+    telemetry->wake_pipe[1] = -1;
+    for (i = 0; i < LINGOT_TELEMETRY_MAX_CLIENTS; i++) {
+        telemetry->clients[i].fd = -1;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path, strlen(path));
+
+    // a socket left by a previous run is replaced, but no other file.
+    if (!stat(path, &st) && S_ISSOCK(st.st_mode)) {
+        unlink(path);
+    }
+
+    telemetry->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if ((telemetry->listen_fd < 0)
+            || bind(telemetry->listen_fd, (struct sockaddr*) &address,
+                    sizeof(address))
+            || listen(telemetry->listen_fd, LINGOT_TELEMETRY_MAX_CLIENTS)
+            || pipe(telemetry->wake_pipe)
+            || !lingot_ring_new(&telemetry->ring, telemetry_ring_size)) {
+        if (telemetry->listen_fd >= 0) {
+            close(telemetry->listen_fd);
+        }
+        if (telemetry->wake_pipe[0] >= 0) {
+            close(telemetry->wake_pipe[0]);
+            close(telemetry->wake_pipe[1]);
+        }
+        free(telemetry);
+        return NULL;
+    }
+
+    lingot_telemetry_set_nonblocking(telemetry->listen_fd);
+    lingot_telemetry_set_nonblocking(telemetry->wake_pipe[0]);
+    lingot_telemetry_set_nonblocking(telemetry->wake_pipe[1]);
+
+    telemetry->running = 1;
+    if (pthread_create(&telemetry->server_thread, NULL,
+                       lingot_telemetry_run_server_thread, telemetry)) {
+        telemetry->running = 0;
+        lingot_telemetry_destroy(telemetry);
+        return NULL;
+    }
+
+    return telemetry;
+}
+
+void lingot_telemetry_destroy(LingotTelemetry* telemetry) {
+    unsigned int i;
+
+    if (__atomic_exchange_n(&telemetry->running, 0, __ATOMIC_ACQ_REL)) {
+        // otherwise the server notices the request at its next timeout
+        const ssize_t written = write(telemetry->wake_pipe[1], "", 1);
+        (void) written;
+        pthread_join(telemetry->server_thread, NULL);
+    }
+
+    for (i = 0; i < LINGOT_TELEMETRY_MAX_CLIENTS; i++) {
+        if (telemetry->clients[i].fd >= 0) {
+            lingot_telemetry_disconnect(&telemetry->clients[i]);
+        }
+    }
+
+    close(telemetry->listen_fd);
+    close(telemetry->wake_pipe[0]);
+    close(telemetry->wake_pipe[1]);
+    unlink(telemetry->path);
+    lingot_ring_destroy(&telemetry->ring);
+    free(telemetry);
+}
+
+void lingot_telemetry_push(LingotTelemetry* telemetry,
+                           const LingotTelemetryRecord* record) {
+    lingot_ring_write(&telemetry->ring, 0, record, sizeof(*record));
+
+    // the pipe is non blocking: if it is full, the server is already awake.
+    const ssize_t written = write(telemetry->wake_pipe[1], "", 1);
+    (void) written;
+}
+
+unsigned long lingot_telemetry_get_dropped(const LingotTelemetry* telemetry) {
+    return lingot_ring_get_dropped(&telemetry->ring)
+            + __atomic_load_n(&telemetry->dropped, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,99 @@
+/*
+ * lingot, a musical instrument tuner.
+ *
+ * Copyright (C) 2004-2019  Iban Cereijo.
+ * Copyright (C) 2004-2008  Jairo Chapela.
+
+ *
+ * This file is part of lingot.
+ *
+ * lingot is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * lingot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with lingot; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LINGOT_TELEMETRY_H
+#define LINGOT_TELEMETRY_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "lingot-defs.h"
+#include "lingot-ring.h"
+
+/*
+ * Local stream of the tuner results for other programs. A server thread
+ * listens on a UNIX domain stream socket, and sends a LingotTelemetryRecord
+ * per analysis pass to every connected client, in the host byte order.
+ *
+ * The analysis thread only pushes the records into a lock-free ring. The
+ * records are queued for each client, and sent in batches when a client
+ * falls behind; if its queue gets full, the oldest records are dropped, so
+ * that a slow client never delays the analysis nor the other clients.
+ */
+
+#define LINGOT_TELEMETRY_MAX_CLIENTS 8
+#define LINGOT_TELEMETRY_CLIENT_QUEUE_SIZE 1024 // records
+
+// flags of the records.
+#define LINGOT_TELEMETRY_FLAG_PITCH 1 // a frequency has been found
+#define LINGOT_TELEMETRY_FLAG_LOCKED 2 // the frequency locker is locked
+#define LINGOT_TELEMETRY_FLAG_SIGNAL 4 // the silence gate is open
+
+typedef struct {
+    uint64_t timestamp; // ns, CLOCK_MONOTONIC
+    double frequency; // Hz, 0 if no pitch
+    uint32_t sequence; // analysis pass number
+    int32_t note_index; // closest note of the scale, 0 is the base note
+    float cents; // deviation from the closest note
+    float snr; // dB above the noise level at the frequency
+    uint32_t flags;
+    uint32_t reserved;
+} LingotTelemetryRecord;
+
+typedef struct {
+    int fd; // -1 if the slot is free
+    LingotTelemetryRecord queue[LINGOT_TELEMETRY_CLIENT_QUEUE_SIZE];
+    unsigned int queue_head; // oldest record
+    unsigned int queue_count;
+    unsigned int sent_bytes; // part of the oldest record already sent
+    unsigned long dropped;
+} LingotTelemetryClient;
+
+typedef struct {
+    LingotRing ring; // written by the analysis thread
+    int wake_pipe[2]; // wakes up the server when records are pushed
+
+    int listen_fd;
+    char path[108];
+    LingotTelemetryClient clients[LINGOT_TELEMETRY_MAX_CLIENTS];
+
+    unsigned long dropped; // records dropped for any client
+
+    pthread_t server_thread;
+    int running;
+} LingotTelemetry;
+
+// starts serving at the given socket path. Returns NULL on failure.
+LingotTelemetry* lingot_telemetry_new(const char* path);
+
+// disconnects the clients and removes the socket.
+void lingot_telemetry_destroy(LingotTelemetry*);
+
+// sends a record, only from the analysis thread. It never blocks.
+void lingot_telemetry_push(LingotTelemetry*, const LingotTelemetryRecord*);
+
+// records dropped so far, for the ring or for any of the clients.
+unsigned long lingot_telemetry_get_dropped(const LingotTelemetry*);
+
+#endif // LINGOT_TELEMETRY_H
@@ -0,0 +1,282 @@
+/*
+ * lingot, a musical instrument tuner.
+ *
+ * Copyright (C) 2004-2019  Iban Cereijo.
+ * Copyright (C) 2004-2008  Jairo Chapela.
+
+ *
+ * This file is part of lingot.
+ *
+ * lingot is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * lingot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with lingot; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// CPU affinity is a GNU extension.
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <sched.h>
+#include <sys/resource.h>
+
+#include "lingot-defs.h"
+#include "lingot-thread.h"
+#include "lingot-i18n.h"
+#include "lingot-msg.h"
+
+void lingot_thread_settings_default(LingotThreadSettings* settings) {
+    settings->policy = LINGOT_THREAD_POLICY_DEFAULT;
+    settings->priority = 50;
+    sprintf(settings->affinity, "%s", "none");
+}
+
+int lingot_thread_settings_requested(const LingotThreadSettings* settings) {
+    return (settings->policy != LINGOT_THREAD_POLICY_DEFAULT)
+            || strcmp(settings->affinity, "none");
+}
+
+int lingot_thread_settings_equal(const LingotThreadSettings* settings1,
+                                 const LingotThreadSettings* settings2) {
+    return (settings1->policy == settings2->policy)
+            && ((settings1->policy == LINGOT_THREAD_POLICY_DEFAULT)
+                || (settings1->priority == settings2->priority))
+            && !strcmp(settings1->affinity, settings2->affinity);
+}
+
+int lingot_thread_parse_cpu_list(const char* list, unsigned char* cpus,
+                                 unsigned int n_cpus) {
+
+    int result = 0;
+    const char* p = list;
+    char* end;
+    unsigned int i;
+
+    memset(cpus, 0, n_cpus);
+
+    while (*p) {
+        while (isspace((unsigned char) *p)) {
+            p++;
+        }
+        if (!isdigit((unsigned char) *p)) {
+            return -1;
+        }
+        unsigned long first = strtoul(p, &end, 10);
+        unsigned long last = first;
+        p = end;
+        if (*p == '-') {
+            p++;
+            if (!isdigit((unsigned char) *p)) {
+                return -1;
+            }
+            last = strtoul(p, &end, 10);
+            p = end;
+        }
+        while (isspace((unsigned char) *p)) {
+            p++;
+        }
+        if ((last < first) || (last >= n_cpus) || ((*p != ',') && (*p != '\0'))) {
+            return -1;
+        }
+        if ((*p == ',') && (*++p == '\0')) {
+            return -1;
+        }
+        for (i = first; i <= last; i++) {
+            if (!cpus[i]) {
+                cpus[i] = 1;
+                result++;
+            }
+        }
+    }
+
+    return result ? result : -1;
+}
+
+static int lingot_thread_apply_policy(pthread_t thread,
+                                      const LingotThreadSettings* settings,
+                                      const char* name) {
+
+    char buff[1000];
+    const int policy = (settings->policy == LINGOT_THREAD_POLICY_RR) ?
+                SCHED_RR : SCHED_FIFO;
+    const int min = sched_get_priority_min(policy);
+    const int max = sched_get_priority_max(policy);
+    struct sched_param param;
+    struct rlimit limit;
+
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = settings->priority;
+    if (param.sched_priority < min) {
+        param.sched_priority = min;
+    } else if (param.sched_priority > max) {
+        param.sched_priority = max;
+    }
+
+    int error = pthread_setschedparam(thread, policy, &param);
+
+    // unprivileged processes may still use the priorities below their
+    // RLIMIT_RTPRIO.
+    if ((error == EPERM) && !getrlimit(RLIMIT_RTPRIO, &limit)
+            && (limit.rlim_cur != RLIM_INFINITY)
+            && ((int) limit.rlim_cur >= min)
+            && ((int) limit.rlim_cur < param.sched_priority)) {
+        param.sched_priority = (int) limit.rlim_cur;
+        error = pthread_setschedparam(thread, policy, &param);
+    }
+
+    if (error) {
+        snprintf(buff, sizeof(buff),
+                 _("The %s thread cannot use realtime scheduling (%s), it keeps the default policy"),
+                 name, strerror(error));
+        lingot_msg_add_warning(buff);
+        return -1;
+    }
+
+    if (param.sched_priority != settings->priority) {
+        snprintf(buff, sizeof(buff),
+                 _("The realtime priority of the %s thread has been limited to %d"),
+                 name, param.sched_priority);
+        lingot_msg_add_warning(buff);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int lingot_thread_apply_affinity(pthread_t thread,
+                                        const LingotThreadSettings* settings,
+                                        const char* name) {
+
+    char buff[1000];
+    unsigned char cpus[LINGOT_THREAD_MAX_CPUS];
+    cpu_set_t set;
+    unsigned int i;
+    int error;
+
+    if (lingot_thread_parse_cpu_list(settings->affinity, cpus,
+                                     CPU_SETSIZE < LINGOT_THREAD_MAX_CPUS ?
+                                         CPU_SETSIZE : LINGOT_THREAD_MAX_CPUS) < 0) {
+        snprintf(buff, sizeof(buff),
+                 _("Invalid CPU list '%s' for the %s thread"),
+                 settings->affinity, name);
+        lingot_msg_add_warning(buff);
+        return -1;
+    }
+
+    CPU_ZERO(&set);
+    for (i = 0; (i < CPU_SETSIZE) && (i < LINGOT_THREAD_MAX_CPUS); i++) {
+        if (cpus[i]) {
+            CPU_SET(i, &set);
+        }
+    }
+
+    error = pthread_setaffinity_np(thread, sizeof(set), &set);
+    if (error) {
+        snprintf(buff, sizeof(buff),
+                 _("The %s thread cannot be bound to the CPUs %s (%s)"),
+                 name, settings->affinity, strerror(error));
+        lingot_msg_add_warning(buff);
+        return -1;
+    }
+
+    return 0;
+}
+
+int lingot_thread_apply(pthread_t thread, const LingotThreadSettings* settings,
+                        const char* name) {
+
+    char buff[1000];
+    char description[200];
+    int result = 0;
+
+    if (!lingot_thread_settings_requested(settings)) {
+        return 0;
+    }
+
+    if (settings->policy != LINGOT_THREAD_POLICY_DEFAULT) {
+        if (lingot_thread_apply_policy(thread, settings, name)) {
+            result = -1;
+        }
+    }
+
+    if (strcmp(settings->affinity, "none")) {
+        if (lingot_thread_apply_affinity(thread, settings, name)) {
+            result = -1;
+        }
+    }
+
+    lingot_thread_describe(thread, description, sizeof(description));
+    snprintf(buff, sizeof(buff), _("The %s thread runs with %s"), name,
+             description);
+    lingot_msg_add_info(buff);
+
+    return result;
+}
+
+void lingot_thread_describe(pthread_t thread, char* description, size_t size) {
+
+    struct sched_param param;
+    cpu_set_t set;
+    int policy;
+    size_t length;
+    int first_range = 1;
+    int i;
+
+    if (pthread_getschedparam(thread, &policy, &param)) {
+        snprintf(description, size, "%s", _("unknown scheduling"));
+        return;
+    }
+
+    switch (policy) {
+    case SCHED_FIFO:
+        snprintf(description, size, "SCHED_FIFO %d", param.sched_priority);
+        break;
+    case SCHED_RR:
+        snprintf(description, size, "SCHED_RR %d", param.sched_priority);
+        break;
+    default:
+        snprintf(description, size, "SCHED_OTHER");
+        break;
+    }
+
+    if (pthread_getaffinity_np(thread, sizeof(set), &set)) {
+        return;
+    }
+
+    // the CPUs are listed as ranges.
+    length = strlen(description);
+    for (i = 0; (i < CPU_SETSIZE) && (length < size); i++) {
+        if (CPU_ISSET(i, &set)) {
+            int last = i;
+            while ((last + 1 < CPU_SETSIZE) && CPU_ISSET(last + 1, &set)) {
+                last++;
+            }
+            const char* separator = first_range ? _(", CPUs ") : ",";
+            first_range = 0;
+            if (last == i) {
+                snprintf(description + length, size - length, "%s%d",
+                         separator, i);
+            } else {
+                snprintf(description + length, size - length, "%s%d-%d",
+                         separator, i, last);
+            }
+            length = strlen(description);
+            i = last;
+        }
+    }
+}
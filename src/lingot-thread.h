@@ -0,0 +1,78 @@
+/*
+ * lingot, a musical instrument tuner.
+ *
+ * Copyright (C) 2004-2019  Iban Cereijo.
+ * Copyright (C) 2004-2008  Jairo Chapela.
+
+ *
+ * This file is part of lingot.
+ *
+ * lingot is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * lingot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with lingot; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LINGOT_THREAD_H
+#define LINGOT_THREAD_H
+
+/*
+ Scheduling of the capture and analysis threads.
+
+ The threads are created with the default attributes and their policy,
+ priority and CPU affinity are changed right after, so a process without
+ realtime privileges still runs, with the best scheduling it is allowed to
+ use, and reports the one it actually got.
+ */
+
+#include <stddef.h>
+#include <pthread.h>
+
+#define LINGOT_THREAD_MAX_CPUS 1024
+
+typedef enum lingot_thread_policy_t {
+    LINGOT_THREAD_POLICY_DEFAULT = 0, // inherited, usually SCHED_OTHER
+    LINGOT_THREAD_POLICY_FIFO = 1, // SCHED_FIFO
+    LINGOT_THREAD_POLICY_RR = 2, // SCHED_RR
+} lingot_thread_policy_t;
+
+typedef struct {
+    int policy; // lingot_thread_policy_t
+    int priority; // realtime priority, only used with FIFO and RR.
+    char affinity[64]; // CPU list such as "0,2-3", "none" leaves it unchanged.
+} LingotThreadSettings;
+
+void lingot_thread_settings_default(LingotThreadSettings*);
+
+// tells whether the settings change anything on the thread.
+int lingot_thread_settings_requested(const LingotThreadSettings*);
+
+// tells whether both settings give the same scheduling.
+int lingot_thread_settings_equal(const LingotThreadSettings*,
+                                 const LingotThreadSettings*);
+
+// parses a CPU list such as "0,2-3" into a flag per CPU, it returns the
+// number of CPUs selected, or -1 if the list is malformed.
+int lingot_thread_parse_cpu_list(const char* list, unsigned char* cpus,
+                                 unsigned int n_cpus);
+
+// applies the settings to a running thread. If the realtime policy is not
+// allowed it falls back to the highest priority permitted by RLIMIT_RTPRIO,
+// and then to the default policy. The name identifies the thread in the
+// messages. It returns 0 if the settings were fully applied.
+int lingot_thread_apply(pthread_t thread, const LingotThreadSettings*,
+                        const char* name);
+
+// writes the policy, priority and CPUs the thread is actually running with.
+void lingot_thread_describe(pthread_t thread, char* description, size_t size);
+
+#endif
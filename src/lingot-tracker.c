@@ -0,0 +1,241 @@
+/*
+ * lingot, a musical instrument tuner.
+ *
+ * Copyright (C) 2004-2019  Iban Cereijo.
+ * Copyright (C) 2004-2008  Jairo Chapela.
+
+ *
+ * This file is part of lingot.
+ *
+ * lingot is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * lingot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with lingot; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lingot-tracker.h"
+
+// maximum relative frequency deviation that the narrowband stream can follow
+// between two consecutive passes (about half a semitone).
+static const FLT lingot_tracker_max_deviation = 0.03;
+
+// minimum number of decimated blocks required for a reliable estimation.
+static const unsigned int lingot_tracker_min_blocks = 16;
+
+// below this coherence, we consider that the lock has been lost.
+static const FLT lingot_tracker_min_coherence = 0.7;
+
+// the narrowband stream must be wide enough to contain the expected
+// deviation, i.e. |dw| * D < pi / 2, with enough decimated samples.
+static unsigned int lingot_tracker_decimation(FLT w, unsigned int n) {
+    unsigned int decimation = (unsigned int) floor(
+                0.5 * M_PI / (lingot_tracker_max_deviation * w));
+    if (decimation > n / lingot_tracker_min_blocks) {
+        decimation = n / lingot_tracker_min_blocks;
+    }
+    return (decimation < 1) ? 1 : decimation;
+}
+
+// narrowband samples kept for signals of n samples. The decimation decreases
+// with the frequency, so the smallest one is the one at pi.
+static unsigned int lingot_tracker_ring_size(unsigned int n) {
+    return n / lingot_tracker_decimation(M_PI, n) + 1;
+}
+
+void lingot_tracker_new(LingotTracker* tracker, unsigned int n, LingotArena* arena) {
+
+    tracker->n = n;
+    tracker->z_size = lingot_tracker_ring_size(n);
+    tracker->in_arena = (arena != NULL);
+    if (arena) {
+        tracker->z = lingot_arena_alloc(arena, tracker->z_size * sizeof(LingotComplex));
+    } else {
+        tracker->z = malloc(tracker->z_size * sizeof(LingotComplex));
+        memset(tracker->z, 0, tracker->z_size * sizeof(LingotComplex));
+    }
+
+    lingot_tracker_reset(tracker);
+}
+
+void lingot_tracker_destroy(LingotTracker* tracker) {
+    if (!tracker->in_arena) {
+        free(tracker->z);
+    }
+    tracker->z = NULL;
+}
+
+size_t lingot_tracker_arena_size(unsigned int n) {
+    return lingot_arena_block_size(lingot_tracker_ring_size(n) * sizeof(LingotComplex));
+}
+
+void lingot_tracker_reset(LingotTracker* tracker) {
+    tracker->active = 0;
+    tracker->w = 0.0;
+    tracker->coherence = 0.0;
+    tracker->decimation = 1;
+    tracker->w0 = 0.0;
+    tracker->blocks = 0;
+}
+
+// heterodynes and decimates new samples. Each completed block gives its zero
+// and first order moments, and every block boundary a triangular (CIC-2)
+// weighted narrowband sample.
+static void lingot_tracker_feed(LingotTracker* tracker, const FLT* in,
+                                unsigned int n_samples) {
+
+    const unsigned int D = tracker->decimation;
+    const FLT _1_D = 1.0 / D;
+    LingotComplex aux;
+    unsigned int i;
+
+    for (i = 0; i < n_samples; i++) {
+        const FLT yr = in[i] * tracker->osc[0];
+        const FLT yi = in[i] * tracker->osc[1];
+        const FLT weight = tracker->block_samples * _1_D;
+        tracker->S0[0] += yr;
+        tracker->S0[1] += yi;
+        tracker->S1[0] += weight * yr;
+        tracker->S1[1] += weight * yi;
+        lingot_complex_mul(tracker->osc, tracker->rotation, aux);
+        tracker->osc[0] = aux[0];
+        tracker->osc[1] = aux[1];
+
+        if (++tracker->block_samples < D) {
+            continue;
+        }
+
+        // keeps the oscillator in the unit circle.
+        const FLT norm = 1.0 / sqrt(tracker->osc[0] * tracker->osc[0]
+                                    + tracker->osc[1] * tracker->osc[1]);
+        tracker->osc[0] *= norm;
+        tracker->osc[1] *= norm;
+
+        if (tracker->blocks > 0) {
+            FLT* const z = tracker->z[tracker->z_next];
+            z[0] = tracker->S1_prev[0] + tracker->S0[0] - tracker->S1[0];
+            z[1] = tracker->S1_prev[1] + tracker->S0[1] - tracker->S1[1];
+            if (++tracker->z_next == tracker->z_size) {
+                tracker->z_next = 0;
+            }
+        }
+
+        tracker->S1_prev[0] = tracker->S1[0];
+        tracker->S1_prev[1] = tracker->S1[1];
+        tracker->S0[0] = tracker->S0[1] = 0.0;
+        tracker->S1[0] = tracker->S1[1] = 0.0;
+        tracker->block_samples = 0;
+        tracker->blocks++;
+    }
+}
+
+void lingot_tracker_engage(LingotTracker* tracker, FLT w, const FLT* in,
+                           unsigned int n_samples) {
+
+    const unsigned int n = tracker->n;
+
+    // the stream heterodyned at the current frequency still contains the
+    // new one with a good margin.
+    if (tracker->active && (n_samples <= n)
+            && (fabs(w - tracker->w0) * tracker->decimation < 0.25 * M_PI)) {
+        lingot_tracker_feed(tracker, &in[n - n_samples], n_samples);
+        return;
+    }
+
+    lingot_tracker_reset(tracker);
+
+    if ((w <= 0.0) || (w >= M_PI) || (n < 4 * lingot_tracker_min_blocks)) {
+        return;
+    }
+
+    tracker->decimation = lingot_tracker_decimation(w, n);
+    tracker->w = w;
+    tracker->w0 = w;
+    tracker->rotation[0] = cos(w);
+    tracker->rotation[1] = -sin(w);
+    tracker->osc[0] = 1.0;
+    tracker->osc[1] = 0.0;
+    tracker->S0[0] = tracker->S0[1] = 0.0;
+    tracker->S1[0] = tracker->S1[1] = 0.0;
+    tracker->S1_prev[0] = tracker->S1_prev[1] = 0.0;
+    tracker->block_samples = 0;
+    tracker->z_next = 0;
+    tracker->active = 1;
+
+    lingot_tracker_feed(tracker, in, n);
+}
+
+int lingot_tracker_track(LingotTracker* tracker, const FLT* in, unsigned int n_samples) {
+
+    if (!tracker->active) {
+        return 0;
+    }
+
+    lingot_tracker_feed(tracker, in, n_samples);
+
+    const unsigned int D = tracker->decimation;
+
+    // blocks within the last n samples of signal, each one but the first
+    // ending with a narrowband sample.
+    unsigned int count = tracker->n / D;
+    if (count > tracker->blocks) {
+        count = tracker->blocks;
+    }
+    if (count < 4) {
+        lingot_tracker_reset(tracker);
+        return 0;
+    }
+    count--;
+
+    LingotComplex R = { 0.0, 0.0 }; // lag-one autocorrelation.
+    FLT P_prev = 0.0;
+    FLT P_next = 0.0;
+    unsigned int i;
+    unsigned int index = (tracker->z_next + tracker->z_size - count) % tracker->z_size;
+    const FLT* z_prev = tracker->z[index];
+
+    for (i = 1; i < count; i++) {
+        if (++index == tracker->z_size) {
+            index = 0;
+        }
+        const FLT* const z = tracker->z[index];
+
+        // R += z * conj(z_prev)
+        R[0] += z[0] * z_prev[0] + z[1] * z_prev[1];
+        R[1] += z[1] * z_prev[0] - z[0] * z_prev[1];
+        P_prev += z_prev[0] * z_prev[0] + z_prev[1] * z_prev[1];
+        P_next += z[0] * z[0] + z[1] * z[1];
+        z_prev = z;
+    }
+
+    if ((P_prev <= 0.0) || (P_next <= 0.0)) {
+        lingot_tracker_reset(tracker);
+        return 0;
+    }
+
+    const FLT coherence = sqrt((R[0] * R[0] + R[1] * R[1]) / (P_prev * P_next));
+    const FLT dw = atan2(R[1], R[0]) / D;
+
+    if ((coherence < lingot_tracker_min_coherence)
+            || (fabs(dw) * D > 0.5 * M_PI)) {
+        lingot_tracker_reset(tracker);
+        return 0;
+    }
+
+    tracker->w = tracker->w0 + dw;
+    tracker->coherence = coherence;
+
+    return 1;
+}
@@ -0,0 +1,95 @@
+/*
+ * lingot, a musical instrument tuner.
+ *
+ * Copyright (C) 2004-2019  Iban Cereijo.
+ * Copyright (C) 2004-2008  Jairo Chapela.
+
+ *
+ * This file is part of lingot.
+ *
+ * lingot is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * lingot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with lingot; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LINGOT_TRACKER_H
+#define LINGOT_TRACKER_H
+
+/*
+ Narrowband frequency tracker.
+
+ Once the core has locked a frequency, the tracker follows it by heterodyning
+ the signal to complex baseband at the locked frequency, decimating it heavily
+ and measuring the phase advance of the narrowband stream. The stream is kept
+ between passes, so each pass only processes the samples received since the
+ previous one, with a few multiply-adds per sample, instead of a full FFT and
+ the Newton-Raphson passes over the temporal window.
+ */
+
+#include <stddef.h>
+
+#include "lingot-defs.h"
+#include "lingot-arena.h"
+#include "lingot-complex.h"
+
+typedef struct {
+
+    int active; // tells whether the tracker is following a frequency.
+
+    FLT w; // tracked frequency, in rads per sample.
+    FLT coherence; // in [0, 1], close to 1 for a stable sinusoid.
+
+    unsigned int n; // length of the analysed signal, in samples.
+    unsigned int decimation; // narrowband decimation factor.
+
+    // narrowband stream, heterodyned at the engaged frequency w0.
+    FLT w0;
+    LingotComplex rotation; // e^{-j w0}
+    LingotComplex osc; // local oscillator at the next sample.
+    LingotComplex S0, S1; // moments of the block in progress.
+    LingotComplex S1_prev; // first order moment of the previous block.
+    unsigned int block_samples; // samples in the block in progress.
+    unsigned int blocks; // blocks completed since engaged.
+
+    // ring with the narrowband samples of the last n samples of signal.
+    LingotComplex* z;
+    unsigned int z_size;
+    unsigned int z_next;
+
+    int in_arena; // whether the buffers belong to an arena.
+
+} LingotTracker;
+
+// creates a tracker for signals of n samples. The buffers are taken from the
+// given arena, or allocated if it is NULL.
+void lingot_tracker_new(LingotTracker*, unsigned int n, LingotArena* arena);
+void lingot_tracker_destroy(LingotTracker*);
+
+// arena space taken by a tracker for signals of n samples.
+size_t lingot_tracker_arena_size(unsigned int n);
+
+void lingot_tracker_reset(LingotTracker*);
+
+// starts following the frequency w (in rads per sample), with a narrowband
+// stream derived from the last n samples of the signal, of which the last
+// n_samples have not been given to the tracker yet. If the tracker is already
+// following a frequency close enough, its stream is kept and only the new
+// samples are appended.
+void lingot_tracker_engage(LingotTracker*, FLT w, const FLT* in, unsigned int n_samples);
+
+// appends the given new samples to the narrowband stream and refines the
+// tracked frequency. It returns 0 and deactivates the tracker if the lock is
+// lost.
+int lingot_tracker_track(LingotTracker*, const FLT* in, unsigned int n_samples);
+
+#endif /*LINGOT_TRACKER_H*/
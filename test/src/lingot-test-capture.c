@@ -0,0 +1,318 @@
+/*
+ * lingot, a musical instrument tuner.
+ *
+ * Copyright (C) 2013  Iban Cereijo
+ *
+ * This file is part of lingot.
+ *
+ * lingot is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * lingot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with lingot; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glob.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "lingot-test.h"
+
+#include "lingot-ring.h"
+#include "lingot-capture.h"
+#include "lingot-telemetry.h"
+
+#define LINGOT_TEST_RING_RECORDS 100000
+
+static void* lingot_test_ring_consumer(void* arg) {
+    LingotRing* ring = arg;
+    unsigned int expected = 0;
+    unsigned int type;
+    unsigned int data[8];
+    int length;
+    long errors = 0;
+
+    while (expected < LINGOT_TEST_RING_RECORDS) {
+        length = lingot_ring_read(ring, &type, data, sizeof(data));
+        if (length < 0) {
+            sched_yield();
+            continue;
+        }
+        // every record carries its number in all its words
+        if ((type != expected % 3)
+                || (length != (int) ((1 + expected % 8) * sizeof(unsigned int)))
+                || (data[length / sizeof(unsigned int) - 1] != expected)) {
+            errors++;
+        }
+        expected++;
+    }
+
+    return (void*) errors;
+}
+
+void lingot_test_capture(void) {
+
+    LingotRing ring;
+    unsigned int type;
+    unsigned int data[8];
+    unsigned int i, j;
+
+    // sequential use, with wrap around and drops
+
+    CU_ASSERT(lingot_ring_new(&ring, 100));
+    CU_ASSERT_EQUAL(ring.size, 128);
+    CU_ASSERT_EQUAL(lingot_ring_read(&ring, &type, data, sizeof(data)), -1);
+
+    for (i = 0; i < 10; i++) {
+        data[0] = i;
+        // 8 header bytes and 8 data bytes per record
+        CU_ASSERT_EQUAL(lingot_ring_write(&ring, 7, data, 5), i < 8);
+    }
+    CU_ASSERT_EQUAL(lingot_ring_get_dropped(&ring), 2);
+
+    for (i = 0; i < 100; i++) {
+        CU_ASSERT_EQUAL(lingot_ring_read(&ring, &type, data, sizeof(data)), 5);
+        CU_ASSERT_EQUAL(type, 7);
+        CU_ASSERT_EQUAL(data[0], i);
+        data[0] = i + 8;
+        CU_ASSERT(lingot_ring_write(&ring, 7, data, 5));
+    }
+    CU_ASSERT_EQUAL(lingot_ring_get_dropped(&ring), 2);
+
+    // a record longer than the ring never fits
+    CU_ASSERT_FALSE(lingot_ring_write(&ring, 0, data, 200));
+    lingot_ring_destroy(&ring);
+
+    // concurrent producer and consumer
+
+    pthread_t consumer;
+    void* errors;
+    CU_ASSERT(lingot_ring_new(&ring, 256));
+    pthread_create(&consumer, NULL, lingot_test_ring_consumer, &ring);
+    for (i = 0; i < LINGOT_TEST_RING_RECORDS; i++) {
+        for (j = 0; j < 8; j++) {
+            data[j] = i;
+        }
+        while (!lingot_ring_write(&ring, i % 3, data,
+                                  (1 + i % 8) * sizeof(unsigned int))) {
+            sched_yield();
+        }
+    }
+    pthread_join(consumer, &errors);
+    CU_ASSERT_EQUAL((long) errors, 0);
+    lingot_ring_destroy(&ring);
+
+    // capture files
+
+    char directory[] = "/tmp/lingot-test-capture-XXXXXX";
+    char prefix[100];
+    FLT samples[441];
+    LingotCaptureFrame frame;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(directory));
+    snprintf(prefix, sizeof(prefix), "%s/capture", directory);
+
+    LingotCapture* capture = lingot_capture_new(prefix, 44100, 21, 441);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(capture);
+
+    for (i = 0; i < 441; i++) {
+        samples[i] = 16384.0;
+    }
+    for (i = 0; i < 10; i++) {
+        lingot_capture_push_raw(capture, samples, 441);
+        lingot_capture_push_decimated(capture, samples, 21);
+        frame.sample_position = 21 * (i + 1);
+        frame.frequency = 440.0;
+        frame.sequence = i + 1;
+        frame.signal_present = 1;
+        lingot_capture_push_frame(capture, &frame);
+    }
+    lingot_capture_destroy(capture);
+
+    glob_t files;
+    char pattern[200];
+    snprintf(pattern, sizeof(pattern), "%s/capture-*", directory);
+    CU_ASSERT_EQUAL_FATAL(glob(pattern, 0, NULL, &files), 0);
+    CU_ASSERT_EQUAL_FATAL(files.gl_pathc, 3);
+
+    // sorted names: decimated.wav, frames.bin, raw.wav
+    unsigned char header[44];
+    FILE* fp = fopen(files.gl_pathv[0], "rb");
+    CU_ASSERT_EQUAL(fread(header, 1, 44, fp), 44);
+    CU_ASSERT(!memcmp(header, "RIFF", 4) && !memcmp(header + 8, "WAVEfmt ", 8));
+    CU_ASSERT_EQUAL(header[20], 3); // float
+    CU_ASSERT_EQUAL(header[24] | (header[25] << 8), 2100);
+    CU_ASSERT_EQUAL(header[40] | (header[41] << 8), 4 * 210);
+    float value;
+    CU_ASSERT_EQUAL(fread(&value, sizeof(value), 1, fp), 1);
+    CU_ASSERT_EQUAL(value, 0.5f);
+    fclose(fp);
+
+    LingotCaptureFrameLogHeader log_header;
+    fp = fopen(files.gl_pathv[1], "rb");
+    CU_ASSERT_EQUAL(fread(&log_header, sizeof(log_header), 1, fp), 1);
+    CU_ASSERT(!memcmp(log_header.magic, "LNGTFRM1", 8));
+    CU_ASSERT_EQUAL(log_header.sample_rate, 2100.0);
+    CU_ASSERT_EQUAL(log_header.frame_size, sizeof(LingotCaptureFrame));
+    for (i = 0; i < 10; i++) {
+        CU_ASSERT_EQUAL(fread(&frame, sizeof(frame), 1, fp), 1);
+        CU_ASSERT_EQUAL(frame.sequence, i + 1);
+        CU_ASSERT_EQUAL(frame.sample_position, 21 * (i + 1));
+    }
+    CU_ASSERT_EQUAL(fread(&frame, sizeof(frame), 1, fp), 0);
+    fclose(fp);
+
+    fp = fopen(files.gl_pathv[2], "rb");
+    CU_ASSERT_EQUAL(fread(header, 1, 44, fp), 44);
+    CU_ASSERT_EQUAL(header[24] | (header[25] << 8), 44100);
+    CU_ASSERT_EQUAL(header[40] | (header[41] << 8) | (header[42] << 16), 4 * 4410);
+    CU_ASSERT_EQUAL(header[4] | (header[5] << 8) | (header[6] << 16), 36 + 4 * 4410);
+    fseek(fp, 0, SEEK_END);
+    CU_ASSERT_EQUAL(ftell(fp), 44 + 4 * 4410);
+    fclose(fp);
+
+    for (i = 0; i < files.gl_pathc; i++) {
+        remove(files.gl_pathv[i]);
+    }
+    globfree(&files);
+
+    // captures started within the same second do not overwrite each other.
+    LingotCapture* first = lingot_capture_new(prefix, 44100, 21, 441);
+    LingotCapture* second = lingot_capture_new(prefix, 44100, 21, 441);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(first);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(second);
+    lingot_capture_push_raw(first, samples, 441);
+    lingot_capture_destroy(first);
+    lingot_capture_destroy(second);
+
+    CU_ASSERT_EQUAL_FATAL(glob(pattern, 0, NULL, &files), 0);
+    CU_ASSERT_EQUAL(files.gl_pathc, 6);
+    unsigned long written = 0;
+    for (i = 0; i < files.gl_pathc; i++) {
+        fp = fopen(files.gl_pathv[i], "rb");
+        fseek(fp, 0, SEEK_END);
+        written += (strstr(files.gl_pathv[i], "raw.wav") && (ftell(fp) > 44));
+        fclose(fp);
+        remove(files.gl_pathv[i]);
+    }
+    CU_ASSERT_EQUAL(written, 1);
+    globfree(&files);
+
+    remove(directory);
+}
+
+static int lingot_test_telemetry_connect(const char* path) {
+    struct sockaddr_un address;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    snprintf(address.sun_path, sizeof(address.sun_path), "%s", path);
+    if (connect(fd, (struct sockaddr*) &address, sizeof(address))) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+// reads exactly the given number of bytes.
+static int lingot_test_telemetry_read(int fd, void* data, size_t length) {
+    size_t done = 0;
+    while (done < length) {
+        ssize_t r = read(fd, (char*) data + done, length - done);
+        if (r <= 0) {
+            return 0;
+        }
+        done += r;
+    }
+    return 1;
+}
+
+// waits until the server has accepted the given number of clients.
+static void lingot_test_telemetry_wait_clients(LingotTelemetry* telemetry,
+                                               unsigned int n) {
+    unsigned int i, k, connected = 0;
+    for (k = 0; (k < 1000) && (connected < n); k++) {
+        usleep(1000);
+        connected = 0;
+        for (i = 0; i < LINGOT_TELEMETRY_MAX_CLIENTS; i++) {
+            connected += (__atomic_load_n(&telemetry->clients[i].fd,
+                                          __ATOMIC_RELAXED) >= 0);
+        }
+    }
+}
+
+void lingot_test_telemetry(void) {
+
+    char path[100];
+    LingotTelemetryRecord record;
+    unsigned int i;
+
+    CU_ASSERT_EQUAL(sizeof(LingotTelemetryRecord), 40);
+
+    snprintf(path, sizeof(path), "/tmp/lingot-test-telemetry-%d.sock", (int) getpid());
+    LingotTelemetry* telemetry = lingot_telemetry_new(path);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(telemetry);
+
+    int fast = lingot_test_telemetry_connect(path);
+    int slow = lingot_test_telemetry_connect(path);
+    CU_ASSERT(fast >= 0);
+    CU_ASSERT(slow >= 0);
+    lingot_test_telemetry_wait_clients(telemetry, 2);
+
+    // the slow client does not read anything, which must not delay the
+    // analysis thread nor the other client.
+    const unsigned int batches = 250;
+    const unsigned int batch_size = 200; // they fit in the ring
+    unsigned int batch;
+    long errors = 0;
+    for (batch = 0; batch < batches; batch++) {
+        for (i = 0; i < batch_size; i++) {
+            memset(&record, 0, sizeof(record));
+            record.sequence = batch * batch_size + i;
+            record.frequency = 440.0;
+            record.flags = LINGOT_TELEMETRY_FLAG_PITCH;
+            lingot_telemetry_push(telemetry, &record);
+        }
+        for (i = 0; i < batch_size; i++) {
+            if (!lingot_test_telemetry_read(fast, &record, sizeof(record))) {
+                errors++;
+                break;
+            }
+            errors += (record.sequence != batch * batch_size + i);
+        }
+    }
+
+    CU_ASSERT_EQUAL(errors, 0);
+    CU_ASSERT_EQUAL(lingot_ring_get_dropped(&telemetry->ring), 0);
+    // the queue of the slow client has overflowed
+    CU_ASSERT(lingot_telemetry_get_dropped(telemetry) > 0);
+
+    // the slow client gets the latest records, in whole
+    CU_ASSERT(lingot_test_telemetry_read(slow, &record, sizeof(record)));
+    CU_ASSERT_EQUAL(record.frequency, 440.0);
+
+    // a disconnected client frees its slot
+    close(slow);
+    lingot_telemetry_push(telemetry, &record);
+    CU_ASSERT(lingot_test_telemetry_read(fast, &record, sizeof(record)));
+
+    close(fast);
+    lingot_telemetry_destroy(telemetry);
+    CU_ASSERT_EQUAL(access(path, F_OK), -1);
+}
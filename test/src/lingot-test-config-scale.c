@@ -20,10 +20,19 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
 #include "lingot-test.h"
 
 #include "lingot-config-scale.h"
 #include "lingot-config.h"
+#include "lingot-io-config-scale.h"
+#include "lingot-io-scale-library.h"
 
 void lingot_test_config_scale(void) {
 
@@ -79,6 +88,199 @@ void lingot_test_config_scale(void) {
     closest_note_index = lingot_config_scale_get_closest_note_index(scale,
                                                                     130.82, 0.0, &error_cents);
     CU_ASSERT_EQUAL(closest_note_index, -12);
+    closest_note_index = lingot_config_scale_get_closest_note_index(scale,
+                                                                    261.625565 * pow(2.0, 1149.0 / 1200.0), 0.0, &error_cents);
+    CU_ASSERT_EQUAL(closest_note_index, 11);
+    CU_ASSERT(fabs(error_cents - 49.0) < 1e-6);
+    closest_note_index = lingot_config_scale_get_closest_note_index(scale,
+                                                                    261.625565 * pow(2.0, 1151.0 / 1200.0), 0.0, &error_cents);
+    CU_ASSERT_EQUAL(closest_note_index, 12);
+    CU_ASSERT(fabs(error_cents + 49.0) < 1e-6);
+    CU_ASSERT(fabs(lingot_config_scale_get_frequency(scale, 9) - 440.0) < 1e-3);
+    CU_ASSERT(fabs(lingot_config_scale_get_frequency(scale, -3) - 220.0) < 1e-3);
+
+    // large microtonal scale: 4000 equal divisions of the octave, with the
+    // first note out of 0 cents
+    const int notes = 4000;
+    const FLT step = 1200.0 / notes;
+    int i;
+    lingot_config_scale_destroy(scale);
+    scale->name = strdup("4000-EDO");
+    scale->base_frequency = 100.0;
+    lingot_config_scale_allocate(scale, notes);
+    for (i = 0; i < notes; i++) {
+        scale->note_name[i] = strdup("x");
+        scale->offset_cents[i] = 0.25 + i * step;
+        scale->offset_ratios[0][i] = -1;
+        scale->offset_ratios[1][i] = -1;
+    }
+    lingot_config_scale_update_index(scale);
+
+    int index;
+    for (index = -2 * notes - 7; index < 2 * notes + 7; index += 37) {
+        FLT cents = 0.25 + index * step;
+        FLT freq = 100.0 * pow(2.0, (cents + 0.1 * step) / 1200.0);
+        CU_ASSERT(fabs(lingot_config_scale_get_frequency(scale, index)
+                       - 100.0 * pow(2.0, cents / 1200.0)) < 1e-9 * freq);
+        closest_note_index = lingot_config_scale_get_closest_note_index(scale,
+                                                                        freq, 0.0, &error_cents);
+        CU_ASSERT_EQUAL(closest_note_index, index);
+        CU_ASSERT(fabs(error_cents - 0.1 * step) < 1e-6);
+        freq = 100.0 * pow(2.0, (cents - 0.4 * step) / 1200.0);
+        closest_note_index = lingot_config_scale_get_closest_note_index(scale,
+                                                                        freq, 0.0, &error_cents);
+        CU_ASSERT_EQUAL(closest_note_index, index);
+    }
+
+    // right below the first note, the closest one is the last note of the
+    // previous octave
+    closest_note_index = lingot_config_scale_get_closest_note_index(scale,
+                                                                    100.0, 0.0, &error_cents);
+    CU_ASSERT_EQUAL(closest_note_index, -1);
+    CU_ASSERT(fabs(error_cents - (step - 0.25)) < 1e-6);
+
+    // shifts, as ratios or cents, with trailing comments.
+    double shift;
+    short int numerator, denominator;
+    char shift_text[100];
+    sprintf(shift_text, "%s", "3/2");
+    CU_ASSERT(lingot_config_scale_parse_shift(shift_text, &shift, &numerator, &denominator));
+    CU_ASSERT(fabs(shift - 701.955) < 1e-3);
+    CU_ASSERT_EQUAL(numerator, 3);
+    CU_ASSERT_EQUAL(denominator, 2);
+    sprintf(shift_text, "%s", " 701.955 ! close to 3/2");
+    CU_ASSERT(lingot_config_scale_parse_shift(shift_text, &shift, &numerator, &denominator));
+    CU_ASSERT(fabs(shift - 701.955) < 1e-9);
+    CU_ASSERT_EQUAL(numerator, -1);
+    // too large to be kept as a ratio
+    sprintf(shift_text, "%s", "531441/524288");
+    CU_ASSERT(lingot_config_scale_parse_shift(shift_text, &shift, &numerator, &denominator));
+    CU_ASSERT(fabs(shift - 23.46) < 1e-2);
+    CU_ASSERT_EQUAL(numerator, -1);
+    sprintf(shift_text, "%s", "x/2");
+    CU_ASSERT_FALSE(lingot_config_scale_parse_shift(shift_text, &shift, NULL, NULL));
 
     lingot_config_destroy(config);
 }
+
+static void lingot_test_write_file(const char* filename, const char* contents) {
+    FILE* fp = fopen(filename, "w");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fp);
+    fputs(contents, fp);
+    fclose(fp);
+}
+
+void lingot_test_scale_library(void) {
+
+    char directory[] = "/tmp/lingot-test-scales-XXXXXX";
+    char filename[200];
+    char index_filename[200];
+    unsigned int results[10];
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(directory));
+
+    snprintf(filename, sizeof(filename), "%s/sub", directory);
+    CU_ASSERT_EQUAL(mkdir(filename, 0700), 0);
+
+    snprintf(filename, sizeof(filename), "%s/pyth.scl", directory);
+    lingot_test_write_file(filename, "! pyth.scl\n!\nPythagorean pentatonic\n 5\n!\n"
+                           " 9/8\n 81/64\n 3/2\n 27/16\n 2/1\n");
+    snprintf(filename, sizeof(filename), "%s/sub/edo5.SCL", directory);
+    lingot_test_write_file(filename, "5 equal divisions\n5\n240.\n480.0\n720.0 ! comment\n"
+                           "960.0\n2\n");
+    snprintf(filename, sizeof(filename), "%s/sub/broken.scl", directory);
+    lingot_test_write_file(filename, "! broken.scl\nUnordered\n3\n300.0\n200.0\n2/1\n");
+    snprintf(filename, sizeof(filename), "%s/sub/notes.txt", directory);
+    lingot_test_write_file(filename, "not a scale\n");
+
+    LingotScaleLibrary library;
+    lingot_scale_library_new(&library);
+
+    CU_ASSERT_EQUAL(lingot_scale_library_scan(&library, directory), 2);
+    // sorted by path
+    CU_ASSERT_STRING_EQUAL(library.entries[0].name, "Pythagorean pentatonic");
+    CU_ASSERT_STRING_EQUAL(library.entries[1].name, "5 equal divisions");
+    CU_ASSERT_EQUAL(library.entries[0].notes, 5);
+    CU_ASSERT_EQUAL(library.entries[1].notes, 5);
+    unsigned int hash = library.entries[0].hash;
+
+    // rescanning keeps the unchanged entries
+    CU_ASSERT_EQUAL(lingot_scale_library_scan(&library, directory), 2);
+    CU_ASSERT_EQUAL(library.entries[0].hash, hash);
+
+    snprintf(index_filename, sizeof(index_filename), "%s/%s", directory,
+             SCALE_LIBRARY_INDEX_FILE_NAME);
+    CU_ASSERT(lingot_scale_library_save_index(&library, index_filename));
+    lingot_scale_library_destroy(&library);
+    CU_ASSERT_EQUAL(library.n_entries, 0);
+
+    CU_ASSERT(lingot_scale_library_load_index(&library, index_filename));
+    CU_ASSERT_EQUAL(library.n_entries, 2);
+    CU_ASSERT_STRING_EQUAL(library.directory, directory);
+    CU_ASSERT_EQUAL(library.entries[0].hash, hash);
+    CU_ASSERT_EQUAL(library.entries[1].notes, 5);
+
+    // search on the name and the file name, ignoring case
+    CU_ASSERT_EQUAL(lingot_scale_library_search(&library, "PENTA", results, 10), 1);
+    CU_ASSERT_EQUAL(results[0], 0);
+    CU_ASSERT_EQUAL(lingot_scale_library_search(&library, "edo5", results, 10), 1);
+    CU_ASSERT_EQUAL(results[0], 1);
+    CU_ASSERT_EQUAL(lingot_scale_library_search(&library, "", results, 10), 2);
+    CU_ASSERT_EQUAL(lingot_scale_library_search(&library, "", results, 1), 1);
+    CU_ASSERT_EQUAL(lingot_scale_library_search(&library, "bohlen", results, 10), 0);
+
+    // the scale is only parsed when it is selected
+    LingotScale scale;
+    lingot_config_scale_new(&scale);
+    CU_ASSERT(lingot_scale_library_load_scale(&library, 0, &scale));
+    CU_ASSERT_STRING_EQUAL(scale.name, "Pythagorean pentatonic");
+    CU_ASSERT_EQUAL(scale.notes, 5);
+    CU_ASSERT_EQUAL(scale.offset_ratios[0][1], 9);
+    CU_ASSERT_EQUAL(scale.offset_ratios[1][1], 8);
+    CU_ASSERT_STRING_EQUAL(scale.note_name[4], "5");
+    CU_ASSERT(fabs(scale.offset_cents[3] - 701.955) < 1e-3);
+    FLT error_cents;
+    CU_ASSERT_EQUAL(lingot_config_scale_get_closest_note_index(&scale,
+                    lingot_config_scale_get_frequency(&scale, 3), 0.0, &error_cents), 3);
+    CU_ASSERT(lingot_scale_library_load_scale(&library, 1, &scale));
+    CU_ASSERT_EQUAL(scale.offset_ratios[0][1], -1);
+    CU_ASSERT_EQUAL(scale.offset_cents[4], 960.0);
+    CU_ASSERT_FALSE(lingot_scale_library_load_scale(&library, 2, &scale));
+    CU_ASSERT_STRING_EQUAL(scale.name, "5 equal divisions");
+
+    // a file modified after the indexing is not loaded until the library is
+    // scanned again, which leaves the previous library untouched.
+    snprintf(filename, sizeof(filename), "%s/sub/edo5.SCL", directory);
+    lingot_test_write_file(filename, "5 equal divisions\n5\n240.\n480.0\n720.0\n"
+                           "961.5\n2\n");
+    CU_ASSERT_FALSE(lingot_scale_library_load_scale(&library, 1, &scale));
+    LingotScaleLibrary rescanned;
+    lingot_scale_library_new(&rescanned);
+    CU_ASSERT_EQUAL(lingot_scale_library_scan_from(&rescanned, &library, directory), 2);
+    CU_ASSERT_EQUAL(rescanned.entries[0].hash, hash);
+    CU_ASSERT_NOT_EQUAL(rescanned.entries[1].hash, library.entries[1].hash);
+    CU_ASSERT(lingot_scale_library_load_scale(&rescanned, 1, &scale));
+    CU_ASSERT_EQUAL(scale.offset_cents[4], 961.5);
+    lingot_scale_library_destroy(&rescanned);
+    lingot_config_scale_destroy(&scale);
+
+    // indexes of other versions are ignored.
+    lingot_test_write_file(index_filename, "# lingot scale library index\n");
+    CU_ASSERT_FALSE(lingot_scale_library_load_index(&library, index_filename));
+    CU_ASSERT_EQUAL(library.n_entries, 2);
+
+    lingot_scale_library_destroy(&library);
+
+    remove(index_filename);
+    snprintf(filename, sizeof(filename), "%s/pyth.scl", directory);
+    remove(filename);
+    const char* names[] = { "edo5.SCL", "broken.scl", "notes.txt" };
+    unsigned int i;
+    for (i = 0; i < 3; i++) {
+        snprintf(filename, sizeof(filename), "%s/sub/%s", directory, names[i]);
+        remove(filename);
+    }
+    snprintf(filename, sizeof(filename), "%s/sub", directory);
+    rmdir(filename);
+    rmdir(directory);
+}
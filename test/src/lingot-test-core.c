@@ -21,6 +21,9 @@
  */
 
 #include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
 
 #include "lingot-test.h"
 
@@ -32,6 +35,61 @@
 #include "lingot-fft.h"
 
 #include "lingot-core.h"
+#include "lingot-calibration.h"
+
+// results of the passes run in virtual time.
+typedef struct {
+    unsigned int passes;
+    unsigned int max_passes;
+    FLT* freq;
+    FLT* SPL; // max_passes rows of spd_size values
+    unsigned int spd_size;
+    int* signal_present;
+    const LingotCore* core;
+} LingotTestCoreFrames;
+
+static void lingot_test_core_frame_callback(const LingotCoreSnapshot* snapshot,
+                                            void* arg) {
+    LingotTestCoreFrames* frames = arg;
+    if (frames->passes < frames->max_passes) {
+        frames->freq[frames->passes] = snapshot->freq;
+        memcpy(&frames->SPL[frames->passes * frames->spd_size], snapshot->SPL,
+               frames->spd_size * sizeof(FLT));
+        frames->signal_present[frames->passes] = frames->core->signal_present;
+    }
+    frames->passes++;
+}
+
+// runs the offline core in virtual time, with a pass every given period of
+// decimated samples, feeding the signal in blocks of pseudo-random sizes up
+// to the given maximum.
+static void lingot_test_core_run_virtual_time(LingotConfig* conf, const FLT* signal,
+                                              unsigned int n, unsigned int period,
+                                              unsigned int max_block, unsigned int seed,
+                                              LingotTestCoreFrames* frames) {
+    LingotCore core;
+    unsigned int position = 0;
+    unsigned int passes = 0;
+
+    lingot_core_offline_new(&core, conf, 1024);
+    lingot_core_offline_set_analysis_period(&core, period);
+    frames->core = &core;
+    while (position < n) {
+        seed = seed * 1103515245u + 12345u;
+        unsigned int m = 1 + (seed >> 16) % max_block;
+        if (m > n - position) {
+            m = n - position;
+        }
+        passes += lingot_core_offline_process(&core, &signal[position], m,
+                                              lingot_test_core_frame_callback, frames);
+        position += m;
+    }
+    CU_ASSERT_EQUAL(passes, frames->passes);
+    // the choice of the spectrum updates does not depend on the timing.
+    CU_ASSERT_EQUAL(core.sliding_dft.fft_time, 0.0);
+    CU_ASSERT_EQUAL(core.sliding_dft.update_time, 0.0);
+    lingot_core_offline_destroy(&core);
+}
 
 void lingot_test_core(void) {
 
@@ -69,4 +127,340 @@ void lingot_test_core(void) {
     CU_ASSERT_EQUAL(rel, 1);
     CU_ASSERT_EQUAL(multiplier1, 0.5);
     CU_ASSERT_EQUAL(multiplier2, 1.0);
+
+    // offline core on a synthetic tone
+
+    LingotConfig conf;
+    LingotCore core;
+    unsigned int i, j;
+    const FLT f = 196.0; // G3
+    const unsigned int block_size = 2048;
+    FLT* block = malloc(block_size * sizeof(FLT));
+    FLT phase = 0.0;
+
+    lingot_config_new(&conf);
+    lingot_config_restore_default_values(&conf);
+    lingot_config_update_internal_params(&conf);
+
+    lingot_core_offline_new(&core, &conf, block_size);
+
+    // the analysis buffers fill their arena exactly, each one on its own
+    // cache lines.
+    CU_ASSERT_EQUAL(core.arena.used, core.arena.size);
+    CU_ASSERT_EQUAL((size_t) core.temporal_buffer % LINGOT_CACHE_LINE_SIZE, 0);
+    CU_ASSERT_EQUAL((size_t) core.windowed_fft_buffer % LINGOT_CACHE_LINE_SIZE, 0);
+    CU_ASSERT_EQUAL((size_t) core.fftplan.fft_out % LINGOT_CACHE_LINE_SIZE, 0);
+    CU_ASSERT_EQUAL((size_t) core.antialiasing_filter.s % LINGOT_CACHE_LINE_SIZE, 0);
+    CU_ASSERT_EQUAL((size_t) core.snapshot[2].SPL % LINGOT_CACHE_LINE_SIZE, 0);
+    CU_ASSERT_EQUAL((size_t) &core.snapshot_middle % LINGOT_CACHE_LINE_SIZE, 0);
+    CU_ASSERT((char*) &core.snapshot_sequence - (char*) &core.snapshot_middle
+              >= LINGOT_CACHE_LINE_SIZE);
+
+    for (j = 0; j < 20; j++) {
+        for (i = 0; i < block_size; i++) {
+            block[i] = 1e4 * (0.5 * cos(phase) + 0.2 * cos(2.0 * phase));
+            phase += 2.0 * M_PI * f / conf.sample_rate;
+        }
+        lingot_core_offline_feed(&core, block, block_size);
+        lingot_core_offline_compute(&core);
+    }
+    CU_ASSERT(fabs(1200.0 * log2(core.freq / f)) < 1.0);
+    CU_ASSERT(core.signal_present);
+
+    // the strobe stage follows the closest note.
+    LingotStrobeReadout strobe;
+    lingot_core_get_strobe(&core, &strobe);
+    CU_ASSERT(fabs(strobe.frequency - 196.0) < 0.01);
+    CU_ASSERT_EQUAL(strobe.n_harmonics, conf.strobe_harmonics);
+
+    // the published results match the last pass, and stay the same until a
+    // new pass is published.
+    const LingotCoreSnapshot* snapshot = lingot_core_get_snapshot(&core);
+    CU_ASSERT_EQUAL(snapshot->sequence, 20);
+    CU_ASSERT_EQUAL(snapshot->freq, core.freq);
+    CU_ASSERT_EQUAL(snapshot->spd_size, conf.fft_size / 2);
+    CU_ASSERT(snapshot->first_bin > 0);
+    CU_ASSERT(snapshot->first_bin < snapshot->last_bin);
+    CU_ASSERT(snapshot->last_bin <= snapshot->spd_size);
+    CU_ASSERT(!memcmp(snapshot->SPL, core.SPL, snapshot->spd_size * sizeof(FLT)));
+    CU_ASSERT_EQUAL(lingot_core_get_snapshot(&core), snapshot);
+    lingot_core_offline_compute(&core);
+    snapshot = lingot_core_get_snapshot(&core);
+    CU_ASSERT_EQUAL(snapshot->sequence, 21);
+
+    // every pass is also queued for the reader, up to the ring capacity.
+    FLT* pass_SPL = malloc(snapshot->spd_size * sizeof(FLT));
+    j = 0;
+    while (lingot_core_get_pass_spectrum(&core, pass_SPL, snapshot->spd_size)) {
+        j++;
+    }
+    CU_ASSERT(j >= 16);
+    CU_ASSERT(j <= 21);
+    lingot_core_offline_compute(&core);
+    lingot_core_offline_compute(&core);
+    CU_ASSERT(lingot_core_get_pass_spectrum(&core, pass_SPL, snapshot->spd_size));
+    CU_ASSERT(lingot_core_get_pass_spectrum(&core, pass_SPL, snapshot->spd_size));
+    CU_ASSERT(!memcmp(pass_SPL, core.SPL, snapshot->spd_size * sizeof(FLT)));
+    CU_ASSERT(!lingot_core_get_pass_spectrum(&core, pass_SPL, snapshot->spd_size));
+    free(pass_SPL);
+
+    // silence gate: closes after the hangover, opens within a block.
+    memset(block, 0, block_size * sizeof(FLT));
+    lingot_core_offline_feed(&core, block, block_size);
+    CU_ASSERT(core.signal_present);
+    for (j = 0; j < 20; j++) {
+        lingot_core_offline_feed(&core, block, block_size);
+    }
+    CU_ASSERT(!core.signal_present);
+    for (i = 0; i < block_size; i++) {
+        block[i] = 100.0 * cos(phase);
+        phase += 2.0 * M_PI * f / conf.sample_rate;
+    }
+    lingot_core_offline_feed(&core, block, block_size);
+    CU_ASSERT(core.signal_present);
+    lingot_core_offline_destroy(&core);
+
+    // the gate does not depend on how the input is split in blocks, also
+    // when the silence starts within a block.
+    {
+        LingotCore cores[2];
+        const unsigned int step = 1001; // 143 blocks of 7 samples
+        const unsigned int n = 40 * step;
+        FLT* signal = malloc(n * sizeof(FLT));
+        int differences = 0;
+        int closed = 0;
+        for (i = 0; i < n; i++) {
+            signal[i] = (i < 10 * step + 500) ? 1e4 * cos(phase) : 0.0;
+            phase += 2.0 * M_PI * f / conf.sample_rate;
+        }
+
+        lingot_core_offline_new(&cores[0], &conf, step);
+        lingot_core_offline_new(&cores[1], &conf, step);
+        for (i = 0; i < n; i += step) {
+            lingot_core_offline_feed(&cores[0], &signal[i], step);
+            for (j = 0; j < step; j += 7) {
+                lingot_core_offline_feed(&cores[1], &signal[i + j], 7);
+            }
+            differences += (cores[0].signal_present != cores[1].signal_present);
+            closed += !cores[0].signal_present;
+        }
+        CU_ASSERT_EQUAL(differences, 0);
+        CU_ASSERT(closed > 0);
+        lingot_core_offline_destroy(&cores[0]);
+        lingot_core_offline_destroy(&cores[1]);
+        free(signal);
+    }
+
+    // virtual time: identical input gives identical frames, regardless of
+    // how it is split in blocks, also when the silence gate closes during a
+    // silent stretch, and when the spectrum is updated incrementally with
+    // short periods.
+    {
+        const unsigned int n = 3 * conf.sample_rate;
+        FLT* signal = malloc(n * sizeof(FLT));
+        unsigned int seed = 1;
+        unsigned int incremental;
+        for (i = 0; i < n; i++) {
+            seed = seed * 1103515245u + 12345u;
+            const FLT glide = f * (1.0 + 0.05 * i / n);
+            signal[i] = 1e4 * (0.5 * cos(phase) + 0.2 * cos(2.0 * phase))
+                    + 100.0 * ((seed >> 16) % 1000 - 500.0) / 500.0;
+            phase += 2.0 * M_PI * glide / conf.sample_rate;
+        }
+        memset(&signal[n / 3], 0, (n / 3) * sizeof(FLT));
+
+        for (incremental = 0; incremental <= 1; incremental++) {
+            const unsigned int period = incremental ? 10 : 100;
+            LingotConfig incremental_conf;
+            lingot_config_copy(&incremental_conf, &conf);
+            incremental_conf.incremental_spectrum = incremental;
+
+            if (incremental) {
+                // the passes are close enough to slide the DFT.
+                LingotSlidingDFT sdft;
+                lingot_fft_sliding_create(&sdft, conf.fft_size, NULL);
+                CU_ASSERT(lingot_fft_sliding_is_worth(&sdft, period, 8 * conf.fft_size));
+                lingot_fft_sliding_destroy(&sdft);
+            }
+
+            LingotTestCoreFrames frames[3];
+            const unsigned int max_passes = n / (period * conf.oversampling);
+            for (j = 0; j < 3; j++) {
+                frames[j].passes = 0;
+                frames[j].max_passes = max_passes;
+                frames[j].spd_size = conf.fft_size / 2;
+                frames[j].freq = malloc(max_passes * sizeof(FLT));
+                frames[j].SPL = malloc(max_passes * frames[j].spd_size * sizeof(FLT));
+                frames[j].signal_present = malloc(max_passes * sizeof(int));
+            }
+
+            lingot_test_core_run_virtual_time(&incremental_conf, signal, n, period,
+                                              1024, 7, &frames[0]);
+            lingot_test_core_run_virtual_time(&incremental_conf, signal, n, period,
+                                              1024, 7, &frames[1]);
+            lingot_test_core_run_virtual_time(&incremental_conf, signal, n, period,
+                                              37, 11, &frames[2]);
+
+            // one pass every period of decimated samples
+            CU_ASSERT_EQUAL(frames[0].passes, max_passes);
+            for (j = 1; j < 3; j++) {
+                CU_ASSERT_EQUAL(frames[j].passes, frames[0].passes);
+                CU_ASSERT(!memcmp(frames[j].freq, frames[0].freq, max_passes * sizeof(FLT)));
+                CU_ASSERT(!memcmp(frames[j].SPL, frames[0].SPL,
+                                  max_passes * frames[0].spd_size * sizeof(FLT)));
+                CU_ASSERT(!memcmp(frames[j].signal_present, frames[0].signal_present,
+                                  max_passes * sizeof(int)));
+            }
+            CU_ASSERT(frames[0].signal_present[0]);
+            CU_ASSERT(!frames[0].signal_present[max_passes / 2]);
+            CU_ASSERT(frames[0].signal_present[max_passes - 1]);
+            CU_ASSERT(fabs(1200.0 * log2(frames[0].freq[max_passes - 1] / (1.05 * f))) < 5.0);
+
+            for (j = 0; j < 3; j++) {
+                free(frames[j].freq);
+                free(frames[j].SPL);
+                free(frames[j].signal_present);
+            }
+            lingot_config_destroy(&incremental_conf);
+        }
+        free(signal);
+    }
+
+    // narrowband tracking: once locked, the tracker follows the note with
+    // the samples received in each pass.
+    {
+        LingotConfig tracking_conf;
+        lingot_config_copy(&tracking_conf, &conf);
+        tracking_conf.narrowband_tracking = 1;
+
+        const unsigned int n = 2 * conf.sample_rate;
+        FLT* signal = malloc(n * sizeof(FLT));
+        for (i = 0; i < n; i++) {
+            signal[i] = 1e4 * (0.5 * cos(phase) + 0.2 * cos(2.0 * phase));
+            phase += 2.0 * M_PI * f / conf.sample_rate;
+        }
+
+        lingot_core_offline_new(&core, &tracking_conf, 1024);
+        lingot_core_offline_process(&core, signal, n, NULL, NULL);
+        CU_ASSERT(core.tracker.active);
+        CU_ASSERT_EQUAL(core.tracker_samples_count, core.decimated_samples_count);
+        CU_ASSERT(fabs(1200.0 * log2(core.freq / f)) < 1.0);
+        lingot_core_offline_destroy(&core);
+
+        lingot_config_destroy(&tracking_conf);
+        free(signal);
+    }
+
+    // polyphony: the notes of a chord are found and locked separately.
+    {
+        const FLT chord[3] = { 110.0, 146.832, 196.0 }; // A2, D3, G3
+        const unsigned int n = conf.sample_rate;
+        FLT* signal = malloc(n * sizeof(FLT));
+        FLT phases[3] = { 0.0, 0.0, 0.0 };
+        for (i = 0; i < n; i++) {
+            signal[i] = 0.0;
+            for (j = 0; j < 3; j++) {
+                signal[i] += 4e3 * (0.5 * cos(phases[j]) + 0.2 * cos(2.0 * phases[j]));
+                phases[j] += 2.0 * M_PI * chord[j] / conf.sample_rate;
+            }
+        }
+
+        conf.polyphony = 3;
+        lingot_core_offline_new(&core, &conf, 1024);
+        lingot_core_offline_process(&core, signal, n, NULL, NULL);
+        snapshot = lingot_core_get_snapshot(&core);
+        CU_ASSERT_EQUAL(snapshot->n_voices, 3);
+        CU_ASSERT_EQUAL(snapshot->voice_freq[0], snapshot->freq);
+        for (j = 0; j < 3; j++) {
+            unsigned int found = 0;
+            for (i = 0; i < snapshot->n_voices; i++) {
+                if (fabs(1200.0 * log2(snapshot->voice_freq[i] / chord[j])) < 5.0) {
+                    found++;
+                }
+            }
+            CU_ASSERT_EQUAL(found, 1);
+        }
+        lingot_core_offline_destroy(&core);
+
+        // a single note gives a single voice.
+        for (i = 0; i < n; i++) {
+            signal[i] = 1e4 * (0.5 * cos(phase) + 0.2 * cos(2.0 * phase));
+            phase += 2.0 * M_PI * f / conf.sample_rate;
+        }
+        lingot_core_offline_new(&core, &conf, 1024);
+        lingot_core_offline_process(&core, signal, n, NULL, NULL);
+        snapshot = lingot_core_get_snapshot(&core);
+        CU_ASSERT_EQUAL(snapshot->n_voices, 1);
+        CU_ASSERT(fabs(1200.0 * log2(snapshot->freq / f)) < 1.0);
+        lingot_core_offline_destroy(&core);
+
+        conf.polyphony = 1;
+        free(signal);
+    }
+
+    // large FFT for low notes: A0 over a wide band, without a long temporal
+    // window. The default parameters are still suggested for the default
+    // range.
+    {
+        LingotConfig low_conf;
+        lingot_config_new(&low_conf);
+        lingot_config_restore_default_values(&low_conf);
+        low_conf.optimize_internal_parameters = 1;
+        lingot_config_update_internal_params(&low_conf);
+        CU_ASSERT_EQUAL(low_conf.fft_size, 512);
+
+        low_conf.min_frequency = 25.0;
+        low_conf.max_frequency = 4000.0;
+        low_conf.optimize_internal_parameters = 1;
+        lingot_config_update_internal_params(&low_conf);
+        CU_ASSERT(low_conf.fft_size > 4096);
+        CU_ASSERT(low_conf.fft_size <= LINGOT_CONFIG_MAX_FFT_SIZE);
+        CU_ASSERT_EQUAL(lingot_config_get_min_fft_size(&low_conf),
+                        low_conf.fft_size);
+        CU_ASSERT(low_conf.temporal_window < 1.0);
+
+        const FLT f_low = 27.5; // A0
+        const unsigned int n = 2 * low_conf.sample_rate;
+        FLT* signal = malloc(n * sizeof(FLT));
+        for (i = 0; i < n; i++) {
+            const FLT t = 2.0 * M_PI * f_low * i / low_conf.sample_rate;
+            signal[i] = 1e4 * (0.3 * cos(t) + 0.5 * cos(2.0 * t)
+                               + 0.3 * cos(3.0 * t));
+        }
+        lingot_core_offline_new(&core, &low_conf, 1024);
+        lingot_core_offline_process(&core, signal, n, NULL, NULL);
+        snapshot = lingot_core_get_snapshot(&core);
+        CU_ASSERT(fabs(1200.0 * log2(snapshot->freq / f_low)) < 1.0);
+        lingot_core_offline_destroy(&core);
+
+        free(signal);
+        lingot_config_destroy(&low_conf);
+    }
+
+    // calibration with a generous budget, and then cached.
+    conf.calibration_budget = 1000.0;
+    conf.optimize_internal_parameters = 1;
+    CU_ASSERT(lingot_calibration_is_due(&conf));
+    LingotConfig calibrated;
+    lingot_config_copy(&calibrated, &conf);
+    CU_ASSERT(lingot_calibration_run(&calibrated));
+    CU_ASSERT(strcmp(calibrated.calibration_id, "none"));
+    CU_ASSERT(calibrated.temporal_buffer_size >= calibrated.fft_size);
+    CU_ASSERT(calibrated.optimize_internal_parameters);
+    CU_ASSERT(!lingot_calibration_is_due(&calibrated));
+    CU_ASSERT(!lingot_calibration_run(&calibrated));
+
+    // the result is applied as long as the settings are the same.
+    conf.max_frequency *= 2.0;
+    CU_ASSERT(!lingot_calibration_apply(&conf, &calibrated));
+    conf.max_frequency = calibrated.max_frequency;
+    CU_ASSERT(lingot_calibration_apply(&conf, &calibrated));
+    CU_ASSERT_EQUAL(conf.fft_size, calibrated.fft_size);
+    CU_ASSERT_EQUAL(conf.oversampling, calibrated.oversampling);
+    CU_ASSERT(!lingot_calibration_is_due(&conf));
+    CU_ASSERT(!lingot_calibration_apply(&conf, &calibrated));
+    lingot_config_destroy(&calibrated);
+
+    lingot_config_destroy(&conf);
+    free(block);
 }
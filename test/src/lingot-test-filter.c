@@ -0,0 +1,197 @@
+/*
+ * lingot, a musical instrument tuner.
+ *
+ * Copyright (C) 2004-2019  Iban Cereijo.
+ * Copyright (C) 2004-2008  Jairo Chapela.
+
+ *
+ * This file is part of lingot.
+ *
+ * lingot is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * lingot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with lingot; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "lingot-test.h"
+#include "lingot-filter.h"
+#include "lingot-gauge.h"
+
+// reference Direct Form II implementation, with per sample status shifting.
+static void lingot_test_filter_reference(const LingotFilter* filter,
+                                         FLT* s, unsigned int n,
+                                         const FLT* in, FLT* out) {
+    FLT w, y;
+    unsigned int i;
+    int j;
+
+    for (i = 0; i < n; i++) {
+
+        w = in[i];
+        y = 0.0;
+
+        for (j = filter->N - 1; j >= 0; j--) {
+            w -= filter->a[j + 1] * s[j];
+            y += filter->b[j + 1] * s[j];
+            s[j + 1] = s[j];
+        }
+
+        y += w * filter->b[0];
+        s[0] = w;
+
+        out[i] = y;
+    }
+}
+
+// compares the filter against the reference implementation.
+static FLT lingot_test_filter_compare(LingotFilter* filter, unsigned int n,
+                                      const FLT* in) {
+    unsigned int i;
+    FLT max_error = 0.0;
+    FLT* out1 = malloc(n * sizeof(FLT));
+    FLT* out2 = malloc(n * sizeof(FLT));
+    FLT* s = calloc(filter->N + 1, sizeof(FLT));
+
+    lingot_filter_reset(filter);
+    lingot_test_filter_reference(filter, s, n, in, out1);
+    // first sample by sample, then the rest as a block.
+    for (i = 0; i < 10; i++) {
+        out2[i] = lingot_filter_filter_sample(filter, in[i]);
+    }
+    lingot_filter_filter(filter, n - 10, &in[10], &out2[10]);
+
+    for (i = 0; i < n; i++) {
+        max_error = fmax(max_error, fabs(out1[i] - out2[i]));
+    }
+
+    free(out1);
+    free(out2);
+    free(s);
+    return max_error;
+}
+
+void lingot_test_filter(void) {
+
+    unsigned int i;
+    const unsigned int n = 2048;
+    FLT* in = malloc(n * sizeof(FLT));
+    FLT* out1 = malloc(n * sizeof(FLT));
+    FLT* out2 = malloc(n * sizeof(FLT));
+
+    for (i = 0; i < n; i++) {
+        in[i] = cos(0.01 * i) + 0.5 * sin(1.7 * i) + (1.0 * rand()) / RAND_MAX;
+    }
+
+    // the cascade of sections must match the direct form where the latter is
+    // accurate.
+    LingotFilter filter;
+    LingotFilterSOS sos;
+    lingot_filter_cheby_design(&filter, 8, 0.5, 0.9 / 4);
+    lingot_filter_cheby_design_sos(&sos, 8, 0.5, 0.9 / 4, NULL);
+
+    lingot_filter_filter(&filter, n, in, out1);
+    // in two blocks, to check the status keeping.
+    lingot_filter_sos_filter(&sos, n / 2, in, out2);
+    lingot_filter_sos_filter(&sos, n / 2, &in[n / 2], &out2[n / 2]);
+
+    FLT max_error = 0.0;
+    for (i = 0; i < n; i++) {
+        max_error = fmax(max_error, fabs(out1[i] - out2[i]));
+    }
+    CU_ASSERT(max_error < 1e-9);
+
+    lingot_filter_destroy(&filter);
+    lingot_filter_sos_destroy(&sos);
+
+    // odd order, in place.
+    lingot_filter_cheby_design(&filter, 5, 0.5, 0.3);
+    lingot_filter_cheby_design_sos(&sos, 5, 0.5, 0.3, NULL);
+
+    lingot_filter_filter(&filter, n, in, out1);
+    for (i = 0; i < n; i++) {
+        out2[i] = in[i];
+    }
+    lingot_filter_sos_filter(&sos, n, out2, out2);
+
+    max_error = 0.0;
+    for (i = 0; i < n; i++) {
+        max_error = fmax(max_error, fabs(out1[i] - out2[i]));
+    }
+    CU_ASSERT(max_error < 1e-9);
+
+    lingot_filter_destroy(&filter);
+    lingot_filter_sos_destroy(&sos);
+
+    // low cutoff, as with large oversampling factors: the step response must
+    // settle at the DC gain of the even order Chebyshev filter.
+    lingot_filter_cheby_design_sos(&sos, 8, 0.5, 0.9 / 120, NULL);
+    for (i = 0; i < n; i++) {
+        in[i] = 1.0;
+    }
+    for (i = 0; i < 20; i++) {
+        lingot_filter_sos_filter(&sos, n, in, out2);
+    }
+    CU_ASSERT(fabs(out2[n - 1] - pow(10.0, -0.05 * 0.5)) < 1e-6);
+    lingot_filter_sos_destroy(&sos);
+
+    // block kernels against the direct form, for the specialized orders and
+    // a generic one.
+    for (i = 0; i < n; i++) {
+        in[i] = cos(0.01 * i) + 0.5 * sin(1.7 * i) + (1.0 * rand()) / RAND_MAX;
+    }
+
+    const FLT a1[] = { 1.0, 0.1 - 1.0 };
+    const FLT b1[] = { 0.1 };
+    lingot_filter_new(&filter, 1, 0, a1, b1);
+    CU_ASSERT(lingot_test_filter_compare(&filter, n, in) < 1e-12);
+    lingot_filter_destroy(&filter);
+
+    const FLT a2[] = { 60 + 60 * (6 + 60), -60 * (6 + 2.0 * 60), 60 * 60 };
+    const FLT b2[] = { 60 };
+    lingot_filter_new(&filter, 2, 0, a2, b2);
+    CU_ASSERT(lingot_test_filter_compare(&filter, n, in) < 1e-12);
+    lingot_filter_destroy(&filter);
+
+    lingot_filter_cheby_design(&filter, 8, 0.5, 0.9 / 4);
+    CU_ASSERT(lingot_test_filter_compare(&filter, n, in) < 1e-9);
+    lingot_filter_destroy(&filter);
+
+    lingot_filter_cheby_design(&filter, 3, 0.5, 0.5);
+    CU_ASSERT(lingot_test_filter_compare(&filter, n, in) < 1e-9);
+    lingot_filter_destroy(&filter);
+
+    // the gauge motion must not depend on how the elapsed time is split
+    // between frames.
+    LingotGauge gauge1;
+    LingotGauge gauge2;
+    lingot_gauge_new(&gauge1, -20.0);
+    lingot_gauge_new(&gauge2, -20.0);
+    for (i = 0; i < 120; i++) {
+        lingot_gauge_compute(&gauge1, 15.0);
+    }
+    int steps = 0;
+    for (i = 0; i < 144; i++) {
+        steps += lingot_gauge_advance(&gauge2, 15.0, 1.0 / 72);
+    }
+    CU_ASSERT_EQUAL(steps, 120);
+    CU_ASSERT(fabs(gauge1.position - gauge2.position) < 1e-9);
+    CU_ASSERT(fabs(gauge2.position - 15.0) < 2.0);
+    lingot_gauge_destroy(&gauge1);
+    lingot_gauge_destroy(&gauge2);
+
+    free(in);
+    free(out1);
+    free(out2);
+}
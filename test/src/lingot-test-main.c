@@ -22,11 +22,23 @@
 
 void lingot_test_io_config(void);
 void lingot_test_config_scale(void);
+void lingot_test_scale_library(void);
 void lingot_test_signal(void);
 void lingot_test_core(void);
+void lingot_test_filter(void);
+void lingot_test_msg(void);
+void lingot_test_capture(void);
+void lingot_test_telemetry(void);
+void lingot_test_thread(void);
 
 #ifndef LINGOT_TEST_USE_LIB
 
+// the modules are built here as a single unit, and lingot-thread.c needs the
+// GNU CPU affinity extension before any system header.
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+
 // TODO: lib?
 #include "lingot-complex.c"
 #include "lingot-msg.c"
@@ -34,15 +46,25 @@ void lingot_test_core(void);
 #include "lingot-config.c"
 #include "lingot-io-config.c"
 #include "lingot-io-config-scale.c"
+#include "lingot-io-scale-library.c"
 #include "lingot-audio.c"
 #include "lingot-audio-alsa.c"
 #include "lingot-audio-oss.c"
 #include "lingot-audio-jack.c"
 #include "lingot-audio-pulseaudio.c"
+#include "lingot-arena.c"
 #include "lingot-fft.c"
 #include "lingot-core.c"
 #include "lingot-signal.c"
 #include "lingot-filter.c"
+#include "lingot-gauge.c"
+#include "lingot-tracker.c"
+#include "lingot-strobe.c"
+#include "lingot-thread.c"
+#include "lingot-calibration.c"
+#include "lingot-ring.c"
+#include "lingot-capture.c"
+#include "lingot-telemetry.c"
 
 #else
 
@@ -90,8 +112,14 @@ int main(void) {
     if ( //
          (NULL == CU_add_test(pSuite, "lingot_config", lingot_test_io_config)) || //
          (NULL == CU_add_test(pSuite, "lingot_config_scale", lingot_test_config_scale)) || //
+         (NULL == CU_add_test(pSuite, "lingot_scale_library", lingot_test_scale_library)) || //
          (NULL == CU_add_test(pSuite, "lingot_signal", lingot_test_signal)) || //
          (NULL == CU_add_test(pSuite, "lingot_core", lingot_test_core)) || //
+         (NULL == CU_add_test(pSuite, "lingot_filter", lingot_test_filter)) || //
+         (NULL == CU_add_test(pSuite, "lingot_msg", lingot_test_msg)) || //
+         (NULL == CU_add_test(pSuite, "lingot_capture", lingot_test_capture)) || //
+         (NULL == CU_add_test(pSuite, "lingot_telemetry", lingot_test_telemetry)) || //
+         (NULL == CU_add_test(pSuite, "lingot_thread", lingot_test_thread)) || //
          0) {
         CU_cleanup_registry();
         return CU_get_error();
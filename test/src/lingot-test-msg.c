@@ -0,0 +1,131 @@
+/*
+ * lingot, a musical instrument tuner.
+ *
+ * Copyright (C) 2013  Iban Cereijo
+ *
+ * This file is part of lingot.
+ *
+ * lingot is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * lingot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with lingot; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "lingot-test.h"
+
+#include "lingot-msg.h"
+
+#define LINGOT_TEST_MSG_PRODUCERS 4
+#define LINGOT_TEST_MSG_PER_PRODUCER 2000
+
+static int finished_producers = 0;
+
+static void* lingot_test_msg_producer(void* arg) {
+    const int producer = *((int*) arg);
+    char buff[100];
+    int i;
+    for (i = 0; i < LINGOT_TEST_MSG_PER_PRODUCER; i++) {
+        snprintf(buff, sizeof(buff), "message %d from producer %d", i, producer);
+        lingot_msg_add_info(buff);
+    }
+    __atomic_add_fetch(&finished_producers, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+void lingot_test_msg(void) {
+
+    LingotMessage message;
+    unsigned long dropped0, coalesced0;
+    unsigned long dropped, coalesced;
+    int i;
+
+    // the queue may hold messages from other tests.
+    while (lingot_msg_get(&message)) {
+    }
+    lingot_msg_get_counters(&dropped0, &coalesced0);
+
+    // a repeated message is coalesced while the first one is pending.
+    lingot_msg_add_info("first");
+    lingot_msg_add_info("first");
+    lingot_msg_add_error_with_code("second", 16);
+    lingot_msg_get_counters(&dropped, &coalesced);
+    CU_ASSERT_EQUAL(coalesced - coalesced0, 1);
+
+    CU_ASSERT(lingot_msg_get(&message));
+    CU_ASSERT(!strcmp(message.text, "first"));
+    CU_ASSERT_EQUAL(message.type, INFO);
+    CU_ASSERT(lingot_msg_get(&message));
+    CU_ASSERT(!strcmp(message.text, "second"));
+    CU_ASSERT_EQUAL(message.type, ERROR);
+    CU_ASSERT_EQUAL(message.error_code, 16);
+    CU_ASSERT(!lingot_msg_get(&message));
+
+    // messages with the same hash but different texts are both kept.
+    lingot_msg_add_info("note 246449");
+    lingot_msg_add_info("note 1457396");
+    CU_ASSERT(lingot_msg_get(&message));
+    CU_ASSERT(!strcmp(message.text, "note 246449"));
+    CU_ASSERT(lingot_msg_get(&message));
+    CU_ASSERT(!strcmp(message.text, "note 1457396"));
+    CU_ASSERT(!lingot_msg_get(&message));
+
+    // once consumed, it is shown again.
+    lingot_msg_add_info("second");
+    CU_ASSERT(lingot_msg_get(&message));
+    CU_ASSERT(!strcmp(message.text, "second"));
+    CU_ASSERT(!lingot_msg_get(&message));
+
+    // when full, the messages are dropped.
+    char buff[100];
+    for (i = 0; i < 40; i++) {
+        snprintf(buff, sizeof(buff), "message %d", i);
+        lingot_msg_add_warning(buff);
+    }
+    lingot_msg_get_counters(&dropped, &coalesced);
+    int received = 0;
+    while (lingot_msg_get(&message)) {
+        received++;
+    }
+    CU_ASSERT(received > 0);
+    CU_ASSERT_EQUAL(received + (dropped - dropped0), 40);
+
+    // concurrent producers: every message is either received, coalesced or
+    // dropped.
+    lingot_msg_get_counters(&dropped0, &coalesced0);
+    pthread_t threads[LINGOT_TEST_MSG_PRODUCERS];
+    int ids[LINGOT_TEST_MSG_PRODUCERS];
+    for (i = 0; i < LINGOT_TEST_MSG_PRODUCERS; i++) {
+        ids[i] = i;
+        pthread_create(&threads[i], NULL, lingot_test_msg_producer, &ids[i]);
+    }
+    received = 0;
+    while (__atomic_load_n(&finished_producers, __ATOMIC_ACQUIRE)
+           < LINGOT_TEST_MSG_PRODUCERS) {
+        while (lingot_msg_get(&message)) {
+            CU_ASSERT(!strncmp(message.text, "message ", 8));
+            received++;
+        }
+    }
+    for (i = 0; i < LINGOT_TEST_MSG_PRODUCERS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    while (lingot_msg_get(&message)) {
+        received++;
+    }
+    lingot_msg_get_counters(&dropped, &coalesced);
+    CU_ASSERT_EQUAL(received + (dropped - dropped0) + (coalesced - coalesced0),
+                    LINGOT_TEST_MSG_PRODUCERS * LINGOT_TEST_MSG_PER_PRODUCER);
+}
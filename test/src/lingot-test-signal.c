@@ -30,6 +30,9 @@
 #include "lingot-complex.h"
 #include "lingot-filter.h"
 #include "lingot-signal.h"
+#include "lingot-tracker.h"
+#include "lingot-strobe.h"
+#include "lingot-fft.h"
 
 void lingot_test_signal(void) {
 
@@ -44,7 +47,7 @@ void lingot_test_signal(void) {
         noise[i] = -1.0;
     }
 
-    lingot_signal_compute_noise_level(spd, N, n, noise);
+    lingot_signal_compute_noise_level(spd, N, n, 10.0, noise);
 
     // TODO: enable logic
 
@@ -132,7 +135,7 @@ void lingot_test_signal(void) {
     }
 
     tic();
-    lingot_signal_compute_noise_level(spd, N, n, noise);
+    lingot_signal_compute_noise_level(spd, N, n, 10.0, noise);
     toc();
 
     //	printf("N = [");
@@ -143,10 +146,211 @@ void lingot_test_signal(void) {
 
     tic();
     for (i = 0; i < 10000; i++) {
-        lingot_signal_compute_noise_level(spd, N, n, noise);
+        lingot_signal_compute_noise_level(spd, N, n, 10.0, noise);
     }
     toc();
 
     free(spd);
     free(noise);
+
+    // narrowband tracker
+
+    N = 4096;
+    FLT* x = malloc(3 * N * sizeof(FLT));
+    const FLT w0 = 0.2;
+    for (i = 0; i < 2 * N; i++) {
+        x[i] = 0.8 * cos(w0 * i + 0.3);
+    }
+
+    LingotTracker tracker;
+    lingot_tracker_new(&tracker, N, NULL);
+    lingot_tracker_engage(&tracker, w0 * 1.01, x, N);
+    CU_ASSERT(tracker.active);
+    CU_ASSERT(lingot_tracker_track(&tracker, &x[N], 0));
+    CU_ASSERT(fabs(tracker.w - w0) < 1e-3 * w0);
+    CU_ASSERT(tracker.coherence > 0.9);
+
+    // the stream goes on with the new samples only, and it is kept when the
+    // tracker is engaged again on a close frequency.
+    const FLT engaged_w0 = tracker.w0;
+    int tracked = 1;
+    for (i = N; i + 100 <= 2 * N; i += 100) {
+        tracked &= lingot_tracker_track(&tracker, &x[i], 100);
+        tracked &= (fabs(tracker.w - w0) < 1e-3 * w0);
+    }
+    CU_ASSERT(tracked);
+    lingot_tracker_engage(&tracker, w0, &x[i - N], 0);
+    CU_ASSERT(tracker.active);
+    CU_ASSERT_EQUAL(tracker.w0, engaged_w0);
+
+    // the tone goes away by more than the tracker can follow.
+    for (; i < 3 * N; i++) {
+        x[i] = 0.8 * cos(1.5 * w0 * i);
+    }
+    CU_ASSERT(!lingot_tracker_track(&tracker, &x[2 * N], N));
+    CU_ASSERT(!tracker.active);
+
+    lingot_tracker_destroy(&tracker);
+    free(x);
+
+    // strobe stage: the phases stand still in tune, and drift h times the
+    // detuning otherwise.
+
+    {
+        const FLT fs = 2100.0;
+        const FLT f_ref = 110.0;
+        const unsigned int block = 64;
+        const unsigned int blocks = 0.1 * fs / block;
+        FLT block_samples[block];
+        FLT phase = 0.0;
+        LingotStrobe strobe;
+        LingotStrobeReadout before, after;
+        unsigned int b, h;
+
+        lingot_strobe_new(&strobe, 6, fs);
+        lingot_strobe_read(&strobe, &before);
+        CU_ASSERT_EQUAL(before.n_harmonics, 0);
+
+        lingot_strobe_set_frequency(&strobe, f_ref);
+        // all of them are below 0.45 fs.
+        CU_ASSERT_EQUAL(strobe.n_harmonics, 6);
+
+        for (b = 0; b < 600; b++) {
+            const FLT f = (b < 300) ? f_ref : f_ref + 0.5;
+            for (i = 0; i < (int) block; i++) {
+                block_samples[i] = 1000.0 * (cos(phase) + 0.5 * cos(2.0 * phase));
+                phase += 2.0 * M_PI * f / fs;
+            }
+            lingot_strobe_process(&strobe, block_samples, block);
+
+            if ((b == 300 - blocks - 1) || (b == 600 - blocks - 1)) {
+                lingot_strobe_read(&strobe, &before);
+            } else if ((b == 299) || (b == 599)) {
+                lingot_strobe_read(&strobe, &after);
+                CU_ASSERT_EQUAL(after.n_harmonics, 6);
+                CU_ASSERT_EQUAL(after.frequency, f_ref);
+                CU_ASSERT(fabs(after.magnitude[0] - 1000.0) < 50.0);
+                CU_ASSERT(fabs(after.magnitude[1] - 500.0) < 25.0);
+                CU_ASSERT(after.magnitude[2] < 10.0);
+                const FLT detuning = (b < 300) ? 0.0 : 0.5;
+                for (h = 0; h < 2; h++) {
+                    const FLT drift = remainder(after.phase[h] - before.phase[h],
+                                                2.0 * M_PI);
+                    const FLT expected = 2.0 * M_PI * (h + 1) * detuning
+                            * blocks * block / fs;
+                    CU_ASSERT(fabs(drift - expected) < 0.01);
+                }
+            }
+        }
+
+        // the harmonics above 0.45 fs are left out.
+        lingot_strobe_set_frequency(&strobe, 300.0);
+        CU_ASSERT_EQUAL(strobe.n_harmonics, 3);
+    }
+
+    // sliding DFT against FFT
+
+    N = 256;
+    const unsigned int hop = 5;
+    x = malloc((N + hop) * sizeof(FLT));
+    FLT* fft_in = malloc(N * sizeof(FLT));
+    for (i = 0; i < N + (int) hop; i++) {
+        x[i] = cos(0.37 * i) + 0.25 * sin(1.3 * i) + (1.0 * rand()) / RAND_MAX;
+    }
+
+    LingotFFTPlan plan;
+    LingotSlidingDFT sdft;
+    lingot_fft_plan_create(&plan, fft_in, N, NULL);
+    lingot_fft_sliding_create(&sdft, N, NULL);
+
+    // before measuring, sliding pays off for a few samples only.
+    CU_ASSERT(lingot_fft_sliding_is_worth(&sdft, hop, 8 * N));
+    CU_ASSERT(!lingot_fft_sliding_is_worth(&sdft, 64, 8 * N));
+    CU_ASSERT(!lingot_fft_sliding_is_worth(&sdft, N + 1, 8 * N));
+
+    memcpy(fft_in, x, N * sizeof(FLT));
+    lingot_fft_sliding_resync_dft(&sdft, &plan);
+    CU_ASSERT(sdft.synced);
+    lingot_fft_sliding_update(&sdft, &x[N], hop);
+
+    memcpy(fft_in, &x[hop], N * sizeof(FLT));
+    lingot_fft_compute_dft(&plan);
+
+    FLT max_error = 0.0;
+    for (i = 0; i <= N / 2; i++) {
+        max_error = fmax(max_error, fabs(sdft.X[i][0] - plan.fft_out[i][0]));
+        max_error = fmax(max_error, fabs(sdft.X[i][1] - plan.fft_out[i][1]));
+    }
+    CU_ASSERT(max_error < 1e-9);
+
+    // frequency domain windowing against time domain periodic windowing.
+    LingotComplex* windowed = malloc((N / 2 + 1) * sizeof(LingotComplex));
+    lingot_fft_sliding_window(&sdft, HANNING, windowed);
+    for (i = 0; i < N; i++) {
+        fft_in[i] = x[hop + i] * 0.5 * (1.0 - cos(2.0 * M_PI * i / N));
+    }
+    lingot_fft_compute_dft(&plan);
+
+    max_error = 0.0;
+    for (i = 0; i <= N / 2; i++) {
+        max_error = fmax(max_error, fabs(windowed[i][0] - plan.fft_out[i][0]));
+        max_error = fmax(max_error, fabs(windowed[i][1] - plan.fft_out[i][1]));
+    }
+    CU_ASSERT(max_error < 1e-9);
+
+    free(windowed);
+    lingot_fft_sliding_destroy(&sdft);
+    lingot_fft_plan_destroy(&plan);
+    free(fft_in);
+    free(x);
+
+    // windowing on the fly against a stored window, over several recurrence
+    // blocks.
+
+    N = 5000;
+    x = malloc(N * sizeof(FLT));
+    FLT* stored = malloc(N * sizeof(FLT));
+    lingot_signal_window(N, stored, HAMMING);
+    for (i = 0; i < N; i++) {
+        x[i] = cos(0.21 * i + 0.4) + 0.1 * (1.0 * rand()) / RAND_MAX;
+        stored[i] *= x[i];
+    }
+
+    FLT d_stored[3];
+    FLT d_fused[3];
+    lingot_fft_spd_diffs_eval(stored, N, 0.2101, &d_stored[0], &d_stored[1],
+                              &d_stored[2]);
+    lingot_fft_spd_diffs_eval_windowed(x, HAMMING, N, 0.2101, &d_fused[0],
+                                       &d_fused[1], &d_fused[2]);
+    for (i = 0; i < 3; i++) {
+        CU_ASSERT(fabs(d_fused[i] - d_stored[i]) < 1e-9 * fabs(d_stored[i]));
+    }
+
+    free(stored);
+    free(x);
+
+    // phase vocoder refinement
+
+    N = 512;
+    x = malloc(2 * N * sizeof(FLT));
+    FLT* window = malloc(N * sizeof(FLT));
+    lingot_signal_window(N, window, HAMMING);
+
+    const FLT w1 = 2.0 * M_PI * 37.3 / N;
+    for (i = 0; i < 2 * N; i++) {
+        x[i] = cos(w1 * i + 1.1) + 0.3 * cos(2.0 * w1 * i);
+    }
+
+    LingotComplex X0;
+    LingotComplex X1;
+    lingot_fft_dft_bin(x, window, N, 37, X0);
+    lingot_fft_dft_bin(&x[N], window, N, 37, X1);
+
+    // initial estimation 0.4 bins away.
+    FLT w_pv = lingot_signal_phase_vocoder_frequency(X0, X1,
+                                                     2.0 * M_PI * 37.7 / N, N);
+    CU_ASSERT(fabs(w_pv - w1) < 1e-4 * w1); // well below one cent
+
+    free(window);
+    free(x);
 }
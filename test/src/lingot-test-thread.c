@@ -0,0 +1,145 @@
+/*
+ * lingot, a musical instrument tuner.
+ *
+ * Copyright (C) 2013  Iban Cereijo
+ *
+ * This file is part of lingot.
+ *
+ * lingot is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * lingot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with lingot; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// CPU affinity is a GNU extension.
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "lingot-test.h"
+
+#include "lingot-msg.h"
+#include "lingot-thread.h"
+
+static pthread_mutex_t lingot_test_thread_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void* lingot_test_thread_wait(void* arg) {
+    (void) arg;
+    pthread_mutex_lock(&lingot_test_thread_mutex);
+    pthread_mutex_unlock(&lingot_test_thread_mutex);
+    return NULL;
+}
+
+// drains the message queue, it returns the number of messages of the given
+// type, and copies the last one.
+static int lingot_test_thread_messages(message_type_t type, LingotMessage* last) {
+    LingotMessage message;
+    int result = 0;
+    while (lingot_msg_get(&message)) {
+        if (message.type == type) {
+            *last = message;
+            result++;
+        }
+    }
+    return result;
+}
+
+void lingot_test_thread(void) {
+
+    unsigned char cpus[16];
+    LingotThreadSettings settings;
+    LingotMessage message;
+    char description[200];
+    char cpu[16];
+    pthread_t thread;
+    cpu_set_t set;
+    int i;
+
+    // CPU lists
+    CU_ASSERT_EQUAL(lingot_thread_parse_cpu_list("0", cpus, 16), 1);
+    CU_ASSERT(cpus[0] && !cpus[1]);
+    CU_ASSERT_EQUAL(lingot_thread_parse_cpu_list("0, 2-4,3", cpus, 16), 4);
+    CU_ASSERT(cpus[0] && !cpus[1] && cpus[2] && cpus[3] && cpus[4] && !cpus[5]);
+    CU_ASSERT_EQUAL(lingot_thread_parse_cpu_list("", cpus, 16), -1);
+    CU_ASSERT_EQUAL(lingot_thread_parse_cpu_list("none", cpus, 16), -1);
+    CU_ASSERT_EQUAL(lingot_thread_parse_cpu_list("3-1", cpus, 16), -1);
+    CU_ASSERT_EQUAL(lingot_thread_parse_cpu_list("1,", cpus, 16), -1);
+    CU_ASSERT_EQUAL(lingot_thread_parse_cpu_list("16", cpus, 16), -1);
+
+    // comparison, the priority only matters with realtime policies.
+    LingotThreadSettings settings2;
+    lingot_thread_settings_default(&settings);
+    lingot_thread_settings_default(&settings2);
+    settings2.priority = 20;
+    CU_ASSERT(lingot_thread_settings_equal(&settings, &settings2));
+    settings.policy = settings2.policy = LINGOT_THREAD_POLICY_RR;
+    CU_ASSERT(!lingot_thread_settings_equal(&settings, &settings2));
+    settings.priority = 20;
+    CU_ASSERT(lingot_thread_settings_equal(&settings, &settings2));
+    sprintf(settings2.affinity, "%s", "1");
+    CU_ASSERT(!lingot_thread_settings_equal(&settings, &settings2));
+
+    pthread_mutex_lock(&lingot_test_thread_mutex);
+    pthread_create(&thread, NULL, lingot_test_thread_wait, NULL);
+    lingot_test_thread_messages(INFO, &message);
+
+    // the default settings leave the thread untouched.
+    lingot_thread_settings_default(&settings);
+    CU_ASSERT(!lingot_thread_settings_requested(&settings));
+    CU_ASSERT_EQUAL(lingot_thread_apply(thread, &settings, "test"), 0);
+    CU_ASSERT_EQUAL(lingot_test_thread_messages(INFO, &message), 0);
+
+    // the thread is pinned to one of the CPUs it is allowed to run on, and
+    // the applied affinity is reported.
+    CPU_ZERO(&set);
+    CU_ASSERT_EQUAL(pthread_getaffinity_np(thread, sizeof(set), &set), 0);
+    for (i = 0; (i < CPU_SETSIZE) && !CPU_ISSET(i, &set); i++) {
+    }
+    CU_ASSERT(i < CPU_SETSIZE);
+    sprintf(settings.affinity, "%d", i);
+    sprintf(cpu, "CPUs %d", i);
+    CU_ASSERT(lingot_thread_settings_requested(&settings));
+    CU_ASSERT_EQUAL(lingot_thread_apply(thread, &settings, "test"), 0);
+    lingot_thread_describe(thread, description, sizeof(description));
+    CU_ASSERT(strstr(description, "SCHED_OTHER") != NULL);
+    CU_ASSERT(strstr(description, cpu) != NULL);
+    CU_ASSERT_EQUAL(lingot_test_thread_messages(INFO, &message), 1);
+    CU_ASSERT(strstr(message.text, description) != NULL);
+
+    // malformed lists are reported and ignored.
+    sprintf(settings.affinity, "%s", "zero");
+    CU_ASSERT_EQUAL(lingot_thread_apply(thread, &settings, "test"), -1);
+    CU_ASSERT_EQUAL(lingot_test_thread_messages(WARNING, &message), 1);
+
+    // realtime scheduling may be refused without privileges, but the thread
+    // keeps running and the policy reported is the one in use.
+    sprintf(settings.affinity, "%s", "none");
+    settings.policy = LINGOT_THREAD_POLICY_FIFO;
+    settings.priority = 10;
+    int status = lingot_thread_apply(thread, &settings, "test");
+    lingot_thread_describe(thread, description, sizeof(description));
+    if (status == 0) {
+        CU_ASSERT(strstr(description, "SCHED_FIFO 10") != NULL);
+    } else {
+        CU_ASSERT(strstr(description, "SCHED_FIFO 10") == NULL);
+    }
+    lingot_test_thread_messages(INFO, &message);
+    CU_ASSERT(strstr(message.text, description) != NULL);
+
+    pthread_mutex_unlock(&lingot_test_thread_mutex);
+    pthread_join(thread, NULL);
+}